@@ -7,6 +7,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
 
 //GLAD
 #include <glad/glad.h>
@@ -16,6 +17,14 @@
 
 using namespace std;
 
+// Typed handles to uniform locations. Resolve them once and set values in
+// hot paths with no string hashing or driver lookup
+struct UniformInt { GLint location = -1; };
+struct UniformFloat { GLint location = -1; };
+struct UniformVec3 { GLint location = -1; };
+struct UniformVec4 { GLint location = -1; };
+struct UniformMat4 { GLint location = -1; };
+
 class Shader
 {
 public:
@@ -91,6 +100,8 @@ public:
 			glGetProgramInfoLog(this->ID, 512, NULL, infoLog);
 			std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
 		}
+		// Cache the location of every active uniform
+		this->cacheUniformLocations();
 		// Delete the shaders as they're linked into our program now and no longer necessery
 		glDeleteShader(vertex);
 		glDeleteShader(fragment);
@@ -102,34 +113,87 @@ public:
 		glUseProgram(this->ID);
 	}
 
+	// Uniform location from the cache filled after linking (-1 if not active).
+	// Names the reflection doesn't list (e.g. "lights[1]") are asked to the driver once
+	GLint getUniformLocation(const std::string& name) const
+	{
+		std::unordered_map<std::string, GLint>::const_iterator it = this->uniformLocations.find(name);
+		if (it != this->uniformLocations.end())
+			return it->second;
+		GLint location = glGetUniformLocation(this->ID, name.c_str());
+		this->uniformLocations[name] = location;
+		return location;
+	}
+
+	UniformInt uniformInt(const std::string& name) const { UniformInt u; u.location = getUniformLocation(name); return u; }
+	UniformFloat uniformFloat(const std::string& name) const { UniformFloat u; u.location = getUniformLocation(name); return u; }
+	UniformVec3 uniformVec3(const std::string& name) const { UniformVec3 u; u.location = getUniformLocation(name); return u; }
+	UniformVec4 uniformVec4(const std::string& name) const { UniformVec4 u; u.location = getUniformLocation(name); return u; }
+	UniformMat4 uniformMat4(const std::string& name) const { UniformMat4 u; u.location = getUniformLocation(name); return u; }
+
+	// Typed handle setters (the program must be in use)
+	void set(UniformInt u, int value) const { glUniform1i(u.location, value); }
+	void set(UniformFloat u, float value) const { glUniform1f(u.location, value); }
+	void set(UniformVec3 u, float v1, float v2, float v3) const { glUniform3f(u.location, v1, v2, v3); }
+	void set(UniformVec4 u, float v1, float v2, float v3, float v4) const { glUniform4f(u.location, v1, v2, v3, v4); }
+	void set(UniformMat4 u, const float* v) const { glUniformMatrix4fv(u.location, 1, GL_FALSE, v); }
+
 	void setBool(const std::string& name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), (int)value);
+		glUniform1i(getUniformLocation(name), (int)value);
 	}
 	// ------------------------------------------------------------------------
 	void setInt(const std::string& name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), value);
+		glUniform1i(getUniformLocation(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setFloat(const std::string& name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(this->ID, name.c_str()), value);
+		glUniform1f(getUniformLocation(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setVec3(const std::string& name, float v1, float v2, float v3) const
 	{
-		glUniform3f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3);
+		glUniform3f(getUniformLocation(name), v1, v2, v3);
 	}
 
 	void setVec4(const std::string& name, float v1, float v2, float v3, float v4) const
 	{
-		glUniform4f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3,v4);
+		glUniform4f(getUniformLocation(name), v1, v2, v3,v4);
 	}
 
 	void setMat4(const std::string& name, float *v) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(this->ID, name.c_str()), 1, GL_FALSE, v);
+		glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, v);
+	}
+
+private:
+	mutable std::unordered_map<std::string, GLint> uniformLocations;
+
+	// Reflects every active uniform after linking (GL_ACTIVE_UNIFORMS).
+	// Arrays are stored both as "name" and "name[0]"
+	void cacheUniformLocations()
+	{
+		this->uniformLocations.clear();
+		GLint count = 0, maxLength = 0;
+		glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+		std::string name(maxLength > 0 ? maxLength : 1, '\0');
+		for (GLint i = 0; i < count; i++)
+		{
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(this->ID, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, &name[0]);
+			std::string uniformName = name.substr(0, length);
+			GLint location = glGetUniformLocation(this->ID, uniformName.c_str());
+			if (location < 0)
+				continue; // uniforms inside uniform blocks have no location
+			this->uniformLocations[uniformName] = location;
+			if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+				this->uniformLocations[uniformName.substr(0, uniformName.size() - 3)] = location;
+		}
 	}
 };
 
@@ -0,0 +1,205 @@
+#include "AsyncLoader.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+
+//GLM
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace std;
+
+void widenIndices(PreparedGeometry& prepared)
+{
+	MeshBuffers& buffers = prepared.buffers;
+	if (buffers.indexType != GL_UNSIGNED_SHORT)
+		return;
+	const uint16_t* indices = (const uint16_t*)buffers.indices;
+	prepared.wideIndices.assign(indices, indices + buffers.indexCount);
+	buffers.indices = prepared.wideIndices.data();
+	buffers.indexBytes = prepared.wideIndices.size() * sizeof(uint32_t);
+	buffers.indexType = GL_UNSIGNED_INT;
+}
+
+shared_ptr<Geometry> createGeometry(PreparedGeometry& prepared, GeometryPool* pool)
+{
+	const MeshBuffers& buffers = prepared.buffers;
+	shared_ptr<Geometry> geometry = make_shared<Geometry>();
+	geometry->nIndices = buffers.indexCount;
+	geometry->nVertices = buffers.vertexCount;
+	geometry->indexType = buffers.indexType;
+	geometry->lods = buffers.lods;
+	geometry->meshlets = buffers.meshlets;
+	geometry->packedVertices = buffers.packed;
+	geometry->positionDecode = glm::scale(glm::translate(glm::mat4(1.0f), buffers.positionOffset), buffers.positionScale);
+	geometry->bounds = prepared.bounds;
+	geometry->triangles = move(prepared.triangles);
+
+	//No pool a geometria só recebe seu trecho das arenas, que já têm VAO e layout
+	if (pool != nullptr && pool->allocate(*geometry, buffers))
+		return geometry;
+
+	//Geração do identificador do VBO
+	glGenBuffers(1, &geometry->VBO);
+
+	//Faz a conexão (vincula) do buffer como um buffer de array
+	glBindBuffer(GL_ARRAY_BUFFER, geometry->VBO);
+
+	//Reserva o espaço do buffer na OpenGL; os dados vêm depois, em pedaços (uploadGeometry)
+	glBufferData(GL_ARRAY_BUFFER, buffers.vertexBytes, nullptr, GL_STATIC_DRAW);
+
+	//Geração do identificador do VAO (Vertex Array Object)
+	glGenVertexArrays(1, &geometry->VAO);
+
+	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
+	// e os ponteiros para os atributos
+	glBindVertexArray(geometry->VAO);
+
+	//Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando:
+	// Localização no shader * (a localização dos atributos devem ser correspondentes no layout especificado no vertex shader)
+	// Numero de valores que o atributo tem (por ex, 3 coordenadas xyz)
+	// Tipo do dado
+	// Se está normalizado (entre zero e um)
+	// Tamanho em bytes
+	// Deslocamento a partir do byte zero
+
+	//O layout (posição, cor, coordenada de textura e normal) vem junto com os buffers
+	for (const VertexAttribute& attribute : buffers.attributes)
+	{
+		glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized, buffers.stride, (GLvoid*)(size_t)attribute.offset);
+		glEnableVertexAttribArray(attribute.location);
+	}
+
+	//Buffer de índices (EBO): fica registrado no VAO, por isso é vinculado com o VAO ativo
+	glGenBuffers(1, &geometry->EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBytes, nullptr, GL_STATIC_DRAW);
+
+
+	// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice
+	// atualmente vinculado - para que depois possamos desvincular com segurança
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// Desvincula o VAO (é uma boa prática desvincular qualquer buffer ou array para evitar bugs medonhos)
+	glBindVertexArray(0);
+
+	return geometry;
+}
+
+bool uploadGeometry(const PreparedGeometry& prepared, const Geometry& geometry, size_t& offset, size_t maxBytes, UploadRing* ring)
+{
+	const MeshBuffers& buffers = prepared.buffers;
+	size_t total = buffers.vertexBytes + buffers.indexBytes;
+	while (offset < total && maxBytes > 0)
+	{
+		//GL_COPY_WRITE_BUFFER não faz parte do estado do VAO: o EBO pode ser vinculado sem
+		//alterar o VAO ativo
+		bool vertices = offset < buffers.vertexBytes;
+		size_t start = vertices ? offset : offset - buffers.vertexBytes;
+		size_t size = min(maxBytes, (vertices ? buffers.vertexBytes : buffers.indexBytes) - start);
+		const char* source = (const char*)(vertices ? buffers.vertices : buffers.indices);
+		GLuint destination = vertices ? geometry.VBO : geometry.EBO;
+		//Numa arena do GeometryPool a geometria começa em baseVertex/firstIndex
+		size_t base = vertices ? (size_t)geometry.baseVertex * buffers.stride : (size_t)geometry.indexOffset();
+
+		if (ring != nullptr)
+		{
+			UploadRing::Allocation allocation;
+			size = min(size, ring->available(sizeof(uint32_t)));
+			if (!ring->reserve(size, sizeof(uint32_t), allocation))
+				break;
+			memcpy(allocation.data, source + start, size);
+			ring->commit(allocation);
+			ring->copy(allocation, destination, base + start);
+		}
+		else
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, destination);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, base + start, size, source + start);
+		}
+		offset += size;
+		maxBytes -= size;
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	return offset == total;
+}
+
+AsyncLoader::AsyncLoader(int nThreads, size_t queueCapacity)
+	: queue(queueCapacity), nThreads(nThreads)
+{
+}
+
+AsyncLoader::~AsyncLoader()
+{
+	stop();
+}
+
+void AsyncLoader::start(vector<unique_ptr<PreparedGeometry> > requests, const Prepare& prepare)
+{
+	if (!pool)
+		pool.reset(new ThreadPool(nThreads));
+	totalCount += (int)requests.size();
+	for (unique_ptr<PreparedGeometry>& request : requests)
+	{
+		//std::function precisa ser copiável: a tarefa recebe o ponteiro e volta a ser a dona dele
+		PreparedGeometry* raw = request.release();
+		pool->submit([this, raw, prepare] {
+			unique_ptr<PreparedGeometry> prepared(raw);
+			//Carga cancelada (stop): não vale a pena ler o arquivo
+			if (queue.isClosed())
+				return;
+			{
+				PROFILE_ZONE("prepare model");
+				prepared->loaded = prepare(*prepared);
+			}
+			queue.push(move(prepared));
+		});
+	}
+}
+
+void AsyncLoader::stop()
+{
+	queue.close();
+	pool.reset();
+	current.reset();
+	currentGeometry.reset();
+}
+
+void AsyncLoader::upload(double budgetMs, const Ready& ready, UploadRing* ring, GeometryPool* pool)
+{
+	PROFILE_ZONE("async upload");
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	bool first = true;
+	while (first || chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() < budgetMs)
+	{
+		if (!current)
+		{
+			if (!queue.tryPop(current))
+				return;
+			if (!current->loaded)
+			{
+				finishedCount++;
+				current.reset();
+				continue;
+			}
+			currentGeometry = createGeometry(*current, pool);
+			currentOffset = 0;
+		}
+		first = false;
+
+		size_t before = currentOffset;
+		if (uploadGeometry(*current, *currentGeometry, currentOffset, UPLOAD_CHUNK, ring))
+		{
+			ready(*current, currentGeometry);
+			finishedCount++;
+			current.reset();
+			currentGeometry.reset();
+		}
+		else if (currentOffset == before)
+		{
+			//Região do anel cheia: o resto fica para o próximo quadro
+			return;
+		}
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Geometry.h"
+#include "MeshCache.h"
+#include "ObjLoader.h"
+#include "ThreadPool.h"
+#include "BoundedQueue.h"
+#include "UploadRing.h"
+#include "GeometryPool.h"
+#include "VertexPacking.h"
+
+// Geometria lida e processada na CPU, ainda não enviada para a GPU. buffers aponta
+// para mesh/shortIndices ou para o cache mapeado, que vivem junto com ela
+struct PreparedGeometry
+{
+	std::string filepath;
+	glm::vec3 color;
+	bool loaded = false; //false se o arquivo não pôde ser lido
+	MeshCache cache;
+	MeshData mesh;
+	std::vector<uint16_t> shortIndices;
+	std::vector<uint32_t> wideIndices; //índices de 16 bits convertidos para o GeometryPool
+	std::vector<PackedVertex> packedVertices;
+	MeshBuffers buffers;
+	Bounds bounds;
+	TriangleBVH triangles;
+	std::vector<glm::vec3> positions; //posições na cena dos modelos que usam este arquivo
+};
+
+// Converte os índices de 16 bits para 32, o único tipo aceito pelo GeometryPool
+void widenIndices(PreparedGeometry& prepared);
+
+// Cria a geometria com o espaço final, mas sem os dados, e passa para ela a caixa envolvente
+// e a BVH de triângulos. Com pool o espaço vem de uma arena (se o layout for aceito);
+// sem ele a geometria ganha VAO e buffers próprios
+std::shared_ptr<Geometry> createGeometry(PreparedGeometry& prepared, GeometryPool* pool = nullptr);
+
+// Envia até maxBytes dos dados (vértices e depois índices) a partir de offset, que avança.
+// Com ring os dados passam pelo anel e param quando a região do quadro enche.
+// Retorna true quando todos os dados já estão na GPU
+bool uploadGeometry(const PreparedGeometry& prepared, const Geometry& geometry, size_t& offset, size_t maxBytes, UploadRing* ring = nullptr);
+
+// Carga dos modelos em segundo plano. As threads do loader leem e processam os arquivos
+// (parse ou cache, caixa envolvente e BVH) e entregam o resultado numa fila limitada;
+// a thread do OpenGL chama upload() a cada quadro, que envia os dados em pedaços até
+// esgotar o tempo reservado e entrega as geometrias completas. Com a fila cheia as
+// threads esperam, o que limita a memória ocupada por geometrias ainda não enviadas
+class AsyncLoader
+{
+public:
+	typedef std::function<bool(PreparedGeometry& prepared)> Prepare;
+	typedef std::function<void(PreparedGeometry& prepared, std::shared_ptr<Geometry> geometry)> Ready;
+
+	// Bytes enviados por glBufferSubData; o tempo reservado é verificado entre os pedaços
+	static const size_t UPLOAD_CHUNK = 1 << 20;
+
+	AsyncLoader(int nThreads, size_t queueCapacity);
+	~AsyncLoader();
+	AsyncLoader(const AsyncLoader&) = delete;
+	AsyncLoader& operator=(const AsyncLoader&) = delete;
+
+	// Começa a carga; prepare roda nas threads do loader e retorna false se o arquivo não pôde ser lido
+	void start(std::vector<std::unique_ptr<PreparedGeometry> > requests, const Prepare& prepare);
+
+	// Na thread do OpenGL: envia dados por até budgetMs (ao menos um pedaço, se houver algo
+	// pronto) e chama ready para cada geometria completa, na ordem em que ficaram prontas.
+	// Com ring os pedaços passam pelo anel e o envio também para quando a região do quadro enche
+	void upload(double budgetMs, const Ready& ready, UploadRing* ring = nullptr, GeometryPool* pool = nullptr);
+
+	// Cancela o que ainda não foi lido e espera as threads terminarem; chamada também no destrutor
+	void stop();
+
+	// Todos os arquivos foram entregues (ou falharam)
+	bool finished() const { return finishedCount == totalCount; }
+	int total() const { return totalCount; }
+	int completed() const { return finishedCount; }
+
+private:
+	BoundedQueue<std::unique_ptr<PreparedGeometry> > queue;
+	std::unique_ptr<ThreadPool> pool;
+	int nThreads;
+
+	//Geometria sendo enviada (pode levar vários quadros)
+	std::unique_ptr<PreparedGeometry> current;
+	std::shared_ptr<Geometry> currentGeometry;
+	size_t currentOffset = 0;
+
+	int totalCount = 0;
+	int finishedCount = 0;
+};
@@ -0,0 +1,1423 @@
+#include "Benchmarks.h"
+#include "ObjLoader.h"
+#include "ThreadPool.h"
+#include "MeshCache.h"
+#include "Mesh.h"
+#include "InstanceRenderer.h"
+#include "TransformSystem.h"
+#include "FrustumCuller.h"
+#include "DynamicBVH.h"
+#include "TriangleBVH.h"
+#include "Profiler.h"
+#include "GLExtensions.h"
+#include "GeometryPool.h"
+#include "IndirectRenderer.h"
+#include "FrameUniforms.h"
+#include "Framebuffer.h"
+#include "SoftwareRenderer.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "VertexPacking.h"
+#include "Meshlets.h"
+
+// GLAD
+#include <glad/glad.h>
+
+// GLFW
+#include <GLFW/glfw3.h>
+
+#include "Shader.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <functional>
+
+#include <glm/gtc/packing.hpp>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock Clock;
+
+	double elapsedMs(Clock::time_point start)
+	{
+		return chrono::duration<double, milli>(Clock::now() - start).count();
+	}
+
+	long long fileSize(const string& filepath)
+	{
+		FILE* f = fopen(filepath.c_str(), "rb");
+		if (f == nullptr)
+			return 0;
+		fseek(f, 0, SEEK_END);
+		long long size = ftell(f);
+		fclose(f);
+		return size;
+	}
+
+	// Código de saída de um modo: 0 se rodou e passou nas conferências
+	int exitStatus(bool passed)
+	{
+		return passed ? 0 : 1;
+	}
+
+	// Gera uma malha em grade (2 triângulos por célula) com exatamente nFaces faces
+	bool generateOBJ(const string& filepath, long long nFaces)
+	{
+		FILE* f = fopen(filepath.c_str(), "w");
+		if (f == nullptr)
+		{
+			cout << "Nao foi possivel criar " << filepath << endl;
+			return false;
+		}
+		vector<char> buffer(1 << 20);
+		setvbuf(f, buffer.data(), _IOFBF, buffer.size());
+
+		long long cells = (nFaces + 1) / 2;
+		long long side = (long long)ceil(sqrt((double)cells)) + 1;
+
+		fprintf(f, "# malha sintetica: %lld faces\n", nFaces);
+		for (long long j = 0; j < side; j++)
+			for (long long i = 0; i < side; i++)
+			{
+				float x = (float)i / (side - 1), z = (float)j / (side - 1);
+				fprintf(f, "v %f %f %f\n", x * 10.0f - 5.0f, 0.25f * sinf(x * 20.0f) * cosf(z * 20.0f), z * 10.0f - 5.0f);
+				fprintf(f, "vt %f %f\n", x, z);
+				fprintf(f, "vn %f %f %f\n", 0.0f, 1.0f, 0.0f);
+			}
+
+		long long written = 0;
+		for (long long j = 0; j + 1 < side && written < nFaces; j++)
+			for (long long i = 0; i + 1 < side && written < nFaces; i++)
+			{
+				long long a = j * side + i + 1, b = a + 1, c = a + side, d = c + 1;
+				fprintf(f, "f %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld\n", a, a, a, c, c, c, b, b, b);
+				if (++written < nFaces)
+				{
+					fprintf(f, "f %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld\n", b, b, b, c, c, c, d, d, d);
+					written++;
+				}
+			}
+		fclose(f);
+
+		cout << "Gerado " << filepath << ": " << written << " faces, " << side * side << " vertices" << endl;
+		return true;
+	}
+
+	bool benchmarkOBJ(const string& filepath, int repetitions)
+	{
+		glm::vec3 color(0.46, 0.38, 0.16);
+		double megabytes = fileSize(filepath) / (1024.0 * 1024.0);
+
+		vector<float> reference, mapped;
+		double streamBest = 1e30, mappedBest = 1e30;
+		for (int r = 0; r < repetitions; r++)
+		{
+			reference.clear();
+			Clock::time_point start = Clock::now();
+			if (!parseOBJStream(filepath, color, reference))
+				return false;
+			streamBest = min(streamBest, elapsedMs(start));
+
+			mapped.clear();
+			start = Clock::now();
+			if (!parseOBJ(filepath, color, mapped))
+				return false;
+			mappedBest = min(mappedBest, elapsedMs(start));
+		}
+
+		float maxError = 0.0f;
+		if (reference.size() == mapped.size())
+			for (size_t i = 0; i < reference.size(); i++)
+				maxError = max(maxError, fabsf(reference[i] - mapped[i]));
+
+		printf("%s (%.1f MB, melhor de %d)\n", filepath.c_str(), megabytes, repetitions);
+		printf("  getline/istringstream: %10.2f ms  %8.1f MB/s\n", streamBest, megabytes / (streamBest / 1000.0));
+		printf("  mmap + scanner:        %10.2f ms  %8.1f MB/s  (%.1fx)\n", mappedBest, megabytes / (mappedBest / 1000.0), streamBest / mappedBest);
+		printf("  vertices: %zu / %zu, maior diferenca: %g\n", reference.size() / OBJ_FLOATS_PER_VERTEX, mapped.size() / OBJ_FLOATS_PER_VERTEX, maxError);
+		return true;
+	}
+
+	// Escalabilidade do loader paralelo de 1 a maxThreads threads.
+	// Cada execução é comparada byte a byte com a de 1 thread
+	bool benchmarkOBJThreads(const string& filepath, int maxThreads)
+	{
+		glm::vec3 color(0.46, 0.38, 0.16);
+		double megabytes = fileSize(filepath) / (1024.0 * 1024.0);
+
+		vector<float> serial, parallel;
+		double serialMs = 0.0;
+		printf("%s (%.1f MB)\n", filepath.c_str(), megabytes);
+		printf("  threads       ms      MB/s  speedup  identico\n");
+		for (int nThreads = 1; nThreads <= maxThreads; nThreads++)
+		{
+			double best = 1e30;
+			for (int r = 0; r < 3; r++)
+			{
+				parallel.clear();
+				Clock::time_point start = Clock::now();
+				if (!parseOBJ(filepath, color, parallel, nThreads))
+					return false;
+				best = min(best, elapsedMs(start));
+			}
+			if (nThreads == 1)
+			{
+				serial.swap(parallel);
+				serialMs = best;
+			}
+			const vector<float>& result = nThreads == 1 ? serial : parallel;
+			bool identical = result.size() == serial.size() &&
+				memcmp(result.data(), serial.data(), serial.size() * sizeof(float)) == 0;
+			printf("  %7d %8.2f %9.1f %8.2fx  %s\n", nThreads, best, megabytes / (best / 1000.0), serialMs / best, identical ? "sim" : "NAO");
+		}
+		return true;
+	}
+
+	// Vértices e memória de vídeo da geometria desindexada (glDrawArrays)
+	// comparados com a versão indexada (VBO deduplicado + EBO)
+	bool meshStats(const string& filepath)
+	{
+		glm::vec3 color(0.46, 0.38, 0.16);
+		MeshData mesh;
+		if (!parseOBJIndexed(filepath, color, mesh))
+			return false;
+
+		size_t corners = mesh.indices.size();
+		size_t indexSize = mesh.vertexCount() <= 65536 ? 2 : 4;
+		size_t before = corners * OBJ_FLOATS_PER_VERTEX * sizeof(float);
+		size_t after = mesh.vertices.size() * sizeof(float) + corners * indexSize;
+
+		printf("%s\n", filepath.c_str());
+		printf("  vertices: %zu -> %zu (%.2fx menos)\n", corners, mesh.vertexCount(), (double)corners / max((size_t)1, mesh.vertexCount()));
+		printf("  VRAM:     %.1f KB -> %.1f KB (indices de %zu bits)\n", before / 1024.0, after / 1024.0, indexSize * 8);
+		VertexCacheStats cache = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount());
+		printf("  cache:    ACMR %.3f, ATVR %.3f (FIFO de %u vertices)\n", cache.acmr, cache.atvr, VERTEX_CACHE_SIZE);
+		return true;
+	}
+
+	// Carga a frio (parse + indexação + gravação do cache) contra carga a
+	// quente (só o mapeamento do cache), sem a parte de envio para a GPU
+	bool benchmarkCache(const string& filepath)
+	{
+		glm::vec3 color(0.46, 0.38, 0.16);
+
+		Clock::time_point start = Clock::now();
+		MeshData mesh;
+		vector<uint16_t> shortIndices;
+		MeshBuffers cold;
+		if (!parseOBJIndexed(filepath, color, mesh, 0))
+			return false;
+		buildMeshBuffers(mesh, shortIndices, cold);
+		if (!MeshCache::write(filepath, color, cold))
+		{
+			cout << "Nao foi possivel gravar " << MeshCache::cachePath(filepath) << endl;
+			return false;
+		}
+		double coldMs = elapsedMs(start);
+
+		start = Clock::now();
+		MeshCache cache;
+		if (!cache.open(filepath, color))
+		{
+			cout << "Cache invalido logo apos a gravacao" << endl;
+			return false;
+		}
+		double warmMs = elapsedMs(start);
+
+		const MeshBuffers& warm = cache.buffers();
+		bool identical = warm.vertexBytes == cold.vertexBytes && warm.indexBytes == cold.indexBytes
+			&& memcmp(warm.vertices, cold.vertices, cold.vertexBytes) == 0
+			&& memcmp(warm.indices, cold.indices, cold.indexBytes) == 0;
+
+		printf("%s\n", filepath.c_str());
+		printf("  frio (parse + cache):  %10.2f ms\n", coldMs);
+		printf("  quente (mmap):         %10.2f ms  (%.1fx)\n", warmMs, coldMs / max(warmMs, 1e-6));
+		printf("  buffers identicos: %s\n", identical ? "sim" : "NAO");
+		return true;
+	}
+
+	// Janela invisível só para ter um contexto OpenGL nos benchmarks de GPU
+	GLFWwindow* createHiddenContext()
+	{
+		if (!glfwInit())
+			return nullptr;
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		GLFWwindow* window = glfwCreateWindow(64, 64, "benchmark", nullptr, nullptr);
+		if (window == nullptr)
+		{
+			glfwTerminate();
+			return nullptr;
+		}
+		glfwMakeContextCurrent(window);
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+		{
+			glfwTerminate();
+			return nullptr;
+		}
+		loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+		return window;
+	}
+
+	// Custo de CPU por objeto de enviar model + inputColor (o que Mesh::update faz):
+	// busca no driver a cada chamada, nome no cache do Shader e handle tipado
+	bool benchmarkUniforms(int nObjects)
+	{
+		if (createHiddenContext() == nullptr)
+		{
+			cout << "Nao foi possivel criar um contexto OpenGL" << endl;
+			return false;
+		}
+
+		{
+			Shader shader("Phong.vs", "Phong.fs");
+			shader.use();
+			UniformMat4 modelUniform = shader.uniformMat4("model");
+			UniformVec3 colorUniform = shader.uniformVec3("inputColor");
+			float model[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+			glFinish();
+			Clock::time_point start = Clock::now();
+			for (int i = 0; i < nObjects; i++)
+			{
+				model[12] = (float)i;
+				glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, model);
+				glUniform3f(glGetUniformLocation(shader.ID, "inputColor"), 0.46f, 0.38f, 0.16f);
+			}
+			double lookupMs = elapsedMs(start);
+
+			glFinish();
+			start = Clock::now();
+			for (int i = 0; i < nObjects; i++)
+			{
+				model[12] = (float)i;
+				shader.setMat4("model", model);
+				shader.setVec3("inputColor", 0.46f, 0.38f, 0.16f);
+			}
+			double cachedMs = elapsedMs(start);
+
+			glFinish();
+			start = Clock::now();
+			for (int i = 0; i < nObjects; i++)
+			{
+				model[12] = (float)i;
+				shader.set(modelUniform, model);
+				shader.set(colorUniform, 0.46f, 0.38f, 0.16f);
+			}
+			double handleMs = elapsedMs(start);
+
+			printf("%d objetos (model + inputColor por objeto)\n", nObjects);
+			printf("  glGetUniformLocation por chamada: %8.1f ns/objeto\n", lookupMs * 1e6 / nObjects);
+			printf("  nome no cache do Shader:          %8.1f ns/objeto\n", cachedMs * 1e6 / nObjects);
+			printf("  handle tipado:                    %8.1f ns/objeto\n", handleMs * 1e6 / nObjects);
+		}
+
+		glfwTerminate();
+		return true;
+	}
+	// Custo de CPU por quadro das transformações de uma cena com nObjects Mesh:
+	// recalcular todas as matrizes (comportamento antigo), usar as matrizes em cache
+	// e sincronizar o buffer de instâncias com a cena parada ou com uma Mesh se movendo
+	bool benchmarkTransforms(int nObjects)
+	{
+		if (createHiddenContext() == nullptr)
+		{
+			cout << "Nao foi possivel criar um contexto OpenGL" << endl;
+			return false;
+		}
+
+		{
+			const int frames = 100;
+			Shader shader("Phong.vs", "Phong.fs");
+			shared_ptr<Geometry> geometry = make_shared<Geometry>();
+			vector<Mesh> meshes(nObjects);
+			for (int i = 0; i < nObjects; i++)
+				meshes[i].initialize(geometry, &shader, glm::vec3(3.0f * (i % 100), 0.0f, -3.0f * (i / 100)), glm::vec3(0.46f, 0.38f, 0.16f), glm::vec3(1.0f), (float)(i % 360), glm::vec3(0.0f, 1.0f, 0.0f));
+
+			InstanceRenderer instances;
+			instances.initialize();
+			instances.sync(meshes);
+
+			float sink = 0.0f;
+			Clock::time_point start = Clock::now();
+			for (int frame = 0; frame < frames; frame++)
+				for (int i = 0; i < nObjects; i++)
+				{
+					glm::mat4 model = glm::mat4(1);
+					model = glm::translate(model, meshes[i].getPosition());
+					model = glm::rotate(model, glm::radians(meshes[i].getAngle()), meshes[i].getAxis());
+					model = glm::scale(model, meshes[i].getScale());
+					sink += model[3][0];
+				}
+			double rebuildMs = elapsedMs(start) / frames;
+
+			start = Clock::now();
+			for (int frame = 0; frame < frames; frame++)
+				for (int i = 0; i < nObjects; i++)
+					sink += meshes[i].modelMatrix()[3][0];
+			double cachedMs = elapsedMs(start) / frames;
+
+			start = Clock::now();
+			for (int frame = 0; frame < frames; frame++)
+				instances.sync(meshes);
+			double idleMs = elapsedMs(start) / frames;
+
+			start = Clock::now();
+			for (int frame = 0; frame < frames; frame++)
+			{
+				meshes[frame % nObjects].translate(glm::vec3(0.0f, 0.1f, 0.0f));
+				instances.sync(meshes);
+			}
+			glFinish();
+			double movingMs = elapsedMs(start) / frames;
+
+			printf("%d objetos (media de %d quadros, checksum %g)\n", nObjects, frames, sink);
+			printf("  recalcular todas as matrizes: %8.3f ms/quadro\n", rebuildMs);
+			printf("  matrizes em cache:            %8.3f ms/quadro\n", cachedMs);
+			printf("  instancias, cena parada:      %8.3f ms/quadro\n", idleMs);
+			printf("  instancias, 1 objeto movendo: %8.3f ms/quadro\n", movingMs);
+		}
+
+		glfwTerminate();
+		return true;
+	}
+	// Composição das matrizes de modelo de nObjects objetos num buffer de instâncias
+	// (mat4 + vec4 por objeto): cadeia glm::translate/rotate/scale por objeto sobre
+	// structs (AoS) contra o TransformSystem (SoA + SSE)
+	bool benchmarkTransformSystem(int nObjects)
+	{
+		struct Transform
+		{
+			glm::vec3 position;
+			float angle;
+			glm::vec3 axis;
+			glm::vec3 scale;
+			glm::vec3 color;
+		};
+		struct Instance
+		{
+			glm::mat4 model;
+			glm::vec4 color;
+		};
+
+		srand(1);
+		vector<Transform> objects(nObjects);
+		for (Transform& object : objects)
+		{
+			object.position = glm::vec3(rand() % 1000, rand() % 1000, rand() % 1000) * 0.1f;
+			object.angle = (float)(rand() % 3600) * 0.1f;
+			object.axis = glm::vec3(rand() % 3, rand() % 3, 1 + rand() % 3);
+			object.scale = glm::vec3(0.5f + (rand() % 100) * 0.01f);
+			object.color = glm::vec3(0.46f, 0.38f, 0.16f);
+		}
+
+		const int repetitions = 5;
+		vector<Instance> reference(nObjects), batched(nObjects);
+
+		Clock::time_point start = Clock::now();
+		for (int r = 0; r < repetitions; r++)
+			for (int i = 0; i < nObjects; i++)
+			{
+				const Transform& object = objects[i];
+				glm::mat4 model = glm::mat4(1);
+				model = glm::translate(model, object.position);
+				model = glm::rotate(model, glm::radians(object.angle), object.axis);
+				model = glm::scale(model, object.scale);
+				reference[i].model = model;
+			}
+		double chainMs = elapsedMs(start) / repetitions;
+
+		TransformSystem transforms;
+		transforms.resize(nObjects);
+		start = Clock::now();
+		for (int i = 0; i < nObjects; i++)
+			transforms.set(i, objects[i].position, objects[i].scale, objects[i].angle, objects[i].axis);
+		double setMs = elapsedMs(start);
+
+		start = Clock::now();
+		for (int r = 0; r < repetitions; r++)
+			transforms.compose(0, nObjects, batched.data(), sizeof(Instance));
+		double composeMs = elapsedMs(start) / repetitions;
+
+		float maxError = 0.0f;
+		for (int i = 0; i < nObjects; i++)
+			for (int c = 0; c < 4; c++)
+				for (int k = 0; k < 4; k++)
+					maxError = max(maxError, fabsf(reference[i].model[c][k] - batched[i].model[c][k]));
+
+		printf("%d objetos\n", nObjects);
+		printf("  glm::translate/rotate/scale (AoS): %8.2f ms\n", chainMs);
+		printf("  TransformSystem::compose (SoA):    %8.2f ms  (%.1fx)\n", composeMs, chainMs / max(composeMs, 1e-6));
+		printf("  TransformSystem::set (uma vez):    %8.2f ms\n", setMs);
+		printf("  maior diferenca: %g\n", maxError);
+		return true;
+	}
+	// Culling por frustum de nObjects volumes espalhados em volta da câmera:
+	// tempo do teste em lote e conferência contra o teste escalar objeto a objeto
+	bool benchmarkCulling(int nObjects)
+	{
+		srand(2);
+		vector<Bounds> objects(nObjects);
+		for (Bounds& object : objects)
+		{
+			object.center = glm::vec3(rand() % 2001 - 1000, rand() % 2001 - 1000, rand() % 2001 - 1000) * 0.1f;
+			object.extents = glm::vec3(0.2f + (rand() % 100) * 0.02f, 0.2f + (rand() % 100) * 0.02f, 0.2f + (rand() % 100) * 0.02f);
+			object.radius = glm::length(object.extents);
+		}
+
+		FrustumCuller culler;
+		culler.resize(nObjects);
+		for (int i = 0; i < nObjects; i++)
+			culler.set(i, objects[i]);
+
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+		glm::mat4 viewProjection = projection * view;
+
+		const int repetitions = 100;
+		Clock::time_point start = Clock::now();
+		for (int r = 0; r < repetitions; r++)
+			culler.cull(viewProjection);
+		double cullMs = elapsedMs(start) / repetitions;
+
+		glm::vec4 planes[6];
+		extractFrustumPlanes(viewProjection, planes);
+		int mismatches = 0;
+		for (int i = 0; i < nObjects; i++)
+		{
+			bool outside = false;
+			for (int p = 0; p < 6; p++)
+			{
+				glm::vec3 n = glm::vec3(planes[p]);
+				float d = glm::dot(n, objects[i].center) + planes[p].w;
+				float boxRadius = glm::dot(glm::abs(n), objects[i].extents);
+				outside = outside || d < -min(objects[i].radius, boxRadius);
+			}
+			mismatches += outside == culler.isVisible(i);
+		}
+
+		printf("%d objetos\n", nObjects);
+		printf("  cull em lote: %8.3f ms (%.1f ns/objeto)\n", cullMs, cullMs * 1e6 / nObjects);
+		printf("  desenhados: %d, descartados: %d\n", culler.drawnCount(), culler.culledCount());
+		printf("  divergencias com o teste escalar: %d\n", mismatches);
+		return true;
+	}
+	// BVH dinâmica com cenas crescentes até maxObjects: construção, atualização
+	// (movimentos pequenos e grandes) e consultas por frustum, esfera e caixa,
+	// comparadas com o teste de todos os objetos
+	bool benchmarkBVH(int maxObjects)
+	{
+		printf("%9s %9s %9s %7s %6s %10s %10s %10s %10s %10s %8s\n", "objetos", "constr.ms", "mover ns", "reins.", "altura", "area", "frustum ms", "lista ms", "esfera us", "caixa us", "diverg.");
+		for (int n = 1000; n <= maxObjects; n = n < maxObjects && n * 10 > maxObjects ? maxObjects : n * 10)
+		{
+			srand(3);
+			float side = 3.0f * cbrtf((float)n);
+			auto randomBox = [&](glm::vec3 center) {
+				glm::vec3 extents = glm::vec3(0.3f + (rand() % 100) * 0.01f);
+				AABB box;
+				box.min = center - extents;
+				box.max = center + extents;
+				return box;
+			};
+			auto randomPoint = [&]() {
+				return glm::vec3(rand() % 10000, rand() % 10000, rand() % 10000) * (side / 10000.0f) - glm::vec3(side * 0.5f);
+			};
+
+			vector<AABB> boxes(n);
+			for (AABB& box : boxes)
+				box = randomBox(randomPoint());
+
+			DynamicBVH tree(0.5f);
+			vector<int> proxies(n);
+			Clock::time_point start = Clock::now();
+			for (int i = 0; i < n; i++)
+				proxies[i] = tree.createProxy(boxes[i], i);
+			double buildMs = elapsedMs(start);
+
+			//1% dos objetos por quadro: a maioria anda pouco (fica na caixa gorda), alguns saltam
+			int moves = max(1, n / 100);
+			int reinserted = 0;
+			start = Clock::now();
+			for (int m = 0; m < moves; m++)
+			{
+				int i = rand() % n;
+				glm::vec3 offset = m % 10 == 0 ? randomPoint() - (boxes[i].min + boxes[i].max) * 0.5f : glm::vec3(0.1f, 0.0f, -0.1f);
+				boxes[i].min += offset;
+				boxes[i].max += offset;
+				reinserted += tree.moveProxy(proxies[i], boxes[i]);
+			}
+			double moveNs = elapsedMs(start) * 1e6 / moves;
+
+			glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, side * 0.25f);
+			glm::mat4 viewProjection = projection * view;
+			glm::vec4 planes[6];
+			extractFrustumPlanes(viewProjection, planes);
+
+			const int repetitions = 20;
+			int found = 0;
+			start = Clock::now();
+			for (int r = 0; r < repetitions; r++)
+			{
+				found = 0;
+				tree.queryFrustum(planes, [&](int) { found++; return true; });
+			}
+			double frustumMs = elapsedMs(start) / repetitions;
+
+			//Mesmo teste objeto a objeto com o culler em lote, sobre as caixas gordas
+			FrustumCuller culler;
+			culler.resize(n);
+			for (int i = 0; i < n; i++)
+			{
+				const AABB& fat = tree.fatAABB(proxies[i]);
+				Bounds bounds;
+				bounds.center = (fat.min + fat.max) * 0.5f;
+				bounds.extents = (fat.max - fat.min) * 0.5f;
+				bounds.radius = glm::length(bounds.extents);
+				culler.set(i, bounds);
+			}
+			start = Clock::now();
+			for (int r = 0; r < repetitions; r++)
+				culler.cull(viewProjection);
+			double listMs = elapsedMs(start) / repetitions;
+
+			//Com o raio da esfera igual à meia-diagonal o culler é exatamente o teste da caixa
+			vector<uint8_t> marked(n, 0);
+			tree.queryFrustum(planes, [&](int i) { marked[i] = 1; return true; });
+			int mismatches = 0;
+			for (int i = 0; i < n; i++)
+				mismatches += marked[i] != (uint8_t)culler.isVisible(i);
+
+			const int queries = 1000;
+			int hits = 0;
+			start = Clock::now();
+			for (int q = 0; q < queries; q++)
+				tree.querySphere(randomPoint(), 5.0f, [&](int) { hits++; return true; });
+			double sphereUs = elapsedMs(start) * 1000.0 / queries;
+
+			start = Clock::now();
+			for (int q = 0; q < queries; q++)
+				tree.queryBox(randomBox(randomPoint()), [&](int) { hits++; return true; });
+			double boxUs = elapsedMs(start) * 1000.0 / queries;
+
+			printf("%9d %9.2f %9.1f %7d %6d %10.1f %10.3f %10.3f %10.2f %10.2f %8d\n", n, buildMs, moveNs, reinserted, tree.height(), tree.areaRatio(), frustumMs, listMs, sphereUs, boxUs, mismatches);
+			if (n == maxObjects)
+				break;
+		}
+		return true;
+	}
+	// Seleção por raio numa malha: montagem da BVH de triângulos e raios aleatórios
+	// vindos de fora da malha, conferidos contra o teste de todos os triângulos
+	bool benchmarkPicking(const string& filepath, int nRays)
+	{
+		MeshData mesh;
+		if (!parseOBJIndexed(filepath, glm::vec3(0.0f), mesh, 0))
+		{
+			cout << "Nao foi possivel ler " << filepath << endl;
+			return false;
+		}
+		vector<uint16_t> shortIndices;
+		MeshBuffers buffers;
+		buildMeshBuffers(mesh, shortIndices, buffers);
+
+		Clock::time_point start = Clock::now();
+		TriangleBVH bvh;
+		bvh.build(buffers.vertices, buffers.vertexCount, buffers.stride, buffers.indices, buffers.indexCount, buffers.indexType == GL_UNSIGNED_SHORT, 0);
+		double buildMs = elapsedMs(start);
+		Bounds bounds = computeBounds(buffers.vertices, buffers.vertexCount, buffers.stride);
+
+		srand(4);
+		auto random = [](float low, float high) { return low + (high - low) * (rand() / (float)RAND_MAX); };
+		int hits = 0, mismatches = 0;
+		double bvhMs = 0.0, worstMs = 0.0, bruteMs = 0.0;
+		for (int r = 0; r < nRays; r++)
+		{
+			//Da superfície de uma esfera com o dobro do raio até um ponto da caixa
+			glm::vec3 onSphere = glm::normalize(glm::vec3(random(-1, 1), random(-1, 1), random(-1, 1)) + glm::vec3(1e-4f));
+			glm::vec3 origin = bounds.center + onSphere * bounds.radius * 2.0f;
+			glm::vec3 target = bounds.center + glm::vec3(random(-1, 1), random(-1, 1), random(-1, 1)) * bounds.extents;
+			glm::vec3 direction = target - origin;
+
+			float t = 10.0f;
+			uint32_t triangle = 0;
+			start = Clock::now();
+			bool hit = bvh.raycast(origin, direction, t, triangle);
+			double ms = elapsedMs(start);
+			bvhMs += ms;
+			worstMs = max(worstMs, ms);
+
+			float tBrute = 10.0f;
+			uint32_t triangleBrute = 0;
+			start = Clock::now();
+			bool hitBrute = bvh.raycastBruteForce(origin, direction, tBrute, triangleBrute);
+			bruteMs += elapsedMs(start);
+
+			//Empates (raio passando por uma aresta) podem escolher triângulos vizinhos
+			hits += hit;
+			if (hit != hitBrute || (hit && triangle != triangleBrute && fabsf(t - tBrute) > 1e-6f * max(1.0f, tBrute)))
+				mismatches++;
+		}
+
+		printf("%s: %zu triangulos, %zu nos\n", filepath.c_str(), bvh.triangleCount(), bvh.nodeCount());
+		printf("  montagem da BVH:      %10.2f ms\n", buildMs);
+		printf("  raio na BVH:          %10.4f ms em media, %.4f ms no pior caso\n", bvhMs / nRays, worstMs);
+		printf("  raio em todos:        %10.4f ms em media\n", bruteMs / nRays);
+		printf("  %d raios, %d acertos, %d divergencias\n", nRays, hits, mismatches);
+		printf("  selecao igual a da forca bruta: %s\n", mismatches == 0 ? "sim" : "NAO");
+		return mismatches == 0;
+	}
+
+	// Níveis de detalhe gerados com 1 e com nThreads threads: triângulos, erro e tempo de cada
+	// cadeia, conferindo se os índices são válidos e se nenhum triângulo degenerou
+	bool benchmarkLod(const string& filepath, int nThreads)
+	{
+		MeshData original;
+		if (!parseOBJIndexed(filepath, glm::vec3(0.0f), original, 0))
+		{
+			cout << "Nao foi possivel ler " << filepath << endl;
+			return false;
+		}
+		printf("%s: %zu triangulos, %zu vertices\n", filepath.c_str(), original.indices.size() / 3, original.vertexCount());
+
+		vector<int> threadCounts = { 1 };
+		if (nThreads > 1)
+			threadCounts.push_back(nThreads);
+		for (int threads : threadCounts)
+		{
+			MeshData mesh = original;
+			vector<MeshLod> lods;
+			Clock::time_point start = Clock::now();
+			generateLods(mesh, lods, threads);
+			double ms = elapsedMs(start);
+
+			printf("  %d thread(s): %zu niveis em %.1f ms\n", threads, lods.size(), ms);
+			int invalid = 0, degenerate = 0;
+			for (size_t l = 0; l < lods.size(); l++)
+			{
+				const uint32_t* indices = &mesh.indices[lods[l].firstIndex];
+				for (uint32_t t = 0; t + 2 < lods[l].indexCount; t += 3)
+				{
+					for (int k = 0; k < 3; k++)
+						invalid += indices[t + k] >= mesh.vertexCount();
+					degenerate += indices[t] == indices[t + 1] || indices[t + 1] == indices[t + 2] || indices[t] == indices[t + 2];
+				}
+				printf("    nivel %zu: %10u triangulos (%5.1f%%), erro %g\n", l, lods[l].indexCount / 3, 100.0 * lods[l].indexCount / lods[0].indexCount, lods[l].error);
+			}
+			printf("    %d indices invalidos, %d triangulos degenerados\n", invalid, degenerate);
+		}
+		return true;
+	}
+
+	// Triângulo com o menor índice na frente, mantendo a orientação
+	void canonicalTriangles(const vector<uint32_t>& indices, vector<uint64_t>& out)
+	{
+		out.resize(indices.size() / 3);
+		for (size_t t = 0; t < out.size(); t++)
+		{
+			uint32_t a = indices[t * 3], b = indices[t * 3 + 1], c = indices[t * 3 + 2];
+			while (a > b || a > c)
+			{
+				uint32_t first = a;
+				a = b; b = c; c = first;
+			}
+			out[t] = (uint64_t)a << 42 | (uint64_t)b << 21 | c;
+		}
+		sort(out.begin(), out.end());
+	}
+
+	// Confere o simulador de cache FIFO em sequências com resultado conhecido
+	bool checkFifoSimulation()
+	{
+		//Repetir um triângulo não custa nada
+		vector<uint32_t> repeated = { 0, 1, 2, 0, 1, 2 };
+		VertexCacheStats a = analyzeVertexCache(repeated.data(), repeated.size(), 4, 16);
+		//Com cache de 3 o vértice 3 expulsa o 0. Os acertos em 1 e 2 não os renovam (FIFO, e
+		//não LRU), então a volta do 0 expulsa o 1, o 1 expulsa o 2 e o 2 expulsa o 3: 7 faltas
+		//(um LRU teria 5). Com cache de 4 só há as 4 faltas iniciais
+		vector<uint32_t> evicting = { 0, 1, 2, 3, 1, 2, 0, 1, 2 };
+		VertexCacheStats b = analyzeVertexCache(evicting.data(), evicting.size(), 4, 3);
+		VertexCacheStats c = analyzeVertexCache(evicting.data(), evicting.size(), 4, 4);
+		return a.misses == 3 && a.acmr == 1.5f && b.misses == 7 && c.misses == 4;
+	}
+
+	// Ordem do arquivo contra Tipsify, overdraw e leitura dos vértices: ACMR/ATVR (cache
+	// FIFO simulado) e tempo de cada etapa, conferindo que os triângulos não mudam
+	bool benchmarkVertexCache(const string& filepath)
+	{
+		bool simulation = checkFifoSimulation();
+		printf("simulacao do cache FIFO: %s\n", simulation ? "ok" : "FALHOU");
+
+		MeshData mesh;
+		if (!parseOBJIndexed(filepath, glm::vec3(0.0f), mesh, 0))
+		{
+			cout << "Nao foi possivel ler " << filepath << endl;
+			return false;
+		}
+		size_t vertexCount = mesh.vertexCount();
+		printf("%s: %zu triangulos, %zu vertices\n", filepath.c_str(), mesh.indices.size() / 3, vertexCount);
+		vector<uint64_t> reference, current;
+		canonicalTriangles(mesh.indices, reference);
+
+		//Cache de 16 é o padrão; 32 mostra se a ordem continua boa num cache maior
+		auto report = [&](const char* stage, double ms) {
+			VertexCacheStats small = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount());
+			VertexCacheStats large = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount(), 32);
+			OverdrawStats overdraw = analyzeOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.vertices.data());
+			printf("  %-22s ACMR %.3f (32: %.3f), ATVR %.3f, overdraw %.3f  %8.1f ms\n", stage, small.acmr, large.acmr, small.atvr, overdraw.overdraw, ms);
+			return small;
+		};
+		VertexCacheStats original = report("ordem do arquivo", 0.0);
+
+		Clock::time_point start = Clock::now();
+		optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), vertexCount);
+		VertexCacheStats tipsify = report("Tipsify", elapsedMs(start));
+		canonicalTriangles(mesh.indices, current);
+		bool same = current == reference;
+
+		start = Clock::now();
+		optimizeOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), vertexCount);
+		VertexCacheStats overdraw = report("overdraw", elapsedMs(start));
+		canonicalTriangles(mesh.indices, current);
+		same = same && current == reference;
+
+		//A renumeração não muda a ordem dos cantos: as posições lidas têm de ser as mesmas
+		vector<float> corners(mesh.indices.size() * 3);
+		for (size_t i = 0; i < mesh.indices.size(); i++)
+			memcpy(&corners[i * 3], &mesh.vertices[(size_t)mesh.indices[i] * OBJ_FLOATS_PER_VERTEX], 3 * sizeof(float));
+		start = Clock::now();
+		optimizeVertexFetch(mesh);
+		report("leitura dos vertices", elapsedMs(start));
+		for (size_t i = 0; i < mesh.indices.size() && same; i++)
+			same = memcmp(&corners[i * 3], &mesh.vertices[(size_t)mesh.indices[i] * OBJ_FLOATS_PER_VERTEX], 3 * sizeof(float)) == 0;
+
+		//Nenhuma das etapas pode deixar o cache pior que a ordem do arquivo; o overdraw troca
+		//parte do ganho do Tipsify por menos fragmentos
+		bool better = tipsify.acmr <= original.acmr && overdraw.acmr <= original.acmr;
+		printf("  triangulos preservados: %s, ACMR dentro do esperado: %s\n", same ? "sim" : "NAO", better ? "sim" : "NAO");
+		return simulation && same && better;
+	}
+
+	// Meshlets (Meshlets.h): montagem com conferência dos limites, dos triângulos, das esferas
+	// e dos cones, e a fração dos triângulos descartada pelo frustum e pelos cones com a
+	// câmera em volta do modelo (e perto dele, com parte fora da tela). Cada descarte é
+	// conferido triângulo a triângulo, com o modelo parado e com rotação e escala não uniforme
+	bool benchmarkMeshlets(const string& filepath)
+	{
+		MeshData mesh;
+		if (!parseOBJIndexed(filepath, glm::vec3(0.0f), mesh, 0))
+		{
+			cout << "Nao foi possivel ler " << filepath << endl;
+			return false;
+		}
+		//Mesma ordem de partida da carga com --optimize-mesh
+		optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount());
+		vector<uint64_t> reference, current;
+		canonicalTriangles(mesh.indices, reference);
+
+		vector<Meshlet> meshlets;
+		Clock::time_point start = Clock::now();
+		buildMeshlets(mesh, 0, mesh.indices.size(), meshlets);
+		double buildMs = elapsedMs(start);
+		canonicalTriangles(mesh.indices, current);
+
+		auto position = [&](uint32_t v) { return glm::make_vec3(&mesh.vertices[(size_t)v * OBJ_FLOATS_PER_VERTEX]); };
+		bool valid = current == reference;
+		size_t covered = 0, totalVertices = 0;
+		float averageCutoff = 0.0f;
+		for (const Meshlet& meshlet : meshlets)
+		{
+			valid = valid && meshlet.firstIndex == covered * 3 && meshlet.triangleCount <= MESHLET_MAX_TRIANGLES && meshlet.vertexCount <= MESHLET_MAX_VERTICES;
+			for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+			{
+				const uint32_t* triangle = &mesh.indices[meshlet.firstIndex + t * 3];
+				glm::vec3 a = position(triangle[0]), b = position(triangle[1]), c = position(triangle[2]);
+				for (const glm::vec3& p : { a, b, c })
+					valid = valid && glm::length(p - meshlet.center) <= meshlet.radius * 1.0001f + 1e-6f;
+				glm::vec3 normal = glm::cross(b - a, c - a);
+				if (meshlet.coneCutoff < 1.0f && glm::length(normal) > 0.0f)
+					valid = valid && glm::dot(glm::normalize(normal), meshlet.coneAxis) >= sqrt(1.0f - meshlet.coneCutoff * meshlet.coneCutoff) - 1e-4f;
+			}
+			covered += meshlet.triangleCount;
+			totalVertices += meshlet.vertexCount;
+			averageCutoff += meshlet.coneCutoff / meshlets.size();
+		}
+		valid = valid && covered * 3 == mesh.indices.size();
+		printf("%s: %zu triangulos em %zu meshlets (%.1f triangulos e %.1f vertices em media, cone %.2f), %.1f ms\n", filepath.c_str(),
+			mesh.indices.size() / 3, meshlets.size(), covered / (double)max<size_t>(meshlets.size(), 1), totalVertices / (double)max<size_t>(meshlets.size(), 1),
+			averageCutoff, buildMs);
+		printf("  limites, triangulos, esferas e cones: %s\n", valid ? "ok" : "FALHOU");
+
+		Bounds bounds = computeBounds(mesh.vertices.data(), mesh.vertexCount(), OBJ_FLOATS_PER_VERTEX * sizeof(float));
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+		vector<glm::vec3> directions = {
+			{ 0, 0, 1 }, { 0, 0, -1 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0.01f }, { 0, -1, 0.01f },
+			{ 1, 1, 1 }, { -1, 1, 1 }, { 1, -1, -1 }, { -1, -1, -1 }
+		};
+		glm::mat4 skewed = glm::scale(glm::rotate(glm::mat4(1.0f), 0.7f, glm::vec3(1, 2, 3)), glm::vec3(1.0f, 2.0f, 0.5f));
+		MeshletStats total;
+		size_t wrong = 0, idealRejected = 0;
+		printf("  %-22s %9s %9s %9s %9s\n", "camera", "meshlets", "frustum", "costas", "ideal");
+		for (int close = 0; close < 2; close++)
+			for (const glm::vec3& direction : directions)
+				for (int m = 0; m < 2; m++)
+				{
+					glm::mat4 model = m == 0 ? glm::mat4(1.0f) : skewed;
+					Bounds world = transformBounds(bounds, model);
+					//De perto o modelo passa das bordas da tela
+					glm::vec3 cameraPos = world.center + glm::normalize(direction) * world.radius * (close ? 1.2f : 3.0f);
+					glm::vec3 up = fabs(glm::normalize(direction).y) > 0.9f ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+					glm::mat4 viewProjection = projection * glm::lookAt(cameraPos, world.center, up);
+					MeshletView view = meshletView(viewProjection, model, cameraPos);
+					glm::vec4 planes[6];
+					extractFrustumPlanes(viewProjection, planes);
+
+					MeshletStats stats;
+					size_t ideal = 0;
+					for (const Meshlet& meshlet : meshlets)
+					{
+						int visibility = classifyMeshlet(meshlet, view);
+						stats.add(meshlet, visibility);
+						//Conferência no mundo: cada triângulo descartado está mesmo fora do
+						//frustum ou de costas, e ideal conta os que um teste por triângulo descartaria
+						for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+						{
+							const uint32_t* triangle = &mesh.indices[meshlet.firstIndex + t * 3];
+							glm::vec3 p[3];
+							for (int k = 0; k < 3; k++)
+								p[k] = glm::vec3(model * glm::vec4(position(triangle[k]), 1.0f));
+							bool outside = false;
+							for (int plane = 0; plane < 6 && !outside; plane++)
+							{
+								float slack = 1e-4f * world.radius;
+								outside = glm::dot(glm::vec3(planes[plane]), p[0]) + planes[plane].w < slack
+									&& glm::dot(glm::vec3(planes[plane]), p[1]) + planes[plane].w < slack
+									&& glm::dot(glm::vec3(planes[plane]), p[2]) + planes[plane].w < slack;
+							}
+							float facing = glm::dot(p[0] - cameraPos, glm::cross(p[1] - p[0], p[2] - p[0]));
+							bool backfacing = facing >= -1e-6f * glm::length(p[0] - cameraPos) * glm::length(glm::cross(p[1] - p[0], p[2] - p[0]));
+							ideal += outside || backfacing;
+							wrong += (visibility == MESHLET_OUTSIDE && !outside) || (visibility == MESHLET_BACKFACING && !backfacing);
+						}
+					}
+					total.add(stats);
+					idealRejected += ideal;
+					if (m == 0)
+					{
+						char label[64];
+						snprintf(label, sizeof(label), "%s(%g, %g, %g)", close ? "perto " : "", direction.x, direction.y, direction.z);
+						printf("  %-22s %8.1f%% %8.1f%% %8.1f%% %8.1f%%\n", label, 100.0 * (stats.outsideMeshlets + stats.backfacingMeshlets) / stats.meshlets,
+							100.0 * stats.outsideTriangles / stats.triangles, 100.0 * stats.backfacingTriangles / stats.triangles, 100.0 * ideal / stats.triangles);
+					}
+				}
+		printf("  media (com o modelo transformado): %.1f%% dos triangulos descartados (%.1f%% fora do frustum, %.1f%% de costas); um teste por triangulo descartaria %.1f%%\n",
+			100.0f * total.rejectionRate(), 100.0 * total.outsideTriangles / total.triangles, 100.0 * total.backfacingTriangles / total.triangles,
+			100.0 * idealRejected / total.triangles);
+		printf("  descartes conferidos: %s (%zu triangulos visiveis descartados)\n", wrong == 0 ? "ok" : "FALHOU", wrong);
+		return valid && wrong == 0;
+	}
+
+	// Vértices compactados (VertexPacking.h): memória contra o layout em floats e o maior erro
+	// de cada atributo, decodificado como no shader, conferido com o limite da quantização
+	bool benchmarkPacking(const string& filepath)
+	{
+		MeshData mesh;
+		if (!parseOBJIndexed(filepath, glm::vec3(0.0f), mesh, 0))
+		{
+			cout << "Nao foi possivel ler " << filepath << endl;
+			return false;
+		}
+		size_t count = mesh.vertexCount();
+		vector<PackedVertex> packed;
+		glm::vec3 offset, scale;
+		Clock::time_point start = Clock::now();
+		packVertices(mesh, packed, offset, scale);
+		double packMs = elapsedMs(start);
+		size_t floatBytes = count * OBJ_FLOATS_PER_VERTEX * sizeof(GLfloat);
+		size_t packedBytes = packed.size() * sizeof(PackedVertex);
+		printf("%s: %zu vertices, %zu KB -> %zu KB (%.1f%%), compactacao %.1f ms\n", filepath.c_str(), count,
+			floatBytes / 1024, packedBytes / 1024, 100.0 * packedBytes / max<size_t>(floatBytes, 1), packMs);
+
+		//Limites: meio passo da grade de 16 bits em cada eixo da caixa; meio passo de 16 bits
+		//com sinal nas duas coordenadas do octaedro, o que dá bem menos de 1e-3 rad; e o
+		//arredondamento da meia-precisão (11 bits de mantissa)
+		glm::vec3 positionBound = scale * (0.5f / 65535.0f);
+		const float normalBound = 1e-3f;
+		glm::vec3 positionError(0.0f);
+		float normalError = 0.0f, texcError = 0.0f;
+		bool ok = true;
+		for (size_t v = 0; v < count; v++)
+		{
+			const float* p = &mesh.vertices[v * OBJ_FLOATS_PER_VERTEX];
+			const PackedVertex& q = packed[v];
+			for (int a = 0; a < 3; a++)
+			{
+				float decoded = offset[a] + scale[a] * (q.position[a] / 65535.0f);
+				float error = fabs(decoded - p[a]);
+				positionError[a] = max(positionError[a], error);
+				ok = ok && error <= positionBound[a] * 1.01f + 1e-6f * fabs(p[a]);
+			}
+			glm::vec3 normal(p[8], p[9], p[10]);
+			if (glm::length(normal) > 0.0f)
+			{
+				glm::vec2 encoded(max(q.normal[0] / 32767.0f, -1.0f), max(q.normal[1] / 32767.0f, -1.0f));
+				//atan2 no lugar de acos, que perde precisão perto de ângulo zero
+				glm::vec3 decoded = decodeOctahedral(encoded);
+				normal = glm::normalize(normal);
+				float error = atan2(glm::length(glm::cross(decoded, normal)), glm::dot(decoded, normal));
+				normalError = max(normalError, error);
+				ok = ok && error <= normalBound;
+			}
+			for (int a = 0; a < 2; a++)
+			{
+				float error = fabs(glm::unpackHalf1x16(q.texc[a]) - p[6 + a]);
+				texcError = max(texcError, error);
+				ok = ok && error <= fabs(p[6 + a]) * (1.0f / 2048.0f) + 1e-7f;
+			}
+		}
+		printf("  erro maximo: posicao (%g, %g, %g) / limite (%g, %g, %g), normal %g rad / %g, texc %g\n",
+			positionError.x, positionError.y, positionError.z, positionBound.x, positionBound.y, positionBound.z,
+			normalError, normalBound, texcError);
+		printf("  erros dentro dos limites: %s\n", ok ? "sim" : "NAO");
+		return ok;
+	}
+
+	// Trabalho pequeno e opaco para o compilador, medido dentro de uma zona
+	volatile unsigned sink = 0;
+	void zoneBody(unsigned i)
+	{
+		PROFILE_ZONE("bench zone");
+		sink = sink + i;
+	}
+
+	// Custo por zona com o profiler desligado e ligado, descontado o laço sem zona
+	bool benchmarkProfiler(int nZones)
+	{
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < nZones; i++)
+			sink = sink + i;
+		double emptyMs = elapsedMs(start);
+
+		Profiler::setEnabled(false);
+		start = Clock::now();
+		for (int i = 0; i < nZones; i++)
+			zoneBody(i);
+		double disabledMs = elapsedMs(start);
+
+		Profiler::setEnabled(true);
+		start = Clock::now();
+		for (int i = 0; i < nZones; i++)
+			zoneBody(i);
+		double enabledMs = elapsedMs(start);
+		Profiler::setEnabled(false);
+
+		start = Clock::now();
+		bool written = Profiler::writeChromeTrace("profiler_bench.json");
+		double writeMs = elapsedMs(start);
+
+		printf("%d zonas\n", nZones);
+		printf("  desligado:            %10.2f ns por zona\n", (disabledMs - emptyMs) * 1e6 / nZones);
+		printf("  ligado:               %10.2f ns por zona\n", (enabledMs - emptyMs) * 1e6 / nZones);
+		printf("  gravacao do trace:    %10.2f ms (%zu eventos no anel)%s\n", writeMs, min((size_t)nZones, Profiler::RING_EVENTS), written ? "" : " - falhou");
+		remove("profiler_bench.json");
+		return true;
+	}
+
+	// Cena com nObjects geometrias distintas (tetraedros de alturas diferentes) no
+	// GeometryPool, uma Mesh para cada: tempo de CPU por quadro para enviar a cena com
+	// update() + draw() por Mesh e com o IndirectRenderer, parada e com todas as Mesh
+	// se movendo. A imagem do desenho indireto é conferida com a do instanciado, que
+	// compõe as matrizes do mesmo jeito
+	void benchmarkIndirectScene(int nObjects, Shader& shader, Shader& instancedShader, Shader& indirectShader, Framebuffer& target)
+	{
+		GeometryPool pool;
+		pool.initialize(64 << 20, 32 << 20);
+		MeshBuffers buffers;
+		buffers.stride = 11 * sizeof(float);
+		buffers.indexType = GL_UNSIGNED_INT;
+		buffers.attributes = {
+			{ 0, 3, GL_FLOAT, GL_FALSE, 0 },
+			{ 1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float) },
+			{ 2, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float) },
+			{ 3, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float) }
+		};
+		buffers.vertexCount = buffers.indexCount = 12;
+
+		//Uma face por vez, com a normal da face em cada vértice
+		const int faces[4][3] = { { 0, 2, 1 }, { 0, 1, 3 }, { 1, 2, 3 }, { 2, 0, 3 } };
+		vector<float> vertices(12 * 11);
+		vector<uint32_t> indices(12);
+		for (uint32_t i = 0; i < 12; i++)
+			indices[i] = i;
+		int side = (int)ceil(sqrt((double)nObjects));
+		vector<Mesh> meshes(nObjects);
+		for (int i = 0; i < nObjects; i++)
+		{
+			float height = 0.4f + 0.01f * (i % 97);
+			glm::vec3 corners[4] = { glm::vec3(-0.4f, -0.3f, 0.0f), glm::vec3(0.4f, -0.3f, 0.0f), glm::vec3(0.0f, 0.4f, 0.0f), glm::vec3(0.0f, 0.0f, height) };
+			for (int f = 0; f < 4; f++)
+			{
+				glm::vec3 normal = glm::normalize(glm::cross(corners[faces[f][1]] - corners[faces[f][0]], corners[faces[f][2]] - corners[faces[f][0]]));
+				for (int k = 0; k < 3; k++)
+				{
+					float* v = &vertices[(f * 3 + k) * 11];
+					glm::vec3 p = corners[faces[f][k]];
+					float values[11] = { p.x, p.y, p.z, 1, 1, 1, 0, 0, normal.x, normal.y, normal.z };
+					memcpy(v, values, sizeof(values));
+				}
+			}
+			shared_ptr<Geometry> geometry = make_shared<Geometry>();
+			if (!pool.allocate(*geometry, buffers))
+				return;
+			glBindBuffer(GL_COPY_WRITE_BUFFER, geometry->VBO);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)geometry->baseVertex * buffers.stride, vertices.size() * sizeof(float), vertices.data());
+			glBindBuffer(GL_COPY_WRITE_BUFFER, geometry->EBO);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)geometry->indexOffset(), indices.size() * sizeof(uint32_t), indices.data());
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+			glm::vec3 position((i % side) - side * 0.5f, (i / side) - side * 0.5f, 0.0f);
+			glm::vec3 color(0.2f + 0.6f * (i % 7) / 6.0f, 0.2f + 0.6f * (i % 11) / 10.0f, 0.5f);
+			meshes[i].initialize(geometry, &shader, position, color, glm::vec3(1.0f), (float)(i % 360), glm::vec3(0.0f, 0.0f, 1.0f));
+		}
+
+		FrameUniforms frameUniforms;
+		frameUniforms.initialize();
+		FrameData frame;
+		frame.cameraPos = glm::vec4(0.0f, 0.0f, side * 1.25f, 1.0f);
+		frame.view = glm::lookAt(glm::vec3(frame.cameraPos), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		frame.projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, side * 3.0f);
+		frame.lightPos = glm::vec4(0.0f, 0.0f, side * 2.0f, 1.0f);
+		frame.lightColor = glm::vec4(1.0f);
+		frameUniforms.update(frame);
+
+		//Tempos de CPU do envio (sem esperar a GPU) e do quadro inteiro (com glFinish)
+		const int frames = max(3, 200000 / nObjects);
+		auto measure = [&](bool moving, const function<void()>& submit, double& submitMs, double& frameMs) {
+			submit();
+			glFinish();
+			submitMs = frameMs = 0.0;
+			for (int i = 0; i < frames; i++)
+			{
+				if (moving)
+					for (Mesh& mesh : meshes)
+						mesh.rotate(1.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				glFinish();
+				Clock::time_point start = Clock::now();
+				submit();
+				submitMs += elapsedMs(start);
+				glFinish();
+				frameMs += elapsedMs(start);
+			}
+			submitMs /= frames;
+			frameMs /= frames;
+		};
+		auto perMesh = [&]() {
+			shader.use();
+			GLuint boundVAO = 0;
+			for (Mesh& mesh : meshes)
+			{
+				mesh.update();
+				mesh.draw(boundVAO);
+			}
+			glBindVertexArray(0);
+		};
+		IndirectRenderer indirect;
+		indirect.initialize();
+		Clock::time_point start = Clock::now();
+		indirect.sync(meshes);
+		double buildMs = elapsedMs(start);
+		//O sync é a parte da aplicação; o resto do envio é o driver expandindo os comandos
+		double syncMs = 0.0;
+		auto multiDraw = [&]() {
+			Clock::time_point start = Clock::now();
+			indirect.sync(meshes);
+			syncMs += elapsedMs(start);
+			indirect.draw(&indirectShader);
+		};
+
+		auto capture = [&](const function<void()>& submit, vector<unsigned char>& pixels) {
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			submit();
+			pixels.resize((size_t)target.getWidth() * target.getHeight() * 4);
+			glReadPixels(0, 0, target.getWidth(), target.getHeight(), GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		};
+		InstanceRenderer instances;
+		instances.initialize();
+		instances.sync(meshes);
+		vector<unsigned char> instancedPixels, indirectPixels, perMeshPixels;
+		capture([&]() { instances.draw(&instancedShader); }, instancedPixels);
+		capture(multiDraw, indirectPixels);
+		capture(perMesh, perMeshPixels);
+		size_t different = 0, differentPerMesh = 0, covered = 0;
+		for (size_t p = 0; p < indirectPixels.size(); p += 4)
+		{
+			different += memcmp(&indirectPixels[p], &instancedPixels[p], 4) != 0;
+			differentPerMesh += memcmp(&indirectPixels[p], &perMeshPixels[p], 4) != 0;
+			covered += indirectPixels[p] != 255 || indirectPixels[p + 1] != 255 || indirectPixels[p + 2] != 255;
+		}
+
+		double perMeshStill, perMeshStillFrame, perMeshMoving, perMeshMovingFrame;
+		double indirectStill, indirectStillFrame, indirectMoving, indirectMovingFrame;
+		measure(false, perMesh, perMeshStill, perMeshStillFrame);
+		syncMs = 0.0;
+		measure(false, multiDraw, indirectStill, indirectStillFrame);
+		double syncStill = syncMs / (frames + 1);
+		measure(true, perMesh, perMeshMoving, perMeshMovingFrame);
+		syncMs = 0.0;
+		measure(true, multiDraw, indirectMoving, indirectMovingFrame);
+		double syncMoving = syncMs / (frames + 1);
+
+		GeometryPool::Stats stats = pool.stats();
+		printf("%d geometrias distintas em %d arena(s) (media de %d quadros)\n", nObjects, stats.arenas, frames);
+		printf("                                   envio (CPU)    quadro com glFinish\n");
+		printf("  por Mesh, cena parada:          %9.3f ms   %9.3f ms   (%d draw calls)\n", perMeshStill, perMeshStillFrame, nObjects);
+		printf("  por Mesh, todas se movendo:     %9.3f ms   %9.3f ms\n", perMeshMoving, perMeshMovingFrame);
+		printf("  indireto, cena parada:          %9.3f ms   %9.3f ms   (%d draw calls; sync %.3f ms)\n", indirectStill, indirectStillFrame, indirect.drawCalls(), syncStill);
+		printf("  indireto, todas se movendo:     %9.3f ms   %9.3f ms   (sync %.3f ms)\n", indirectMoving, indirectMovingFrame, syncMoving);
+		printf("  montagem inicial dos comandos:  %9.3f ms\n", buildMs);
+		printf("  imagem: %zu pixels cobertos, %zu diferentes do instanciado, %zu do desenho por Mesh\n", covered, different, differentPerMesh);
+		pool.shutdown();
+	}
+
+	bool benchmarkIndirect(const vector<int>& sizes)
+	{
+		if (createHiddenContext() == nullptr)
+		{
+			cout << "Nao foi possivel criar um contexto OpenGL" << endl;
+			return false;
+		}
+		if (!IndirectRenderer::isSupported())
+		{
+			cout << "Contexto sem glMultiDrawElementsIndirect ou gl_DrawIDARB" << endl;
+			glfwTerminate();
+			return false;
+		}
+
+		{
+			Shader shader("Phong.vs", "Phong.fs");
+			Shader instancedShader("PhongInstanced.vs", "Phong.fs");
+			Shader indirectShader("PhongIndirect.vs", "Phong.fs");
+			PhongMaterial material;
+			for (Shader* program : { &shader, &instancedShader, &indirectShader })
+			{
+				program->use();
+				program->setFloat("ka", material.ka);
+				program->setFloat("kd", material.kd);
+				program->setFloat("ks", material.ks);
+				program->setFloat("q", material.q);
+			}
+
+			Framebuffer target;
+			if (!target.initialize(256, 256))
+			{
+				cout << "Framebuffer fora da tela incompleto" << endl;
+				glfwTerminate();
+				return false;
+			}
+			target.bind();
+			glEnable(GL_DEPTH_TEST);
+			glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+			for (int nObjects : sizes)
+				benchmarkIndirectScene(nObjects, shader, instancedShader, indirectShader, target);
+		}
+
+		glfwTerminate();
+		return true;
+	}
+
+	// GeometryPool com arenas pequenas: cargas e liberações aleatórias de geometrias com
+	// dados marcados, forçando compactações; no fim os dados de cada geometria viva são
+	// lidos de volta da GPU e conferidos
+	bool benchmarkPool(int nOperations)
+	{
+		if (createHiddenContext() == nullptr)
+		{
+			cout << "Nao foi possivel criar um contexto OpenGL" << endl;
+			return false;
+		}
+
+		{
+			GeometryPool pool;
+			pool.initialize(4 << 20, 2 << 20);
+			MeshBuffers buffers;
+			buffers.stride = sizeof(uint32_t);
+			buffers.indexType = GL_UNSIGNED_INT;
+			VertexAttribute attribute = { 0, 1, GL_FLOAT, GL_FALSE, 0 };
+			buffers.attributes.push_back(attribute);
+
+			//Cada vértice guarda o número da geometria e cada índice a sua posição
+			vector<pair<shared_ptr<Geometry>, uint32_t> > live;
+			vector<uint32_t> data;
+			srand(7);
+			double allocateMs = 0.0, worstMs = 0.0;
+			int allocations = 0;
+			for (int op = 0; op < nOperations; op++)
+			{
+				if (!live.empty() && rand() % 5 < 2)
+				{
+					size_t victim = rand() % live.size();
+					live[victim] = live.back();
+					live.pop_back();
+					continue;
+				}
+				buffers.vertexCount = 100 + rand() % 20000;
+				buffers.indexCount = 3 * (100 + rand() % 20000);
+				shared_ptr<Geometry> geometry = make_shared<Geometry>();
+				Clock::time_point start = Clock::now();
+				bool allocated = pool.allocate(*geometry, buffers);
+				double ms = elapsedMs(start);
+				allocateMs += ms;
+				worstMs = max(worstMs, ms);
+				allocations++;
+				if (!allocated)
+					continue;
+
+				uint32_t tag = (uint32_t)op;
+				data.assign(buffers.vertexCount, tag);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, geometry->VBO);
+				glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)geometry->baseVertex * buffers.stride, buffers.vertexCount * sizeof(uint32_t), data.data());
+				data.resize(buffers.indexCount);
+				for (uint32_t i = 0; i < buffers.indexCount; i++)
+					data[i] = tag ^ i;
+				glBindBuffer(GL_COPY_WRITE_BUFFER, geometry->EBO);
+				glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)geometry->indexOffset(), buffers.indexCount * sizeof(uint32_t), data.data());
+				glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+				live.push_back(make_pair(geometry, tag));
+			}
+			GeometryPool::Stats before = pool.stats();
+
+			Clock::time_point start = Clock::now();
+			pool.defragment();
+			glFinish();
+			double defragmentMs = elapsedMs(start);
+			GeometryPool::Stats after = pool.stats();
+
+			int mismatches = 0;
+			for (const pair<shared_ptr<Geometry>, uint32_t>& entry : live)
+			{
+				const Geometry& geometry = *entry.first;
+				data.resize(geometry.nVertices);
+				glBindBuffer(GL_COPY_READ_BUFFER, geometry.VBO);
+				glGetBufferSubData(GL_COPY_READ_BUFFER, (size_t)geometry.baseVertex * buffers.stride, data.size() * sizeof(uint32_t), data.data());
+				bool ok = count(data.begin(), data.end(), entry.second) == (ptrdiff_t)data.size();
+				data.resize(geometry.nIndices);
+				glBindBuffer(GL_COPY_READ_BUFFER, geometry.EBO);
+				glGetBufferSubData(GL_COPY_READ_BUFFER, (size_t)geometry.indexOffset(), data.size() * sizeof(uint32_t), data.data());
+				for (size_t i = 0; i < data.size() && ok; i++)
+					ok = data[i] == (entry.second ^ (uint32_t)i);
+				mismatches += !ok;
+			}
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+			printf("%d operacoes, %d reservas, %d geometrias vivas\n", nOperations, allocations, (int)live.size());
+			printf("  reserva:              %10.4f ms em media, %.4f ms no pior caso\n", allocateMs / max(allocations, 1), worstMs);
+			printf("  arenas:               %10d (%d compactacoes durante as reservas)\n", before.arenas, before.defragmentations);
+			printf("  uso:                  %10.1f%% de %zu KB, %zu trechos livres\n", 100.0 * before.usedBytes / max<size_t>(before.capacityBytes, 1), before.capacityBytes / 1024, before.freeFragments);
+			printf("  compactacao final:    %10.2f ms, %zu trechos livres\n", defragmentMs, after.freeFragments);
+			printf("  %d geometrias com dados divergentes\n", mismatches);
+			pool.shutdown();
+		}
+
+		glfwTerminate();
+		return true;
+	}
+}
+
+int runBenchmarks(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "--gen-obj" && i + 2 < argc)
+		{
+			return exitStatus(generateOBJ(argv[i + 1], atoll(argv[i + 2])));
+		}
+		if (arg == "--bench-obj" && i + 1 < argc)
+		{
+			int repetitions = i + 2 < argc ? max(1, atoi(argv[i + 2])) : 3;
+			return exitStatus(benchmarkOBJ(argv[i + 1], repetitions));
+		}
+		if (arg == "--mesh-stats" && i + 1 < argc)
+		{
+			bool ok = true;
+			for (int j = i + 1; j < argc; j++)
+				ok = meshStats(argv[j]) && ok;
+			return exitStatus(ok);
+		}
+		if (arg == "--bench-cache" && i + 1 < argc)
+		{
+			return exitStatus(benchmarkCache(argv[i + 1]));
+		}
+		if (arg == "--bench-uniforms")
+		{
+			return exitStatus(benchmarkUniforms(i + 1 < argc ? max(1, atoi(argv[i + 1])) : 100000));
+		}
+		if (arg == "--bench-transforms")
+		{
+			return exitStatus(benchmarkTransforms(i + 1 < argc ? max(1, atoi(argv[i + 1])) : 50000));
+		}
+		if (arg == "--bench-soa")
+		{
+			return exitStatus(benchmarkTransformSystem(i + 1 < argc ? max(1, atoi(argv[i + 1])) : 1000000));
+		}
+		if (arg == "--bench-cull")
+		{
+			return exitStatus(benchmarkCulling(i + 1 < argc ? max(1, atoi(argv[i + 1])) : 100000));
+		}
+		if (arg == "--bench-bvh")
+		{
+			return exitStatus(benchmarkBVH(i + 1 < argc ? max(1000, atoi(argv[i + 1])) : 500000));
+		}
+		if (arg == "--bench-pick" && i + 1 < argc)
+		{
+			return exitStatus(benchmarkPicking(argv[i + 1], i + 2 < argc ? max(1, atoi(argv[i + 2])) : 200));
+		}
+		if (arg == "--bench-vcache" && i + 1 < argc)
+		{
+			return exitStatus(benchmarkVertexCache(argv[i + 1]));
+		}
+		if (arg == "--bench-meshlets" && i + 1 < argc)
+		{
+			return exitStatus(benchmarkMeshlets(argv[i + 1]));
+		}
+		if (arg == "--bench-packing" && i + 1 < argc)
+		{
+			return exitStatus(benchmarkPacking(argv[i + 1]));
+		}
+		if (arg == "--bench-lod" && i + 1 < argc)
+		{
+			return exitStatus(benchmarkLod(argv[i + 1], i + 2 < argc ? max(1, atoi(argv[i + 2])) : ThreadPool::hardwareThreads()));
+		}
+		if (arg == "--bench-pool")
+		{
+			return exitStatus(benchmarkPool(i + 1 < argc ? max(1, atoi(argv[i + 1])) : 2000));
+		}
+		if (arg == "--bench-indirect")
+		{
+			vector<int> sizes;
+			for (int j = i + 1; j < argc; j++)
+				sizes.push_back(max(1, atoi(argv[j])));
+			if (sizes.empty())
+				sizes = { 10000, 100000 };
+			return exitStatus(benchmarkIndirect(sizes));
+		}
+		if (arg == "--bench-profiler")
+		{
+			return exitStatus(benchmarkProfiler(i + 1 < argc ? max(1, atoi(argv[i + 1])) : 10000000));
+		}
+		if (arg == "--bench-obj-threads" && i + 1 < argc)
+		{
+			int maxThreads = i + 2 < argc ? max(1, atoi(argv[i + 2])) : ThreadPool::hardwareThreads();
+			return exitStatus(benchmarkOBJThreads(argv[i + 1], maxThreads));
+		}
+	}
+	return BENCHMARK_NOT_RUN;
+}
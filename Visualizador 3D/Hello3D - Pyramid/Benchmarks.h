@@ -0,0 +1,25 @@
+#pragma once
+
+// Modos de benchmark acionados pela linha de comando (executam sem abrir janela):
+//   --gen-obj <arquivo> <faces>          gera um .obj sintético com o número de faces pedido
+//   --bench-obj <arquivo> [repeticoes]   compara o loader original com o loader mapeado em memória
+//   --bench-obj-threads <arquivo> [n]    escalabilidade do loader paralelo de 1 a n threads
+//   --mesh-stats <arquivo>...            vértices e VRAM antes/depois da indexação, e ACMR/ATVR da ordem do arquivo
+//   --bench-cache <arquivo>              carga a frio (parse) contra carga do cache binário
+//   --bench-uniforms [objetos]           custo por objeto dos envios de uniform (precisa de OpenGL)
+//   --bench-soa [objetos]                matrizes de modelo: cadeia glm por objeto contra TransformSystem (SoA + SSE)
+//   --bench-cull [objetos]               culling por frustum em lote (SSE) e conferência com o teste escalar
+//   --bench-bvh [objetos]                BVH dinâmica: construção, atualização e consultas com cenas crescentes
+//   --bench-pick <arquivo> [raios]       seleção por raio com a BVH de triângulos, conferida contra força bruta
+//   --bench-vcache <arquivo>             ACMR/ATVR (cache FIFO simulado) e tempo do Tipsify, do overdraw e da leitura dos vértices, com conferência
+//   --bench-meshlets <arquivo>           meshlets (Meshlets.h): montagem conferida e triângulos descartados pelo frustum e pelos cones de várias câmeras
+//   --bench-packing <arquivo>            vértices compactados (VertexPacking.h): memória e erro máximo de cada atributo, com conferência
+//   --bench-lod <arquivo> [threads]      níveis de detalhe (MeshSimplifier.h) com 1 e n threads: triângulos, erro, tempo e conferência
+//   --bench-profiler [zonas]             custo de uma zona do profiler desligado e ligado
+//   --bench-pool [operacoes]             reservas e liberações no GeometryPool, com compactação e conferência dos dados (precisa de OpenGL)
+//   --bench-indirect [objetos]...       custo de CPU do envio da cena por Mesh e com glMultiDrawElementsIndirect (padrão: 10000 e 100000; precisa de OpenGL)
+//   --bench-transforms [objetos]         custo por quadro das matrizes de modelo, com e sem cache (precisa de OpenGL)
+// Retorna BENCHMARK_NOT_RUN se nenhum modo foi reconhecido; senão o modo rodou e o valor é
+// o código de saída do programa: 0 se passou nas conferências, 1 se alguma falhou
+const int BENCHMARK_NOT_RUN = -1;
+int runBenchmarks(int argc, char** argv);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+// Fila entre threads com capacidade fixa: push() bloqueia enquanto a fila está cheia,
+// tryPop() nunca bloqueia (pode ser chamada a cada quadro pela thread do OpenGL).
+// Depois de close() os push() pendentes e os seguintes retornam false
+template <typename T>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	bool push(T item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+		if (closed)
+			return false;
+		items.push_back(std::move(item));
+		return true;
+	}
+
+	bool tryPop(T& item)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (items.empty())
+				return false;
+			item = std::move(items.front());
+			items.pop_front();
+		}
+		notFull.notify_one();
+		return true;
+	}
+
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+		}
+		notFull.notify_all();
+	}
+
+	bool isClosed()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return closed;
+	}
+
+private:
+	std::deque<T> items;
+	std::mutex mutex;
+	std::condition_variable notFull;
+	size_t capacity;
+	bool closed = false;
+};
@@ -0,0 +1,45 @@
+#include "Bounds.h"
+
+#include <cmath>
+#include <algorithm>
+
+Bounds computeBounds(const void* vertices, size_t count, size_t stride)
+{
+	Bounds bounds;
+	if (count == 0)
+		return bounds;
+
+	const char* data = (const char*)vertices;
+	glm::vec3 low = glm::vec3(((const float*)data)[0], ((const float*)data)[1], ((const float*)data)[2]);
+	glm::vec3 high = low;
+	for (size_t i = 1; i < count; i++)
+	{
+		const float* p = (const float*)(data + i * stride);
+		glm::vec3 position(p[0], p[1], p[2]);
+		low = glm::min(low, position);
+		high = glm::max(high, position);
+	}
+	bounds.center = (low + high) * 0.5f;
+	bounds.extents = (high - low) * 0.5f;
+
+	//Raio exato em torno do centro da caixa (menor ou igual à meia-diagonal)
+	float radius2 = 0.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		const float* p = (const float*)(data + i * stride);
+		glm::vec3 d = glm::vec3(p[0], p[1], p[2]) - bounds.center;
+		radius2 = std::max(radius2, glm::dot(d, d));
+	}
+	bounds.radius = sqrtf(radius2);
+	return bounds;
+}
+
+Bounds transformBounds(const Bounds& bounds, const glm::mat4& model)
+{
+	Bounds world;
+	world.center = glm::vec3(model * glm::vec4(bounds.center, 1.0f));
+	glm::vec3 x = glm::vec3(model[0]), y = glm::vec3(model[1]), z = glm::vec3(model[2]);
+	world.extents = glm::abs(x) * bounds.extents.x + glm::abs(y) * bounds.extents.y + glm::abs(z) * bounds.extents.z;
+	world.radius = bounds.radius * std::max(glm::length(x), std::max(glm::length(y), glm::length(z)));
+	return world;
+}
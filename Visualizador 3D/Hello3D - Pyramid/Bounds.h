@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+//GLM
+#include <glm/glm.hpp>
+
+// Volume envolvente de uma malha: caixa alinhada aos eixos (centro + meia-extensão)
+// e esfera com o mesmo centro. A esfera é mais barata de transformar e testar,
+// a caixa é mais justa para objetos alongados; o culling usa a mais justa das duas
+struct Bounds
+{
+	glm::vec3 center = glm::vec3(0.0f);
+	glm::vec3 extents = glm::vec3(0.0f);
+	float radius = 0.0f;
+};
+
+// Calcula os volumes de count posições (x, y, z nos 3 primeiros floats de cada
+// vértice, stride em bytes entre vértices)
+Bounds computeBounds(const void* vertices, size_t count, size_t stride);
+
+// Volumes em coordenadas de mundo: a caixa transformada é envolvida por uma nova
+// caixa alinhada aos eixos, e o raio é multiplicado pela maior escala da matriz
+Bounds transformBounds(const Bounds& bounds, const glm::mat4& model);
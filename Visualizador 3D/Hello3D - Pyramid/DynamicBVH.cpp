@@ -0,0 +1,316 @@
+#include "DynamicBVH.h"
+
+#include <algorithm>
+
+using namespace std;
+
+AABB DynamicBVH::fatten(const AABB& box) const
+{
+	AABB fat;
+	fat.min = box.min - glm::vec3(margin);
+	fat.max = box.max + glm::vec3(margin);
+	return fat;
+}
+
+int DynamicBVH::allocateNode()
+{
+	int index;
+	if (freeList != BVH_NULL_NODE)
+	{
+		index = freeList;
+		freeList = nodes[index].parent;
+	}
+	else
+	{
+		index = (int)nodes.size();
+		nodes.push_back(Node());
+	}
+
+	Node& node = nodes[index];
+	node.userData = -1;
+	node.parent = BVH_NULL_NODE;
+	node.child1 = BVH_NULL_NODE;
+	node.child2 = BVH_NULL_NODE;
+	node.height = 0;
+	return index;
+}
+
+void DynamicBVH::freeNode(int node)
+{
+	nodes[node].parent = freeList;
+	nodes[node].height = -1;
+	freeList = node;
+}
+
+void DynamicBVH::clear()
+{
+	nodes.clear();
+	root = BVH_NULL_NODE;
+	freeList = BVH_NULL_NODE;
+	proxies = 0;
+}
+
+int DynamicBVH::createProxy(const AABB& box, int userData)
+{
+	int proxy = allocateNode();
+	nodes[proxy].box = fatten(box);
+	nodes[proxy].userData = userData;
+	insertLeaf(proxy);
+	proxies++;
+	return proxy;
+}
+
+void DynamicBVH::destroyProxy(int proxy)
+{
+	removeLeaf(proxy);
+	freeNode(proxy);
+	proxies--;
+}
+
+bool DynamicBVH::moveProxy(int proxy, const AABB& box)
+{
+	if (nodes[proxy].box.contains(box))
+	{
+		//Se o objeto encolheu muito, a caixa gorda antiga deixaria a árvore frouxa
+		AABB large;
+		large.min = box.min - glm::vec3(4.0f * margin);
+		large.max = box.max + glm::vec3(4.0f * margin);
+		if (large.contains(nodes[proxy].box))
+			return false;
+	}
+
+	removeLeaf(proxy);
+	nodes[proxy].box = fatten(box);
+	insertLeaf(proxy);
+	return true;
+}
+
+void DynamicBVH::refit(int index)
+{
+	Node& node = nodes[index];
+	const Node& child1 = nodes[node.child1];
+	const Node& child2 = nodes[node.child2];
+	node.height = 1 + max(child1.height, child2.height);
+	node.box = AABB::merge(child1.box, child2.box);
+}
+
+void DynamicBVH::insertLeaf(int leaf)
+{
+	if (root == BVH_NULL_NODE)
+	{
+		root = leaf;
+		nodes[root].parent = BVH_NULL_NODE;
+		return;
+	}
+
+	//Desce escolhendo o melhor irmão: custo de criar um pai novo aqui contra o
+	//custo de descer por cada filho (área que a folha acrescenta aos ancestrais)
+	AABB leafBox = nodes[leaf].box;
+	int index = root;
+	while (!nodes[index].isLeaf())
+	{
+		const Node& node = nodes[index];
+		float area = node.box.surfaceArea();
+		float combinedArea = AABB::merge(node.box, leafBox).surfaceArea();
+		float cost = 2.0f * combinedArea;
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		int children[2] = { node.child1, node.child2 };
+		for (int c = 0; c < 2; c++)
+		{
+			const Node& child = nodes[children[c]];
+			float merged = AABB::merge(leafBox, child.box).surfaceArea();
+			childCost[c] = (child.isLeaf() ? merged : merged - child.box.surfaceArea()) + inheritanceCost;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+		index = childCost[0] < childCost[1] ? children[0] : children[1];
+	}
+	int sibling = index;
+
+	int oldParent = nodes[sibling].parent;
+	int newParent = allocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box = AABB::merge(leafBox, nodes[sibling].box);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+	if (oldParent != BVH_NULL_NODE)
+	{
+		if (nodes[oldParent].child1 == sibling)
+			nodes[oldParent].child1 = newParent;
+		else
+			nodes[oldParent].child2 = newParent;
+	}
+	else
+		root = newParent;
+
+	//Sobe corrigindo alturas e caixas
+	index = nodes[leaf].parent;
+	while (index != BVH_NULL_NODE)
+	{
+		index = balance(index);
+		refit(index);
+		index = nodes[index].parent;
+	}
+}
+
+void DynamicBVH::removeLeaf(int leaf)
+{
+	if (leaf == root)
+	{
+		root = BVH_NULL_NODE;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+	if (grandParent == BVH_NULL_NODE)
+	{
+		root = sibling;
+		nodes[sibling].parent = BVH_NULL_NODE;
+		freeNode(parent);
+		return;
+	}
+
+	//O irmão ocupa o lugar do pai
+	if (nodes[grandParent].child1 == parent)
+		nodes[grandParent].child1 = sibling;
+	else
+		nodes[grandParent].child2 = sibling;
+	nodes[sibling].parent = grandParent;
+	freeNode(parent);
+
+	int index = grandParent;
+	while (index != BVH_NULL_NODE)
+	{
+		index = balance(index);
+		refit(index);
+		index = nodes[index].parent;
+	}
+}
+
+// Rotação em A quando a diferença de altura dos filhos passa de 1.
+// Retorna o índice do nó que ficou no lugar de A
+int DynamicBVH::balance(int iA)
+{
+	Node& A = nodes[iA];
+	if (A.isLeaf() || A.height < 2)
+		return iA;
+
+	int iB = A.child1;
+	int iC = A.child2;
+	Node& B = nodes[iB];
+	Node& C = nodes[iC];
+	int difference = C.height - B.height;
+
+	//Sobe C
+	if (difference > 1)
+	{
+		int iF = C.child1;
+		int iG = C.child2;
+		Node& F = nodes[iF];
+		Node& G = nodes[iG];
+
+		C.child1 = iA;
+		C.parent = A.parent;
+		A.parent = iC;
+		if (C.parent != BVH_NULL_NODE)
+		{
+			if (nodes[C.parent].child1 == iA)
+				nodes[C.parent].child1 = iC;
+			else
+				nodes[C.parent].child2 = iC;
+		}
+		else
+			root = iC;
+
+		//O filho mais alto de C fica com C, o outro passa para A
+		if (F.height > G.height)
+		{
+			C.child2 = iF;
+			A.child2 = iG;
+			G.parent = iA;
+			A.box = AABB::merge(B.box, G.box);
+			C.box = AABB::merge(A.box, F.box);
+			A.height = 1 + max(B.height, G.height);
+			C.height = 1 + max(A.height, F.height);
+		}
+		else
+		{
+			C.child2 = iG;
+			A.child2 = iF;
+			F.parent = iA;
+			A.box = AABB::merge(B.box, F.box);
+			C.box = AABB::merge(A.box, G.box);
+			A.height = 1 + max(B.height, F.height);
+			C.height = 1 + max(A.height, G.height);
+		}
+		return iC;
+	}
+
+	//Sobe B
+	if (difference < -1)
+	{
+		int iD = B.child1;
+		int iE = B.child2;
+		Node& D = nodes[iD];
+		Node& E = nodes[iE];
+
+		B.child1 = iA;
+		B.parent = A.parent;
+		A.parent = iB;
+		if (B.parent != BVH_NULL_NODE)
+		{
+			if (nodes[B.parent].child1 == iA)
+				nodes[B.parent].child1 = iB;
+			else
+				nodes[B.parent].child2 = iB;
+		}
+		else
+			root = iB;
+
+		if (D.height > E.height)
+		{
+			B.child2 = iD;
+			A.child1 = iE;
+			E.parent = iA;
+			A.box = AABB::merge(C.box, E.box);
+			B.box = AABB::merge(A.box, D.box);
+			A.height = 1 + max(C.height, E.height);
+			B.height = 1 + max(A.height, D.height);
+		}
+		else
+		{
+			B.child2 = iE;
+			A.child1 = iD;
+			D.parent = iA;
+			A.box = AABB::merge(C.box, D.box);
+			B.box = AABB::merge(A.box, E.box);
+			A.height = 1 + max(C.height, D.height);
+			B.height = 1 + max(A.height, E.height);
+		}
+		return iB;
+	}
+
+	return iA;
+}
+
+float DynamicBVH::areaRatio() const
+{
+	if (root == BVH_NULL_NODE)
+		return 0.0f;
+
+	float rootArea = nodes[root].box.surfaceArea();
+	float totalArea = 0.0f;
+	for (const Node& node : nodes)
+		if (node.height >= 0)
+			totalArea += node.box.surfaceArea();
+	return rootArea > 0.0f ? totalArea / rootArea : 0.0f;
+}
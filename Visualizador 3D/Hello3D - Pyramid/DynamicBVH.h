@@ -0,0 +1,279 @@
+#pragma once
+
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+// Caixa alinhada aos eixos por mínimo e máximo
+struct AABB
+{
+	glm::vec3 min = glm::vec3(0.0f);
+	glm::vec3 max = glm::vec3(0.0f);
+
+	bool overlaps(const AABB& other) const
+	{
+		return min.x <= other.max.x && max.x >= other.min.x
+			&& min.y <= other.max.y && max.y >= other.min.y
+			&& min.z <= other.max.z && max.z >= other.min.z;
+	}
+	bool contains(const AABB& other) const
+	{
+		return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+			&& max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+	}
+	float surfaceArea() const
+	{
+		glm::vec3 d = max - min;
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+	static AABB merge(const AABB& a, const AABB& b)
+	{
+		AABB box;
+		box.min = glm::min(a.min, b.min);
+		box.max = glm::max(a.max, b.max);
+		return box;
+	}
+};
+
+const int BVH_NULL_NODE = -1;
+
+// Árvore de volumes envolventes dinâmica (versão 3D da b2DynamicTree do Box2D).
+// Cada objeto (proxy) é uma folha com uma caixa "gorda", aumentada de margin
+// em todas as direções: enquanto o objeto se move dentro dela a árvore não muda.
+// Inserções escolhem o irmão pelo custo de área de superfície (SAH) e a árvore
+// é mantida balanceada com rotações, como numa árvore AVL.
+// Os proxies guardam um inteiro do usuário (por exemplo, o índice da Mesh)
+class DynamicBVH
+{
+public:
+	DynamicBVH(float margin = 0.1f) : margin(margin) {}
+
+	int createProxy(const AABB& box, int userData);
+	void destroyProxy(int proxy);
+	// Atualiza a caixa do proxy; só reinsere se ela saiu da caixa gorda (ou se a
+	// caixa gorda ficou grande demais). Retorna true se reinseriu
+	bool moveProxy(int proxy, const AABB& box);
+	void clear();
+
+	int userData(int proxy) const { return nodes[proxy].userData; }
+	const AABB& fatAABB(int proxy) const { return nodes[proxy].box; }
+	int proxyCount() const { return proxies; }
+	int height() const { return root == BVH_NULL_NODE ? 0 : nodes[root].height; }
+	// Soma das áreas dos nós dividida pela área da raiz (qualidade da árvore)
+	float areaRatio() const;
+
+	// Chama callback(userData) para cada proxy cuja caixa gorda intercepta box;
+	// a busca para se o callback retornar false
+	template <typename Callback>
+	void queryBox(const AABB& box, Callback callback) const;
+	template <typename Callback>
+	void querySphere(glm::vec3 center, float radius, Callback callback) const;
+	// planes como em extractFrustumPlanes (normais para dentro). Nós inteiramente
+	// dentro do frustum têm todas as folhas reportadas sem mais testes
+	template <typename Callback>
+	void queryFrustum(const glm::vec4 planes[6], Callback callback) const;
+	// Proxies cuja caixa gorda é atingida pelo raio origin + t * direction, t em [0, tMax].
+	// callback(userData, tMax) retorna o novo tMax: menor para encurtar o raio
+	// (achou algo mais perto), negativo para encerrar a busca
+	template <typename Callback>
+	void queryRay(glm::vec3 origin, glm::vec3 direction, float tMax, Callback callback) const;
+
+private:
+	struct Node
+	{
+		AABB box;
+		int userData;
+		int parent; //próximo livre, para nós na lista livre
+		int child1;
+		int child2;
+		int height; //folha = 0, nó livre = -1
+
+		bool isLeaf() const { return child1 == BVH_NULL_NODE; }
+	};
+
+	int allocateNode();
+	void freeNode(int node);
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	int balance(int index);
+	void refit(int index);
+	AABB fatten(const AABB& box) const;
+
+	// Reporta todas as folhas abaixo de index; false se o callback pediu para parar
+	template <typename Callback>
+	bool reportAll(int index, Callback& callback, std::vector<int>& stack) const;
+
+	std::vector<Node> nodes;
+	int root = BVH_NULL_NODE;
+	int freeList = BVH_NULL_NODE;
+	int proxies = 0;
+	float margin;
+};
+
+template <typename Callback>
+void DynamicBVH::queryBox(const AABB& box, Callback callback) const
+{
+	std::vector<int> stack;
+	stack.reserve(64);
+	if (root != BVH_NULL_NODE)
+		stack.push_back(root);
+	while (!stack.empty())
+	{
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+		if (!node.box.overlaps(box))
+			continue;
+		if (node.isLeaf())
+		{
+			if (!callback(node.userData))
+				return;
+		}
+		else
+		{
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+}
+
+template <typename Callback>
+void DynamicBVH::querySphere(glm::vec3 center, float radius, Callback callback) const
+{
+	std::vector<int> stack;
+	stack.reserve(64);
+	if (root != BVH_NULL_NODE)
+		stack.push_back(root);
+	while (!stack.empty())
+	{
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+
+		//Distância do centro da esfera ao ponto mais próximo da caixa
+		glm::vec3 d = center - glm::clamp(center, node.box.min, node.box.max);
+		if (glm::dot(d, d) > radius * radius)
+			continue;
+		if (node.isLeaf())
+		{
+			if (!callback(node.userData))
+				return;
+		}
+		else
+		{
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+}
+
+template <typename Callback>
+void DynamicBVH::queryRay(glm::vec3 origin, glm::vec3 direction, float tMax, Callback callback) const
+{
+	glm::vec3 inverse = 1.0f / direction;
+	std::vector<int> stack;
+	stack.reserve(64);
+	if (root != BVH_NULL_NODE)
+		stack.push_back(root);
+	while (!stack.empty())
+	{
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+
+		//Intervalo do raio dentro da caixa (slabs)
+		glm::vec3 t1 = (node.box.min - origin) * inverse;
+		glm::vec3 t2 = (node.box.max - origin) * inverse;
+		glm::vec3 tNear = glm::min(t1, t2), tFar = glm::max(t1, t2);
+		float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+		float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, tMax));
+		if (enter > exit)
+			continue;
+
+		if (node.isLeaf())
+		{
+			tMax = callback(node.userData, tMax);
+			if (tMax < 0.0f)
+				return;
+		}
+		else
+		{
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+}
+
+template <typename Callback>
+bool DynamicBVH::reportAll(int index, Callback& callback, std::vector<int>& stack) const
+{
+	size_t base = stack.size();
+	stack.push_back(index);
+	while (stack.size() > base)
+	{
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+		if (node.isLeaf())
+		{
+			if (!callback(node.userData))
+				return false;
+		}
+		else
+		{
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+	return true;
+}
+
+template <typename Callback>
+void DynamicBVH::queryFrustum(const glm::vec4 planes[6], Callback callback) const
+{
+	//Cada entrada leva a máscara dos planos que ainda precisam ser testados:
+	//se o pai está inteiro do lado de dentro de um plano, os filhos também estão
+	struct Entry
+	{
+		int node;
+		int mask;
+	};
+	std::vector<Entry> stack;
+	std::vector<int> subtree;
+	stack.reserve(64);
+	if (root != BVH_NULL_NODE)
+		stack.push_back(Entry{ root, 63 });
+	while (!stack.empty())
+	{
+		Entry entry = stack.back();
+		stack.pop_back();
+		const Node& node = nodes[entry.node];
+
+		glm::vec3 center = (node.box.min + node.box.max) * 0.5f;
+		glm::vec3 extents = (node.box.max - node.box.min) * 0.5f;
+		int mask = entry.mask;
+		bool outside = false;
+		for (int p = 0; p < 6 && !outside; p++)
+		{
+			if (!(mask & (1 << p)))
+				continue;
+			glm::vec3 n = glm::vec3(planes[p]);
+			float d = glm::dot(n, center) + planes[p].w;
+			float r = glm::dot(glm::abs(n), extents);
+			if (d < -r)
+				outside = true;
+			else if (d >= r)
+				mask &= ~(1 << p);
+		}
+		if (outside)
+			continue;
+
+		if (mask == 0 || node.isLeaf())
+		{
+			if (!reportAll(entry.node, callback, subtree))
+				return;
+		}
+		else
+		{
+			stack.push_back(Entry{ node.child1, mask });
+			stack.push_back(Entry{ node.child2, mask });
+		}
+	}
+}
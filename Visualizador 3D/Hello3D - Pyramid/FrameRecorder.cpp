@@ -0,0 +1,128 @@
+#include "FrameRecorder.h"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+	// Valor na posição p (0 a 1) dos valores ordenados, pelo posto mais próximo
+	double percentile(const vector<double>& sorted, double p)
+	{
+		size_t rank = (size_t)(p * sorted.size() + 0.999999);
+		return sorted[min(sorted.size(), max<size_t>(rank, 1)) - 1];
+	}
+
+	void writeSummary(ostream& out, const char* name, vector<double> values, bool percentiles)
+	{
+		sort(values.begin(), values.end());
+		double sum = 0.0;
+		for (double value : values)
+			sum += value;
+		out << "  \"" << name << "\": { \"min\": " << values.front() << ", \"avg\": " << sum / values.size();
+		if (percentiles)
+			out << ", \"p95\": " << percentile(values, 0.95) << ", \"p99\": " << percentile(values, 0.99);
+		out << ", \"max\": " << values.back() << " }";
+	}
+}
+
+FrameRecorder::~FrameRecorder()
+{
+	if (queries[0] != 0)
+		glDeleteQueries(QUERY_RING, queries);
+}
+
+void FrameRecorder::initialize(int expectedFrames)
+{
+	glGenQueries(QUERY_RING, queries);
+	for (int i = 0; i < QUERY_RING; i++)
+		queryFrame[i] = -1;
+	frames.clear();
+	frames.reserve(max(expectedFrames, 0));
+}
+
+void FrameRecorder::beginFrame()
+{
+	int slot = (int)(frames.size() % QUERY_RING);
+	collect(slot);
+	frames.push_back(FrameSample());
+	queryFrame[slot] = (int)frames.size() - 1;
+
+	frameStart = chrono::steady_clock::now();
+	glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+}
+
+void FrameRecorder::endFrame(int drawCalls, unsigned long long triangles, const UploadStats& upload)
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	FrameSample& frame = frames.back();
+	frame.cpuMs = chrono::duration<double, milli>(chrono::steady_clock::now() - frameStart).count();
+	frame.drawCalls = drawCalls;
+	frame.triangles = triangles;
+	frame.uploadBytes = upload.bytes;
+	frame.stallMs = upload.stallMs;
+}
+
+void FrameRecorder::finish()
+{
+	for (int slot = 0; slot < QUERY_RING; slot++)
+		collect(slot);
+}
+
+void FrameRecorder::collect(int slot)
+{
+	if (queryFrame[slot] < 0)
+		return;
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &nanoseconds);
+	frames[queryFrame[slot]].gpuMs = nanoseconds / 1e6;
+	queryFrame[slot] = -1;
+}
+
+bool FrameRecorder::writeJSON(const string& filepath, int warmup, const vector<pair<string, string> >& info) const
+{
+	warmup = max(0, min(warmup, (int)frames.size() - 1));
+	vector<double> cpu, gpu, drawCalls, triangles, uploadKB, stall;
+	for (size_t i = warmup; i < frames.size(); i++)
+	{
+		cpu.push_back(frames[i].cpuMs);
+		gpu.push_back(frames[i].gpuMs);
+		drawCalls.push_back(frames[i].drawCalls);
+		triangles.push_back((double)frames[i].triangles);
+		uploadKB.push_back(frames[i].uploadBytes / 1024.0);
+		stall.push_back(frames[i].stallMs);
+	}
+	if (cpu.empty())
+		return false;
+
+	ofstream file;
+	bool console = filepath.empty() || filepath == "-";
+	if (!console)
+	{
+		file.open(filepath);
+		if (!file.is_open())
+			return false;
+	}
+	ostream& out = console ? cout : file;
+
+	out << "{\n";
+	for (const pair<string, string>& entry : info)
+		out << "  \"" << entry.first << "\": " << entry.second << ",\n";
+	out << "  \"frames\": " << cpu.size() << ",\n";
+	out << "  \"warmup_frames\": " << warmup << ",\n";
+	writeSummary(out, "cpu_ms", cpu, true);
+	out << ",\n";
+	writeSummary(out, "gpu_ms", gpu, true);
+	out << ",\n";
+	writeSummary(out, "draw_calls", drawCalls, false);
+	out << ",\n";
+	writeSummary(out, "triangles", triangles, false);
+	out << ",\n";
+	writeSummary(out, "upload_kb", uploadKB, false);
+	out << ",\n";
+	writeSummary(out, "upload_stall_ms", stall, true);
+	out << "\n}" << endl;
+	return (bool)out;
+}
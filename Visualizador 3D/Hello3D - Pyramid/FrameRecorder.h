@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include <glad/glad.h>
+
+#include "UploadRing.h"
+
+// Medidas de um quadro
+struct FrameSample
+{
+	double cpuMs = 0.0;  //do início do quadro até depois da troca de buffers
+	double gpuMs = 0.0;  //consulta GL_TIME_ELAPSED em volta dos comandos do quadro
+	int drawCalls = 0;
+	unsigned long long triangles = 0;
+	size_t uploadBytes = 0; //enviados pelo UploadRing
+	double stallMs = 0.0;   //espera pela região do UploadRing
+};
+
+// Registro do tempo de cada quadro para o modo --benchmark. O tempo de GPU vem de
+// consultas GL_TIME_ELAPSED num anel: o resultado de um quadro só é lido quando a
+// consulta dele vai ser reaproveitada, alguns quadros depois, para não esperar pela GPU
+class FrameRecorder
+{
+public:
+	FrameRecorder() {}
+	~FrameRecorder();
+	void initialize(int expectedFrames);
+	void beginFrame();
+	void endFrame(int drawCalls, unsigned long long triangles, const UploadStats& upload = UploadStats());
+	// Lê as consultas pendentes; chamar depois do último quadro
+	void finish();
+
+	const std::vector<FrameSample>& samples() const { return frames; }
+
+	// Grava min/média/p95/p99/máx de tempo de CPU e GPU, draw calls, triângulos e envios pelo anel
+	// dos quadros após os warmup primeiros. Com filepath vazio ou "-" escreve no console.
+	// info é uma lista de pares "chave": valor já em JSON, copiada para o objeto raiz
+	bool writeJSON(const std::string& filepath, int warmup, const std::vector<std::pair<std::string, std::string> >& info) const;
+
+private:
+	static const int QUERY_RING = 4;
+
+	void collect(int slot);
+
+	GLuint queries[QUERY_RING] = { 0 };
+	int queryFrame[QUERY_RING]; //quadro medido por cada consulta pendente (-1 = livre)
+	std::vector<FrameSample> frames;
+	std::chrono::steady_clock::time_point frameStart;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glad/glad.h>
+
+//GLM
+#include <glm/glm.hpp>
+
+// Ponto de ligação do bloco FrameData nos shaders (layout binding = 0)
+const GLuint FRAME_UNIFORMS_BINDING = 0;
+
+// Dados constantes de um quadro, no layout std140 do bloco FrameData.
+// Os vec3 vão em vec4 para não depender das regras de alinhamento do std140
+struct FrameData
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 lightPos;
+	glm::vec4 lightColor;
+	glm::vec4 cameraPos;
+};
+
+// Uniform buffer object com os dados do quadro: escrito uma vez por quadro e
+// ligado a um ponto fixo, de onde todos os programas de shader o leem
+class FrameUniforms
+{
+public:
+	FrameUniforms() {}
+	~FrameUniforms();
+	void initialize();
+	void update(const FrameData& data);
+
+private:
+	GLuint UBO = 0;
+};
@@ -0,0 +1,70 @@
+#include "Framebuffer.h"
+
+#include <cstdio>
+
+using namespace std;
+
+Framebuffer::~Framebuffer()
+{
+	if (FBO != 0)
+		glDeleteFramebuffers(1, &FBO);
+	if (colorRBO != 0)
+		glDeleteRenderbuffers(1, &colorRBO);
+	if (depthRBO != 0)
+		glDeleteRenderbuffers(1, &depthRBO);
+}
+
+bool Framebuffer::initialize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+
+	glGenRenderbuffers(1, &colorRBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorRBO);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &depthRBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &FBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return complete;
+}
+
+void Framebuffer::bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glViewport(0, 0, width, height);
+}
+
+void Framebuffer::unbind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool Framebuffer::writePPM(const string& filepath)
+{
+	//Linhas de 3 bytes por pixel não são múltiplas de 4 em qualquer largura
+	pixels.resize((size_t)width * height * 3);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+	FILE* f = fopen(filepath.c_str(), "wb");
+	if (f == nullptr)
+		return false;
+
+	//A OpenGL devolve a última linha primeiro
+	bool ok = fprintf(f, "P6\n%d %d\n255\n", width, height) > 0;
+	size_t rowBytes = (size_t)width * 3;
+	for (int y = height - 1; y >= 0 && ok; y--)
+		ok = fwrite(pixels.data() + y * rowBytes, 1, rowBytes, f) == rowBytes;
+	ok = fclose(f) == 0 && ok;
+	return ok;
+}
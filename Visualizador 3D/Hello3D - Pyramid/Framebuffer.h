@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Framebuffer fora da tela (cor RGBA8 e profundidade em renderbuffers), para
+// desenhar sem depender do tamanho nem da visibilidade da janela
+class Framebuffer
+{
+public:
+	Framebuffer() {}
+	~Framebuffer();
+	// Retorna false se o driver não aceitar a combinação de anexos
+	bool initialize(int width, int height);
+	// Passa a desenhar no framebuffer, com a viewport no tamanho dele
+	void bind();
+	void unbind();
+
+	// Lê a imagem da GPU e grava como PPM binário (P6), com a primeira linha no topo
+	bool writePPM(const std::string& filepath);
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+private:
+	GLuint FBO = 0, colorRBO = 0, depthRBO = 0;
+	int width = 0, height = 0;
+	std::vector<unsigned char> pixels;
+};
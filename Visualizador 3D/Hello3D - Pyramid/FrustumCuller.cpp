@@ -0,0 +1,156 @@
+#include "FrustumCuller.h"
+
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define CULLER_SSE 1
+#endif
+
+void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+	//Linhas da matriz (a GLM guarda por colunas)
+	glm::vec4 row[4];
+	for (int i = 0; i < 4; i++)
+		row[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+	planes[0] = row[3] + row[0];
+	planes[1] = row[3] - row[0];
+	planes[2] = row[3] + row[1];
+	planes[3] = row[3] - row[1];
+	planes[4] = row[3] + row[2];
+	planes[5] = row[3] - row[2];
+	for (int p = 0; p < 6; p++)
+		planes[p] /= glm::length(glm::vec3(planes[p]));
+}
+
+void FrustumCuller::resize(size_t count)
+{
+	size_t padded = (count + 3) & ~(size_t)3;
+	if (count != this->count)
+		resized = true;
+	this->count = count;
+	cx.resize(padded);  cy.resize(padded);  cz.resize(padded);
+	ex.resize(padded);  ey.resize(padded);  ez.resize(padded);
+	radius.resize(padded);
+	visible.resize(padded);
+	//Raio muito negativo: as sobras ficam sempre fora do frustum
+	std::fill(radius.begin() + count, radius.end(), -FLT_MAX);
+}
+
+void FrustumCuller::set(size_t index, const Bounds& world)
+{
+	cx[index] = world.center.x;  cy[index] = world.center.y;  cz[index] = world.center.z;
+	ex[index] = world.extents.x;  ey[index] = world.extents.y;  ez[index] = world.extents.z;
+	radius[index] = world.radius;
+}
+
+void FrustumCuller::update(std::vector<Mesh>& meshes)
+{
+	if (meshes.size() == count && Mesh::revision == seenRevision)
+		return;
+	unsigned long long previous = meshes.size() == count ? seenRevision : 0;
+	seenRevision = Mesh::revision;
+
+	resize(meshes.size());
+	for (size_t i = 0; i < meshes.size(); i++)
+		if (meshes[i].modified > previous)
+			set(i, meshes[i].worldBounds());
+}
+
+void FrustumCuller::cull(const glm::mat4& viewProjection)
+{
+	glm::vec4 planes[6];
+	extractFrustumPlanes(viewProjection, planes);
+
+	size_t padded = visible.size();
+	int visibleCount = 0;
+	bool differs = false;
+
+#ifdef CULLER_SSE
+	__m128 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+	for (int p = 0; p < 6; p++)
+	{
+		nx[p] = _mm_set1_ps(planes[p].x);  ny[p] = _mm_set1_ps(planes[p].y);
+		nz[p] = _mm_set1_ps(planes[p].z);  nw[p] = _mm_set1_ps(planes[p].w);
+		ax[p] = _mm_set1_ps(fabsf(planes[p].x));  ay[p] = _mm_set1_ps(fabsf(planes[p].y));
+		az[p] = _mm_set1_ps(fabsf(planes[p].z));
+	}
+
+	//Ponteiros locais: o compilador não precisa reler os vectors a cada iteração
+	const float *px = cx.data(), *py = cy.data(), *pz = cz.data();
+	const float *hx = ex.data(), *hy = ey.data(), *hz = ez.data(), *pr = radius.data();
+	uint8_t* out = visible.data();
+
+	//Resultado de 4 objetos (máscara de 4 bits) expandido para 4 bytes 0/1
+	static const uint32_t expand[16] = {
+		0x00000000, 0x00000001, 0x00000100, 0x00000101, 0x00010000, 0x00010001, 0x00010100, 0x00010101,
+		0x01000000, 0x01000001, 0x01000100, 0x01000101, 0x01010000, 0x01010001, 0x01010100, 0x01010101 };
+	static const int bits[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+	for (size_t i = 0; i < padded; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(px + i), y = _mm_loadu_ps(py + i), z = _mm_loadu_ps(pz + i);
+		__m128 sx = _mm_loadu_ps(hx + i), sy = _mm_loadu_ps(hy + i), sz = _mm_loadu_ps(hz + i);
+		__m128 r = _mm_loadu_ps(pr + i);
+		__m128 outside = _mm_setzero_ps();
+		for (int p = 0; p < 6; p++)
+		{
+			//Distância do centro ao plano e raio da caixa projetado na normal
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], x), _mm_mul_ps(ny[p], y)), _mm_add_ps(_mm_mul_ps(nz[p], z), nw[p]));
+			__m128 boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], sx), _mm_mul_ps(ay[p], sy)), _mm_mul_ps(az[p], sz));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, _mm_min_ps(r, boxRadius)), _mm_setzero_ps()));
+		}
+
+		//Os 4 resultados são gravados e comparados com o quadro anterior de uma vez
+		int mask = ~_mm_movemask_ps(outside) & 15;
+		uint32_t previous;
+		memcpy(&previous, out + i, 4);
+		differs |= previous != expand[mask];
+		memcpy(out + i, &expand[mask], 4);
+		visibleCount += bits[mask];
+	}
+#else
+	for (size_t i = 0; i < padded; i++)
+	{
+		bool outside = false;
+		for (int p = 0; p < 6 && !outside; p++)
+		{
+			float d = planes[p].x * cx[i] + planes[p].y * cy[i] + planes[p].z * cz[i] + planes[p].w;
+			float boxRadius = fabsf(planes[p].x) * ex[i] + fabsf(planes[p].y) * ey[i] + fabsf(planes[p].z) * ez[i];
+			outside = d + std::min(radius[i], boxRadius) < 0.0f;
+		}
+		uint8_t v = outside ? 0 : 1;
+		differs |= visible[i] != v;
+		visible[i] = v;
+		visibleCount += v;
+	}
+#endif
+
+	drawn = visibleCount;
+	changed = differs || resized;
+	resized = false;
+}
+
+void FrustumCuller::cull(const glm::mat4& viewProjection, const DynamicBVH& tree)
+{
+	glm::vec4 planes[6];
+	extractFrustumPlanes(viewProjection, planes);
+
+	scratch.assign(visible.size(), 0);
+	int visibleCount = 0;
+	std::vector<uint8_t>& marks = scratch;
+	tree.queryFrustum(planes, [&](int index) {
+		marks[index] = 1;
+		visibleCount++;
+		return true;
+	});
+
+	changed = resized || scratch != visible;
+	resized = false;
+	visible.swap(scratch);
+	drawn = visibleCount;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+#include "Mesh.h"
+#include "DynamicBVH.h"
+
+// Extrai os 6 planos (esquerda, direita, baixo, cima, perto, longe) de
+// projection * view, normalizados e apontando para dentro do frustum
+void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+// Culling por frustum em lote: os volumes de mundo de todas as Mesh ficam em
+// arrays separados (SoA) e são testados de 4 em 4 com SSE contra os 6 planos.
+// Um objeto é descartado quando está inteiro do lado de fora de algum plano,
+// usando o menor entre o raio da esfera e o raio projetado da caixa
+class FrustumCuller
+{
+public:
+	// Copia os volumes de mundo das Mesh modificadas; não faz nada se nenhuma mudou
+	void update(std::vector<Mesh>& meshes);
+	void resize(size_t count);
+	void set(size_t index, const Bounds& world);
+
+	void cull(const glm::mat4& viewProjection);
+	// Mesma saída, mas percorrendo a BVH da cena (userData = índice): em cenas muito
+	// grandes descarta subárvores inteiras. Testa as caixas gordas, então é conservador.
+	// Basta resize() com o número de objetos, sem update()
+	void cull(const glm::mat4& viewProjection, const DynamicBVH& tree);
+
+	bool isVisible(size_t index) const { return visible[index] != 0; }
+	int drawnCount() const { return drawn; }
+	int culledCount() const { return (int)count - drawn; }
+	bool visibilityChanged() const { return changed; } //conjunto visível diferente do último cull
+
+private:
+	size_t count = 0;
+	unsigned long long seenRevision = 0;
+	//Tamanho arredondado para múltiplo de 4; as sobras ficam com volume nulo
+	std::vector<float> cx, cy, cz, ex, ey, ez, radius;
+	std::vector<uint8_t> visible;
+	std::vector<uint8_t> scratch;
+	int drawn = 0;
+	bool changed = true;
+	bool resized = true;
+};
@@ -0,0 +1,49 @@
+#include "GLExtensions.h"
+
+#include <cstring>
+
+PFNGLBUFFERSTORAGEPROC glad_glBufferStorage = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect = nullptr;
+
+GLExtensionSupport glExtensions;
+
+namespace
+{
+	bool hasVersion(int major, int minor)
+	{
+		return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+	}
+
+	bool hasExtension(const char* name)
+	{
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; i++)
+		{
+			const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (extension != nullptr && strcmp(extension, name) == 0)
+				return true;
+		}
+		return false;
+	}
+}
+
+void loadGLExtensions(GLADloadproc load)
+{
+	glExtensions = GLExtensionSupport();
+
+	//Alguns drivers devolvem ponteiros para funções que o contexto não oferece:
+	//a versão ou a extensão decide, o ponteiro só confirma
+	if (hasVersion(4, 4) || hasExtension("GL_ARB_buffer_storage"))
+	{
+		glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+		glExtensions.bufferStorage = glad_glBufferStorage != nullptr;
+	}
+	if (hasVersion(4, 3) || (hasExtension("GL_ARB_multi_draw_indirect") && hasExtension("GL_ARB_shader_storage_buffer_object")))
+	{
+		glad_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+		glExtensions.multiDrawIndirect = glad_glMultiDrawElementsIndirect != nullptr;
+	}
+	//Os shaders pedem a extensão com #extension, então ela precisa estar na lista mesmo na 4.6
+	glExtensions.shaderDrawParameters = hasExtension("GL_ARB_shader_draw_parameters");
+}
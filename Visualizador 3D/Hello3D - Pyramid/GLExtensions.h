@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Funções e constantes de versões acima da 3.3: a GLAD do projeto só carrega o perfil
+// core 3.3, então as usadas aqui são carregadas à mão, com os mesmos nomes da OpenGL.
+// loadGLExtensions é chamada logo depois de gladLoadGLLoader; uma função só pode ser
+// usada se a flag do seu grupo em glExtensions estiver ligada
+
+// GL 4.4 / GL_ARB_buffer_storage
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+extern PFNGLBUFFERSTORAGEPROC glad_glBufferStorage;
+#define glBufferStorage glad_glBufferStorage
+
+// GL 4.3 / GL_ARB_multi_draw_indirect + GL_ARB_shader_storage_buffer_object
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glad_glMultiDrawElementsIndirect
+
+struct GLExtensionSupport
+{
+	bool bufferStorage = false;
+	bool multiDrawIndirect = false;    //glMultiDrawElementsIndirect e shader storage buffers
+	bool shaderDrawParameters = false; //gl_DrawIDARB nos shaders (GL 4.6 / GL_ARB_shader_draw_parameters)
+};
+
+extern GLExtensionSupport glExtensions;
+
+// Carrega as funções e preenche glExtensions conforme a versão e as extensões do contexto atual
+void loadGLExtensions(GLADloadproc load);
@@ -0,0 +1,18 @@
+#include "Geometry.h"
+#include "GeometryPool.h"
+
+Geometry::~Geometry()
+{
+	//Os buffers de uma arena são do pool; a geometria só devolve o seu trecho
+	if (pool != nullptr)
+	{
+		pool->release(*this);
+		return;
+	}
+	if (VAO != 0)
+		glDeleteVertexArrays(1, &VAO);
+	if (VBO != 0)
+		glDeleteBuffers(1, &VBO);
+	if (EBO != 0)
+		glDeleteBuffers(1, &EBO);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+#include "TriangleBVH.h"
+#include "MeshCache.h"
+
+class GeometryPool;
+
+// Geometria enviada para a GPU (VAO + VBO + EBO). É compartilhada entre todas
+// as Mesh que usam o mesmo arquivo; os buffers são liberados no destrutor,
+// quando a última Mesh que a referencia deixa de existir.
+// Vinda do GeometryPool, a geometria não tem buffers próprios: VAO/VBO/EBO são os da
+// arena e ela ocupa os vértices a partir de baseVertex e os índices a partir de firstIndex.
+// No renderizador por software não há OpenGL: os buffers ficam em 0 e a geometria
+// é lida das cópias na CPU
+struct Geometry
+{
+	Geometry() {}
+	~Geometry();
+	Geometry(const Geometry&) = delete;
+	Geometry& operator=(const Geometry&) = delete;
+
+	GLuint VAO = 0;
+	GLuint VBO = 0;
+	GLuint EBO = 0;
+	int nIndices = 0;
+	int nVertices = 0;
+	GLenum indexType = GL_UNSIGNED_INT; //GL_UNSIGNED_SHORT ou GL_UNSIGNED_INT, conforme o EBO
+	GeometryPool* pool = nullptr; //dono dos buffers, se a geometria vier de um pool
+	int poolArena = -1;
+	GLint baseVertex = 0;         //somado aos índices no desenho
+	uint32_t firstIndex = 0;      //primeiro índice no EBO
+	// Deslocamento em bytes do primeiro índice, no formato de glDrawElements
+	const GLvoid* indexOffset() const { return (const GLvoid*)(size_t)(firstIndex * (indexType == GL_UNSIGNED_SHORT ? 2 : 4)); }
+	//Níveis de detalhe (MeshSimplifier.h): intervalos de índices no mesmo EBO, a partir de
+	//firstIndex, com o nível 0 na frente; nIndices conta os índices de todos os níveis.
+	//Vazio quando os níveis não foram gerados: o único nível é a malha inteira
+	std::vector<MeshLod> lods;
+	int lodCount() const { return lods.empty() ? 1 : (int)lods.size(); }
+	int lodIndexCount(int level) const { return lods.empty() ? nIndices : (int)lods[level].indexCount; }
+	uint32_t lodFirstIndex(int level) const { return firstIndex + (lods.empty() ? 0 : lods[level].firstIndex); }
+	const GLvoid* lodIndexOffset(int level) const { return (const GLvoid*)(size_t)(lodFirstIndex(level) * (indexType == GL_UNSIGNED_SHORT ? 2 : 4)); }
+	float lodError(int level) const { return lods.empty() ? 0.0f : lods[level].error; }
+	//Meshlets do nível 0 (Meshlets.h), com firstIndex relativo a firstIndex; vazio quando
+	//não foram gerados
+	std::vector<Meshlet> meshlets;
+	//Vértices compactados (VertexPacking.h): as posições vêm normalizadas em [0, 1] e
+	//positionDecode as leva de volta às coordenadas do modelo; quem envia a matriz de
+	//modelo ao shader usa model * positionDecode. Identidade no layout em floats
+	bool packedVertices = false;
+	glm::mat4 positionDecode = glm::mat4(1.0f);
+	Bounds bounds; //caixa e esfera envolventes, em coordenadas do modelo
+	TriangleBVH triangles; //para a seleção com o mouse (triângulo exato sob o cursor)
+	//Cópia na CPU, preenchida só para o renderizador por software (SoftwareRenderer.h):
+	//vértices no layout de 11 floats do loader e índices em 32 bits
+	std::vector<float> vertices;
+	std::vector<uint32_t> indices;
+};
@@ -0,0 +1,291 @@
+#include "GeometryPool.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+using namespace std;
+
+unsigned long long GeometryPool::revision = 0;
+
+void FreeList::reset(uint32_t capacity)
+{
+	blocks.clear();
+	total = available = capacity;
+	if (capacity > 0)
+		blocks[0] = capacity;
+}
+
+bool FreeList::allocate(uint32_t count, uint32_t& offset)
+{
+	//Menor trecho que serve: os trechos grandes ficam para as malhas grandes
+	map<uint32_t, uint32_t>::iterator best = blocks.end();
+	for (map<uint32_t, uint32_t>::iterator it = blocks.begin(); it != blocks.end(); ++it)
+		if (it->second >= count && (best == blocks.end() || it->second < best->second))
+			best = it;
+	if (best == blocks.end())
+		return false;
+
+	offset = best->first;
+	uint32_t size = best->second;
+	blocks.erase(best);
+	if (size > count)
+		blocks[offset + count] = size - count;
+	available -= count;
+	return true;
+}
+
+void FreeList::free(uint32_t offset, uint32_t count)
+{
+	if (count == 0)
+		return;
+	available += count;
+	map<uint32_t, uint32_t>::iterator next = blocks.lower_bound(offset);
+	//Junta com o trecho seguinte e com o anterior, se encostarem
+	if (next != blocks.end() && offset + count == next->first)
+	{
+		count += next->second;
+		next = blocks.erase(next);
+	}
+	if (next != blocks.begin())
+	{
+		map<uint32_t, uint32_t>::iterator previous = prev(next);
+		if (previous->first + previous->second == offset)
+		{
+			previous->second += count;
+			return;
+		}
+	}
+	blocks[offset] = count;
+}
+
+uint32_t FreeList::largestFree() const
+{
+	uint32_t largest = 0;
+	for (const pair<const uint32_t, uint32_t>& block : blocks)
+		largest = max(largest, block.second);
+	return largest;
+}
+
+GeometryPool::~GeometryPool()
+{
+	//Sem contexto aqui (o pool é global): os buffers já devem ter sido liberados por shutdown
+	detachGeometries();
+}
+
+void GeometryPool::shutdown()
+{
+	detachGeometries();
+	for (unique_ptr<Arena>& arena : arenas)
+	{
+		glDeleteVertexArrays(1, &arena->VAO);
+		glDeleteBuffers(1, &arena->VBO);
+		glDeleteBuffers(1, &arena->EBO);
+	}
+	arenas.clear();
+}
+
+void GeometryPool::detachGeometries()
+{
+	//Geometrias ainda vivas deixam de apontar para o pool
+	for (unique_ptr<Arena>& arena : arenas)
+	{
+		for (Geometry* geometry : arena->geometries)
+		{
+			geometry->pool = nullptr;
+			geometry->VAO = geometry->VBO = geometry->EBO = 0;
+		}
+		arena->geometries.clear();
+	}
+}
+
+void GeometryPool::initialize(size_t arenaVertexBytes, size_t arenaIndexBytes)
+{
+	this->arenaVertexBytes = arenaVertexBytes;
+	this->arenaIndexBytes = arenaIndexBytes;
+}
+
+bool GeometryPool::allocate(Geometry& geometry, const MeshBuffers& buffers)
+{
+	if (!isInitialized() || buffers.indexType != GL_UNSIGNED_INT || buffers.stride == 0)
+		return false;
+
+	//A primeira geometria define o layout; as outras precisam ser iguais
+	if (stride == 0)
+	{
+		stride = buffers.stride;
+		attributes = buffers.attributes;
+	}
+	if (buffers.stride != stride || buffers.attributes.size() != attributes.size())
+		return false;
+	for (size_t i = 0; i < attributes.size(); i++)
+	{
+		const VertexAttribute& a = attributes[i];
+		const VertexAttribute& b = buffers.attributes[i];
+		if (a.location != b.location || a.components != b.components || a.type != b.type || a.normalized != b.normalized || a.offset != b.offset)
+			return false;
+	}
+
+	geometry.nVertices = buffers.vertexCount;
+	geometry.nIndices = buffers.indexCount;
+	geometry.indexType = GL_UNSIGNED_INT;
+	for (unique_ptr<Arena>& arena : arenas)
+		if (allocateIn(*arena, geometry))
+			return true;
+
+	//Espaço há, mas picado: compacta a arena e tenta de novo
+	for (unique_ptr<Arena>& arena : arenas)
+		if (arena->vertices.freeCount() >= buffers.vertexCount && arena->indices.freeCount() >= buffers.indexCount)
+		{
+			compact(*arena);
+			if (allocateIn(*arena, geometry))
+				return true;
+		}
+
+	uint32_t vertexCapacity = (uint32_t)max<size_t>(arenaVertexBytes / stride, buffers.vertexCount);
+	uint32_t indexCapacity = (uint32_t)max<size_t>(arenaIndexBytes / sizeof(uint32_t), buffers.indexCount);
+	return allocateIn(*createArena(vertexCapacity, indexCapacity), geometry);
+}
+
+bool GeometryPool::allocateIn(Arena& arena, Geometry& geometry)
+{
+	uint32_t baseVertex, firstIndex;
+	if (!arena.vertices.allocate(geometry.nVertices, baseVertex))
+		return false;
+	if (!arena.indices.allocate(geometry.nIndices, firstIndex))
+	{
+		arena.vertices.free(baseVertex, geometry.nVertices);
+		return false;
+	}
+
+	geometry.pool = this;
+	geometry.poolArena = -1;
+	for (size_t i = 0; i < arenas.size(); i++)
+		if (arenas[i].get() == &arena)
+			geometry.poolArena = (int)i;
+	geometry.VAO = arena.VAO;
+	geometry.VBO = arena.VBO;
+	geometry.EBO = arena.EBO;
+	geometry.baseVertex = (GLint)baseVertex;
+	geometry.firstIndex = firstIndex;
+	arena.geometries.push_back(&geometry);
+	return true;
+}
+
+void GeometryPool::release(Geometry& geometry)
+{
+	Arena& arena = *arenas[geometry.poolArena];
+	arena.vertices.free((uint32_t)geometry.baseVertex, geometry.nVertices);
+	arena.indices.free(geometry.firstIndex, geometry.nIndices);
+	arena.geometries.erase(find(arena.geometries.begin(), arena.geometries.end(), &geometry));
+	geometry.pool = nullptr;
+	geometry.VAO = geometry.VBO = geometry.EBO = 0;
+}
+
+GeometryPool::Arena* GeometryPool::createArena(uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+	arenas.push_back(unique_ptr<Arena>(new Arena()));
+	Arena& arena = *arenas.back();
+	arena.vertices.reset(vertexCapacity);
+	arena.indices.reset(indexCapacity);
+
+	glGenVertexArrays(1, &arena.VAO);
+	glGenBuffers(1, &arena.VBO);
+	glGenBuffers(1, &arena.EBO);
+	glBindBuffer(GL_ARRAY_BUFFER, arena.VBO);
+	glBufferData(GL_ARRAY_BUFFER, (size_t)vertexCapacity * stride, nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, arena.EBO);
+	glBufferData(GL_COPY_WRITE_BUFFER, (size_t)indexCapacity * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	bindLayout(arena);
+	return &arena;
+}
+
+void GeometryPool::bindLayout(Arena& arena)
+{
+	//Os ponteiros partem do início do VBO; cada desenho desloca os vértices com baseVertex
+	glBindVertexArray(arena.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, arena.VBO);
+	for (const VertexAttribute& attribute : attributes)
+	{
+		glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized, stride, (GLvoid*)(size_t)attribute.offset);
+		glEnableVertexAttribArray(attribute.location);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena.EBO);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GeometryPool::compact(Arena& arena)
+{
+	PROFILE_ZONE("GeometryPool::compact");
+	GLuint VBO, EBO;
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &EBO);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+	glBufferData(GL_COPY_WRITE_BUFFER, (size_t)arena.vertices.capacity() * stride, nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+	glBufferData(GL_COPY_WRITE_BUFFER, (size_t)arena.indices.capacity() * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+
+	//Copia cada geometria para os buffers novos, lado a lado, na ordem em que estavam.
+	//Os índices são relativos a baseVertex, então não mudam
+	vector<Geometry*> byVertex = arena.geometries;
+	sort(byVertex.begin(), byVertex.end(), [](const Geometry* a, const Geometry* b) { return a->baseVertex < b->baseVertex; });
+	uint32_t nextVertex = 0, nextIndex = 0;
+	for (Geometry* geometry : byVertex)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, arena.VBO);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (size_t)geometry->baseVertex * stride, (size_t)nextVertex * stride, (size_t)geometry->nVertices * stride);
+		glBindBuffer(GL_COPY_READ_BUFFER, arena.EBO);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (size_t)geometry->firstIndex * sizeof(uint32_t), (size_t)nextIndex * sizeof(uint32_t), (size_t)geometry->nIndices * sizeof(uint32_t));
+		geometry->baseVertex = (GLint)nextVertex;
+		geometry->firstIndex = nextIndex;
+		geometry->VBO = VBO;
+		geometry->EBO = EBO;
+		nextVertex += geometry->nVertices;
+		nextIndex += geometry->nIndices;
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	//Desenhos já enviados continuam lendo os buffers antigos; a OpenGL só os libera depois
+	glDeleteBuffers(1, &arena.VBO);
+	glDeleteBuffers(1, &arena.EBO);
+	arena.VBO = VBO;
+	arena.EBO = EBO;
+	bindLayout(arena);
+
+	uint32_t vertexCapacity = arena.vertices.capacity(), indexCapacity = arena.indices.capacity();
+	arena.vertices.reset(vertexCapacity);
+	arena.indices.reset(indexCapacity);
+	uint32_t offset;
+	arena.vertices.allocate(nextVertex, offset);
+	arena.indices.allocate(nextIndex, offset);
+	defragmentations++;
+	revision++;
+}
+
+void GeometryPool::defragment()
+{
+	for (unique_ptr<Arena>& arena : arenas)
+		if (arena->vertices.fragments() > 1 || arena->indices.fragments() > 1)
+			compact(*arena);
+}
+
+GeometryPool::Stats GeometryPool::stats() const
+{
+	Stats stats;
+	stats.arenas = (int)arenas.size();
+	stats.defragmentations = defragmentations;
+	for (const unique_ptr<Arena>& arena : arenas)
+	{
+		stats.capacityBytes += (size_t)arena->vertices.capacity() * stride + (size_t)arena->indices.capacity() * sizeof(uint32_t);
+		stats.usedBytes += (size_t)(arena->vertices.capacity() - arena->vertices.freeCount()) * stride
+			+ (size_t)(arena->indices.capacity() - arena->indices.freeCount()) * sizeof(uint32_t);
+		stats.freeFragments += arena->vertices.fragments() + arena->indices.fragments();
+		stats.geometries += (int)arena->geometries.size();
+	}
+	return stats;
+}
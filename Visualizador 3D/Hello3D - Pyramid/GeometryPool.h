@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+#include "Geometry.h"
+#include "MeshCache.h"
+
+// Lista de trechos livres de um buffer, em unidades (vértices ou índices).
+// Reserva pelo menor trecho que serve e junta trechos vizinhos ao liberar
+class FreeList
+{
+public:
+	void reset(uint32_t capacity);
+	bool allocate(uint32_t count, uint32_t& offset);
+	void free(uint32_t offset, uint32_t count);
+
+	uint32_t capacity() const { return total; }
+	uint32_t freeCount() const { return available; }
+	uint32_t largestFree() const;
+	size_t fragments() const { return blocks.size(); }
+
+private:
+	std::map<uint32_t, uint32_t> blocks; //início -> tamanho
+	uint32_t total = 0;
+	uint32_t available = 0;
+};
+
+// Buffers grandes compartilhados por todas as geometrias estáticas com o layout do loader.
+// Cada arena é um VBO + EBO (índices de 32 bits) com um único VAO; uma geometria recebe um
+// trecho de cada (baseVertex/firstIndex) em vez de buffers próprios, e todas as Mesh da
+// arena são desenhadas sem trocar de VAO (glDrawElementsBaseVertex).
+// Quando uma geometria não cabe em nenhum trecho livre, mas a arena tem espaço livre
+// suficiente somado, a arena é compactada: as geometrias vivas são copiadas na GPU para
+// buffers novos, lado a lado, e seus deslocamentos são atualizados. Se nem assim couber,
+// uma arena nova é criada (maior que o padrão, se a malha precisar)
+class GeometryPool
+{
+public:
+	struct Stats
+	{
+		int arenas = 0;
+		size_t capacityBytes = 0;
+		size_t usedBytes = 0;
+		size_t freeFragments = 0;
+		int geometries = 0;
+		int defragmentations = 0;
+	};
+
+	GeometryPool() {}
+	~GeometryPool();
+	GeometryPool(const GeometryPool&) = delete;
+	GeometryPool& operator=(const GeometryPool&) = delete;
+
+	// Tamanho das arenas criadas sob demanda
+	void initialize(size_t arenaVertexBytes, size_t arenaIndexBytes);
+	bool isInitialized() const { return arenaVertexBytes > 0; }
+	// Libera os buffers das arenas; precisa ser chamado com o contexto ainda ativo
+	void shutdown();
+
+	// Reserva o espaço de uma geometria com o layout de buffers (índices de 32 bits) e
+	// preenche VAO/VBO/EBO, baseVertex e firstIndex; os dados são enviados por quem chamou.
+	// Retorna false se o layout for diferente do das arenas (a geometria usa buffers próprios)
+	bool allocate(Geometry& geometry, const MeshBuffers& buffers);
+	// Chamado pelo destrutor da Geometry
+	void release(Geometry& geometry);
+
+	// Compacta todas as arenas com mais de um trecho livre
+	void defragment();
+
+	Stats stats() const;
+
+	//Incrementado a cada compactação, em qualquer pool: as geometrias movidas mudam de
+	//baseVertex/firstIndex, e quem guarda cópias desses valores precisa refazê-las
+	static unsigned long long revision;
+
+private:
+	struct Arena
+	{
+		GLuint VAO = 0;
+		GLuint VBO = 0;
+		GLuint EBO = 0;
+		FreeList vertices;
+		FreeList indices;
+		std::vector<Geometry*> geometries;
+	};
+
+	Arena* createArena(uint32_t vertexCapacity, uint32_t indexCapacity);
+	bool allocateIn(Arena& arena, Geometry& geometry);
+	void compact(Arena& arena);
+	void bindLayout(Arena& arena);
+	void detachGeometries();
+
+	size_t arenaVertexBytes = 0;
+	size_t arenaIndexBytes = 0;
+	//Layout dos atributos de todas as arenas, definido pela primeira geometria
+	uint32_t stride = 0;
+	std::vector<VertexAttribute> attributes;
+	std::vector<std::unique_ptr<Arena> > arenas;
+	int defragmentations = 0;
+};
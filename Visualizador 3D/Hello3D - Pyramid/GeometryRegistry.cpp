@@ -0,0 +1,56 @@
+#include "GeometryRegistry.h"
+
+#include <cstdlib>
+#include <climits>
+#include <tuple>
+
+using namespace std;
+
+bool GeometryRegistry::Key::operator<(const Key& other) const
+{
+	return tie(path, r, g, b) < tie(other.path, other.r, other.g, other.b);
+}
+
+shared_ptr<Geometry> GeometryRegistry::acquire(const string& filepath, glm::vec3 color, const Loader& loader)
+{
+	Key key = { canonicalPath(filepath), color.r, color.g, color.b };
+
+	map<Key, weak_ptr<Geometry>>::iterator it = entries.find(key);
+	if (it != entries.end())
+	{
+		shared_ptr<Geometry> geometry = it->second.lock();
+		if (geometry)
+			return geometry;
+	}
+
+	loads++;
+	shared_ptr<Geometry> geometry = loader(filepath, color);
+	if (geometry)
+		entries[key] = geometry;
+	else
+		entries.erase(key);
+	return geometry;
+}
+
+int GeometryRegistry::liveCount() const
+{
+	int count = 0;
+	for (const auto& entry : entries)
+		if (!entry.second.expired())
+			count++;
+	return count;
+}
+
+string GeometryRegistry::canonicalPath(const string& filepath)
+{
+#ifdef _WIN32
+	char resolved[_MAX_PATH];
+	if (_fullpath(resolved, filepath.c_str(), _MAX_PATH) != nullptr)
+		return resolved;
+#else
+	char resolved[PATH_MAX];
+	if (realpath(filepath.c_str(), resolved) != nullptr)
+		return resolved;
+#endif
+	return filepath;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <memory>
+#include <functional>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Geometry.h"
+
+// Registro das geometrias carregadas, indexado pelo caminho canônico do arquivo
+// (e pela cor gravada nos vértices). Guarda apenas referências fracas: a geometria
+// vive enquanto alguma Mesh a usar, e um novo acquire depois disso recarrega o arquivo
+class GeometryRegistry
+{
+public:
+	typedef std::function<std::shared_ptr<Geometry>(const std::string& filepath, glm::vec3 color)> Loader;
+
+	// Retorna a geometria já carregada do arquivo ou chama loader uma única vez para carregá-la
+	std::shared_ptr<Geometry> acquire(const std::string& filepath, glm::vec3 color, const Loader& loader);
+
+	// Quantas vezes o loader foi chamado (parse + envio para a GPU)
+	int loadCount() const { return loads; }
+	// Quantas geometrias distintas ainda estão vivas
+	int liveCount() const;
+
+	static std::string canonicalPath(const std::string& filepath);
+
+private:
+	struct Key
+	{
+		std::string path;
+		float r, g, b;
+		bool operator<(const Key& other) const;
+	};
+
+	std::map<Key, std::weak_ptr<Geometry>> entries;
+	int loads = 0;
+};
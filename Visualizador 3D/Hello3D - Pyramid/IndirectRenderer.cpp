@@ -0,0 +1,330 @@
+#include "IndirectRenderer.h"
+#include "GeometryPool.h"
+#include "Profiler.h"
+
+#include <map>
+#include <cstring>
+#include <algorithm>
+
+IndirectRenderer::~IndirectRenderer()
+{
+	if (commandBuffer != 0)
+		glDeleteBuffers(1, &commandBuffer);
+	if (drawBuffer != 0)
+		glDeleteBuffers(1, &drawBuffer);
+	if (meshletCommandBuffer != 0)
+		glDeleteBuffers(1, &meshletCommandBuffer);
+	if (drawIndexBuffer != 0)
+		glDeleteBuffers(1, &drawIndexBuffer);
+}
+
+void IndirectRenderer::initialize(UploadRing* ring)
+{
+	this->ring = ring;
+	glGenBuffers(1, &commandBuffer);
+	glGenBuffers(1, &drawBuffer);
+	glGenBuffers(1, &meshletCommandBuffer);
+	glGenBuffers(1, &drawIndexBuffer);
+}
+
+void IndirectRenderer::send(GLuint buffer, size_t offset, const void* data, size_t size)
+{
+	UploadRing::Allocation allocation;
+	if (ring != nullptr && ring->reserve(size, sizeof(glm::vec4), allocation))
+	{
+		memcpy(allocation.data, data, size);
+		ring->commit(allocation);
+		ring->copy(allocation, buffer, offset);
+		return;
+	}
+	if (ring != nullptr)
+		ring->reject(size);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void IndirectRenderer::store(size_t slot, Mesh& mesh)
+{
+	transforms.set(slot, mesh.getPosition(), mesh.getScale(), mesh.getAngle(), mesh.getAxis());
+	draws[slot].color = glm::vec4(mesh.getColor(), 1.0f);
+}
+
+void IndirectRenderer::uploadDraws(size_t first, size_t count)
+{
+	transforms.compose(first, count, &draws[first], sizeof(DrawData));
+	//Vértices compactados trazem a caixa da quantização junto da matriz de modelo
+	for (size_t slot = first; slot < first + count; slot++)
+	{
+		const Geometry* geometry = slotGeometry[meshOfSlot[slot]];
+		if (geometry->packedVertices)
+			draws[slot].model = draws[slot].model * geometry->positionDecode;
+	}
+	send(drawBuffer, first * sizeof(DrawData), &draws[first], count * sizeof(DrawData));
+}
+
+void IndirectRenderer::rebuild(std::vector<Mesh>& meshes)
+{
+	PROFILE_ZONE("IndirectRenderer::rebuild");
+	//Os comandos de cada VAO (arena do pool ou geometria com buffers próprios) ficam
+	//contíguos, para que cada um seja desenhado com uma única chamada
+	std::map<std::pair<GLuint, GLenum>, int> batchIndex;
+	batches.clear();
+	for (const Mesh& mesh : meshes)
+	{
+		std::pair<GLuint, GLenum> key(mesh.geometry->VAO, mesh.geometry->indexType);
+		std::map<std::pair<GLuint, GLenum>, int>::iterator it = batchIndex.find(key);
+		if (it == batchIndex.end())
+		{
+			it = batchIndex.emplace(key, (int)batches.size()).first;
+			Batch batch = { key.first, key.second, mesh.geometry->packedVertices, 0, 0 };
+			batches.push_back(batch);
+		}
+		batches[it->second].count++;
+	}
+	std::vector<size_t> next(batches.size());
+	size_t first = 0;
+	for (size_t b = 0; b < batches.size(); b++)
+	{
+		batches[b].first = next[b] = first;
+		first += batches[b].count;
+	}
+
+	slotGeometry.resize(meshes.size());
+	slotOfMesh.resize(meshes.size());
+	meshOfSlot.resize(meshes.size());
+	commands.resize(meshes.size());
+	draws.resize(meshes.size());
+	transforms.resize(meshes.size());
+	totalTriangles = 0;
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		Geometry* geometry = meshes[i].geometry.get();
+		size_t slot = next[batchIndex[std::make_pair(geometry->VAO, geometry->indexType)]]++;
+		slotGeometry[i] = geometry;
+		slotOfMesh[i] = (uint32_t)slot;
+		meshOfSlot[slot] = (uint32_t)i;
+		int lod = meshes[i].getLod();
+		DrawCommand command = { (GLuint)geometry->lodIndexCount(lod), 1, geometry->lodFirstIndex(lod), geometry->baseVertex, 0 };
+		commands[slot] = command;
+		totalTriangles += (unsigned long long)command.count / 3;
+		store(slot, meshes[i]);
+	}
+	culledCommands = false;
+	visibleTriangles = totalTriangles;
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, commandBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, commands.size() * sizeof(DrawCommand), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, drawBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, draws.size() * sizeof(DrawData), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	if (!meshes.empty())
+	{
+		send(commandBuffer, 0, commands.data(), commands.size() * sizeof(DrawCommand));
+		uploadDraws(0, meshes.size());
+	}
+	lastUploaded = (int)meshes.size();
+}
+
+void IndirectRenderer::sync(std::vector<Mesh>& meshes)
+{
+	lastUploaded = 0;
+
+	//Cena parada e nenhuma geometria movida dentro do pool
+	if (meshes.size() == slotOfMesh.size() && Mesh::revision == seenRevision && GeometryPool::revision == seenPoolRevision)
+		return;
+	unsigned long long previous = seenRevision;
+	seenRevision = Mesh::revision;
+
+	//Uma compactação do pool muda baseVertex/firstIndex de geometrias já nos comandos
+	bool layoutChanged = meshes.size() != slotOfMesh.size() || GeometryPool::revision != seenPoolRevision;
+	seenPoolRevision = GeometryPool::revision;
+	for (size_t i = 0; i < meshes.size() && !layoutChanged; i++)
+		layoutChanged = meshes[i].geometry.get() != slotGeometry[i];
+	if (layoutChanged)
+	{
+		rebuild(meshes);
+		return;
+	}
+
+	//Reenvia só o intervalo que cobre as Mesh modificadas. Uma troca de nível de detalhe
+	//muda só o intervalo de índices do comando, que também é reenviado
+	size_t low = meshes.size(), high = 0;
+	size_t lowCommand = meshes.size(), highCommand = 0;
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		if (meshes[i].modified <= previous)
+			continue;
+		size_t slot = slotOfMesh[i];
+		store(slot, meshes[i]);
+		low = std::min(low, slot);
+		high = std::max(high, slot + 1);
+		lastUploaded++;
+
+		int lod = meshes[i].getLod();
+		DrawCommand& command = commands[slot];
+		GLuint count = (GLuint)slotGeometry[i]->lodIndexCount(lod);
+		GLuint firstIndex = slotGeometry[i]->lodFirstIndex(lod);
+		if (command.count == count && command.firstIndex == firstIndex)
+			continue;
+		totalTriangles += (unsigned long long)count / 3;
+		totalTriangles -= (unsigned long long)command.count / 3;
+		visibleTriangles += (unsigned long long)count / 3 * command.instanceCount;
+		visibleTriangles -= (unsigned long long)command.count / 3 * command.instanceCount;
+		command.count = count;
+		command.firstIndex = firstIndex;
+		lowCommand = std::min(lowCommand, slot);
+		highCommand = std::max(highCommand, slot + 1);
+	}
+	if (low < high)
+		uploadDraws(low, high - low);
+	if (lowCommand < highCommand)
+		send(commandBuffer, lowCommand * sizeof(DrawCommand), &commands[lowCommand], (highCommand - lowCommand) * sizeof(DrawCommand));
+}
+
+void IndirectRenderer::applyVisibility(const FrustumCuller* culler)
+{
+	//Sem nada descartado todos os comandos desenham; com culling, só quando o conjunto
+	//visível muda, e apenas o intervalo dos comandos alterados é reenviado
+	bool culling = culler != nullptr && culler->culledCount() > 0;
+	if (culling ? culledCommands && !culler->visibilityChanged() : !culledCommands)
+		return;
+	culledCommands = culling;
+
+	size_t low = commands.size(), high = 0;
+	visibleTriangles = 0;
+	for (size_t slot = 0; slot < commands.size(); slot++)
+	{
+		GLuint instances = !culling || culler->isVisible(meshOfSlot[slot]) ? 1 : 0;
+		visibleTriangles += (unsigned long long)commands[slot].count / 3 * instances;
+		if (commands[slot].instanceCount == instances)
+			continue;
+		commands[slot].instanceCount = instances;
+		low = std::min(low, slot);
+		high = std::max(high, slot + 1);
+	}
+	if (low < high)
+		send(commandBuffer, low * sizeof(DrawCommand), &commands[low], (high - low) * sizeof(DrawCommand));
+}
+
+void IndirectRenderer::draw(Shader* shader, const FrustumCuller* culler)
+{
+	lastDrawCalls = 0;
+	if (batches.empty())
+	{
+		visibleTriangles = 0;
+		return;
+	}
+	applyVisibility(culler);
+	drawBatches(shader, batches, commandBuffer, false);
+}
+
+void IndirectRenderer::drawMeshlets(std::vector<Mesh>& meshes, Shader* shader, const FrameData& frame, const FrustumCuller* culler)
+{
+	PROFILE_ZONE("IndirectRenderer::drawMeshlets");
+	lastDrawCalls = 0;
+	visibleTriangles = 0;
+	lastMeshletStats = MeshletStats();
+	if (batches.empty())
+		return;
+
+	glm::mat4 viewProjection = frame.projection * frame.view;
+	glm::vec3 cameraPos(frame.cameraPos);
+	meshletCommands.clear();
+	meshletDraws.clear();
+	meshletBatches.clear();
+	for (const Batch& batch : batches)
+	{
+		Batch culled = batch;
+		culled.first = meshletCommands.size();
+		for (size_t slot = batch.first; slot < batch.first + batch.count; slot++)
+		{
+			uint32_t i = meshOfSlot[slot];
+			if (culler != nullptr && !culler->isVisible(i))
+				continue;
+			const Geometry* geometry = slotGeometry[i];
+			DrawCommand command = commands[slot];
+			command.instanceCount = 1;
+			//Nos outros níveis de detalhe, ou sem meshlets, a Mesh sai inteira como no draw
+			if (meshes[i].getLod() != 0 || geometry->meshlets.empty())
+			{
+				meshletCommands.push_back(command);
+				meshletDraws.push_back((GLuint)slot);
+				visibleTriangles += command.count / 3;
+				continue;
+			}
+
+			//Meshlets visíveis seguidos são um trecho contínuo dos índices: um comando só
+			MeshletView view = meshletView(viewProjection, meshes[i].modelMatrix(), cameraPos);
+			bool extending = false;
+			for (const Meshlet& meshlet : geometry->meshlets)
+			{
+				int visibility = classifyMeshlet(meshlet, view);
+				lastMeshletStats.add(meshlet, visibility);
+				if (visibility != MESHLET_VISIBLE)
+				{
+					extending = false;
+					continue;
+				}
+				visibleTriangles += meshlet.triangleCount;
+				if (extending)
+				{
+					meshletCommands.back().count += meshlet.triangleCount * 3;
+					continue;
+				}
+				command.firstIndex = geometry->firstIndex + meshlet.firstIndex;
+				command.count = meshlet.triangleCount * 3;
+				meshletCommands.push_back(command);
+				meshletDraws.push_back((GLuint)slot);
+				extending = true;
+			}
+		}
+		culled.count = meshletCommands.size() - culled.first;
+		if (culled.count > 0)
+			meshletBatches.push_back(culled);
+	}
+	if (meshletCommands.empty())
+		return;
+
+	//Os comandos mudam com a câmera: são reenviados a cada quadro, e os buffers só são
+	//realocados quando crescem
+	if (meshletCommands.size() > meshletCapacity)
+	{
+		meshletCapacity = meshletCommands.size() + meshletCommands.size() / 2;
+		glBindBuffer(GL_COPY_WRITE_BUFFER, meshletCommandBuffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, meshletCapacity * sizeof(DrawCommand), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, drawIndexBuffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, meshletCapacity * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	send(meshletCommandBuffer, 0, meshletCommands.data(), meshletCommands.size() * sizeof(DrawCommand));
+	send(drawIndexBuffer, 0, meshletDraws.data(), meshletDraws.size() * sizeof(GLuint));
+	drawBatches(shader, meshletBatches, meshletCommandBuffer, true);
+}
+
+void IndirectRenderer::drawBatches(Shader* shader, const std::vector<Batch>& drawn, GLuint buffer, bool indexed)
+{
+	shader->use();
+	UniformInt drawOffset = shader->uniformInt("drawOffset");
+	UniformInt octahedralNormals = shader->uniformInt("octahedralNormals");
+	shader->set(shader->uniformInt("indexedDraws"), indexed ? 1 : 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, drawBuffer);
+	if (indexed)
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_INDEX_BINDING, drawIndexBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+	for (const Batch& batch : drawn)
+	{
+		glBindVertexArray(batch.VAO);
+		shader->set(drawOffset, (int)batch.first);
+		shader->set(octahedralNormals, batch.packedVertices ? 1 : 0);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, batch.indexType, (const GLvoid*)(batch.first * sizeof(DrawCommand)), (GLsizei)batch.count, sizeof(DrawCommand));
+		lastDrawCalls++;
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, 0);
+	if (indexed)
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_INDEX_BINDING, 0);
+}
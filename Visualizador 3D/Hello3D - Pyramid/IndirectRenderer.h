@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "Shader.h"
+#include "TransformSystem.h"
+#include "FrustumCuller.h"
+#include "UploadRing.h"
+#include "GLExtensions.h"
+#include "FrameUniforms.h"
+#include "Meshlets.h"
+
+// Desenho indireto: a cena inteira sai em uma chamada glMultiDrawElementsIndirect por VAO,
+// o que com o GeometryPool (uma arena) é uma chamada só, em vez de update() + draw() por Mesh.
+// Cada Mesh tem um comando (índices do seu nível de detalhe, baseVertex e firstIndex) no
+// buffer de comandos e, na mesma posição, sua matriz de modelo e cor num shader storage
+// buffer, que o shader PhongIndirect.vs lê com drawOffset + gl_DrawIDARB.
+// Como no InstanceRenderer, os buffers só são refeitos quando a lista de Mesh (ou a posição
+// das geometrias no pool) muda; fora isso apenas as Mesh modificadas são reenviadas, com as
+// matrizes compostas em lote pelo TransformSystem, e uma troca de nível de detalhe reenvia
+// só o comando. O culling não compacta nada: os comandos dos objetos descartados ficam
+// com instanceCount 0, e só os que mudaram são reenviados.
+// Com os meshlets (drawMeshlets) os comandos são refeitos a cada quadro, um por trecho de
+// meshlets visíveis, e cada um acha os dados da sua Mesh pelo buffer de índices de desenho.
+// Precisa de GL 4.3 (ou GL_ARB_multi_draw_indirect) e de GL_ARB_shader_draw_parameters
+class IndirectRenderer
+{
+public:
+	// Ponto de ligação do buffer de dados por desenho (binding do DrawBuffer no shader)
+	static const GLuint DRAW_DATA_BINDING = 1;
+	// Ponto de ligação da Mesh de cada comando dos meshlets (DrawIndexBuffer no shader)
+	static const GLuint DRAW_INDEX_BINDING = 2;
+
+	IndirectRenderer() {}
+	~IndirectRenderer();
+	IndirectRenderer(const IndirectRenderer&) = delete;
+	IndirectRenderer& operator=(const IndirectRenderer&) = delete;
+
+	// O contexto atual oferece o necessário (ver glExtensions)
+	static bool isSupported() { return glExtensions.multiDrawIndirect && glExtensions.shaderDrawParameters; }
+
+	// ring (opcional) recebe os envios; o IndirectRenderer não chama ring->beginFrame()
+	void initialize(UploadRing* ring = nullptr);
+	// Atualiza comandos e dados por desenho com as Mesh modificadas desde o último sync
+	void sync(std::vector<Mesh>& meshes);
+	// culler (opcional) indica quais Mesh estão visíveis no quadro
+	void draw(Shader* shader, const FrustumCuller* culler = nullptr);
+	// Como draw, mas as Mesh no nível 0 com meshlets (Geometry::meshlets) são testadas meshlet
+	// a meshlet contra o frustum e a câmera de frame (Meshlets.h), e só os que sobram são
+	// desenhados. As outras Mesh saem inteiras
+	void drawMeshlets(std::vector<Mesh>& meshes, Shader* shader, const FrameData& frame, const FrustumCuller* culler = nullptr);
+	const MeshletStats& meshletStats() const { return lastMeshletStats; } //do último drawMeshlets
+	int drawCalls() const { return lastDrawCalls; }
+	unsigned long long triangles() const { return visibleTriangles; } //triângulos enviados no último draw
+	int uploadedDraws() const { return lastUploaded; } //Mesh reenviadas no último sync
+
+private:
+	// Formato lido por glMultiDrawElementsIndirect
+	struct DrawCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// Layout std430 de DrawData no shader: 80 bytes, sem preenchimento
+	struct DrawData
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+	};
+
+	// Comandos seguidos com o mesmo VAO e tipo de índice: uma chamada de desenho
+	struct Batch
+	{
+		GLuint VAO;
+		GLenum indexType;
+		bool packedVertices; //igual para todo o VAO (VertexPacking.h)
+		size_t first;
+		size_t count;
+	};
+
+	void rebuild(std::vector<Mesh>& meshes);
+	void store(size_t slot, Mesh& mesh);
+	void uploadDraws(size_t first, size_t count);
+	void applyVisibility(const FrustumCuller* culler);
+	void send(GLuint buffer, size_t offset, const void* data, size_t size);
+	// indexed: a Mesh de cada comando vem do buffer de índices de desenho
+	void drawBatches(Shader* shader, const std::vector<Batch>& drawn, GLuint buffer, bool indexed);
+
+	std::vector<Batch> batches;
+	std::vector<Geometry*> slotGeometry; //geometria de cada Mesh no último rebuild
+	std::vector<uint32_t> slotOfMesh;    //posição de cada Mesh nos buffers
+	std::vector<uint32_t> meshOfSlot;
+	std::vector<DrawCommand> commands;   //cópias na CPU dos dois buffers
+	std::vector<DrawData> draws;
+	TransformSystem transforms; //na ordem dos buffers
+	unsigned long long seenRevision = 0;
+	unsigned long long seenPoolRevision = 0;
+	GLuint commandBuffer = 0;
+	GLuint drawBuffer = 0;
+	//Comandos dos meshlets visíveis no último quadro e a posição da Mesh de cada um
+	std::vector<DrawCommand> meshletCommands;
+	std::vector<GLuint> meshletDraws;
+	std::vector<Batch> meshletBatches;
+	size_t meshletCapacity = 0;
+	GLuint meshletCommandBuffer = 0;
+	GLuint drawIndexBuffer = 0;
+	MeshletStats lastMeshletStats;
+	UploadRing* ring = nullptr;
+	bool culledCommands = false; //instanceCount dos comandos segue o culler, e não vale 1 em todos
+	unsigned long long totalTriangles = 0;
+	unsigned long long visibleTriangles = 0;
+	int lastDrawCalls = 0;
+	int lastUploaded = 0;
+};
@@ -0,0 +1,359 @@
+#include "InstanceRenderer.h"
+
+#include <cstddef>
+#include <map>
+#include <algorithm>
+
+InstanceRenderer::~InstanceRenderer()
+{
+	if (instanceVBO != 0)
+		glDeleteBuffers(1, &instanceVBO);
+	if (visibleVBO != 0)
+		glDeleteBuffers(1, &visibleVBO);
+}
+
+void InstanceRenderer::initialize(UploadRing* ring)
+{
+	this->ring = ring;
+	glGenBuffers(1, &instanceVBO);
+	glGenBuffers(1, &visibleVBO);
+}
+
+void InstanceRenderer::store(size_t slot, Mesh& mesh)
+{
+	transforms.set(slot, mesh.getPosition(), mesh.getScale(), mesh.getAngle(), mesh.getAxis());
+	colors[slot] = glm::vec4(mesh.getColor(), 1.0f);
+}
+
+void InstanceRenderer::upload(size_t first, size_t count)
+{
+	compacted = false;
+	UploadRing::Allocation allocation;
+	if (ring != nullptr && ring->reserve(count * sizeof(InstanceData), sizeof(glm::vec4), allocation))
+	{
+		write(first, count, (InstanceData*)allocation.data);
+		ring->commit(allocation);
+		ring->copy(allocation, instanceVBO, first * sizeof(InstanceData));
+		return;
+	}
+	if (ring != nullptr)
+		ring->reject(count * sizeof(InstanceData));
+
+	//Mapeia só o trecho alterado (descartando o conteúdo antigo, sem esperar a GPU)
+	//e grava matrizes e cores direto nele
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	InstanceData* mapped = (InstanceData*)glMapBufferRange(GL_ARRAY_BUFFER, first * sizeof(InstanceData), count * sizeof(InstanceData), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	if (mapped != nullptr)
+	{
+		write(first, count, mapped);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceRenderer::write(size_t first, size_t count, InstanceData* out)
+{
+	transforms.compose(first, count, out, sizeof(InstanceData));
+	for (size_t i = 0; i < count; i++)
+	{
+		//Vértices compactados trazem a caixa da quantização junto da matriz de modelo
+		const Geometry* geometry = slotGeometry[meshOfSlot[first + i]];
+		if (geometry->packedVertices)
+			out[i].model = out[i].model * geometry->positionDecode;
+		out[i].color = colors[first + i];
+	}
+}
+
+void InstanceRenderer::writeVisible(const FrustumCuller& culler, InstanceData* out)
+{
+	//Cada sequência de instâncias visíveis vizinhas é composta de uma vez
+	size_t written = 0;
+	for (const Group& group : groups)
+	{
+		Group visible = { group.geometry, group.lod, written, 0 };
+		size_t end = group.first + group.count;
+		for (size_t slot = group.first; slot < end; )
+		{
+			if (!culler.isVisible(meshOfSlot[slot]))
+			{
+				slot++;
+				continue;
+			}
+			size_t run = slot;
+			while (run < end && culler.isVisible(meshOfSlot[run]))
+				run++;
+			write(slot, run - slot, out + written);
+			written += run - slot;
+			slot = run;
+		}
+		visible.count = written - visible.first;
+		if (visible.count > 0)
+			visibleGroups.push_back(visible);
+	}
+}
+
+void InstanceRenderer::compact(const FrustumCuller& culler)
+{
+	visibleGroups.clear();
+	compacted = true;
+	size_t count = culler.drawnCount();
+	UploadRing::Allocation allocation;
+	if (ring != nullptr && count > 0 && ring->reserve(count * sizeof(InstanceData), sizeof(glm::vec4), allocation))
+	{
+		//Com o anel o buffer só é realocado quando cresce; a cópia na GPU fica ordenada
+		//depois dos desenhos que ainda leem o conteúdo antigo
+		if (count > visibleCapacity)
+		{
+			visibleCapacity = count + count / 2;
+			glBindBuffer(GL_ARRAY_BUFFER, visibleVBO);
+			glBufferData(GL_ARRAY_BUFFER, visibleCapacity * sizeof(InstanceData), nullptr, GL_STATIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+		writeVisible(culler, (InstanceData*)allocation.data);
+		ring->commit(allocation);
+		ring->copy(allocation, visibleVBO, 0);
+		return;
+	}
+	if (ring != nullptr)
+		ring->reject(count * sizeof(InstanceData));
+
+	visibleCapacity = count;
+	glBindBuffer(GL_ARRAY_BUFFER, visibleVBO);
+	glBufferData(GL_ARRAY_BUFFER, count * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+	InstanceData* mapped = count > 0 ? (InstanceData*)glMapBufferRange(GL_ARRAY_BUFFER, 0, count * sizeof(InstanceData), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT) : nullptr;
+	if (mapped != nullptr)
+	{
+		writeVisible(culler, mapped);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceRenderer::rebuild(std::vector<Mesh>& meshes)
+{
+	//As instâncias de cada geometria e nível ficam contíguas no buffer, grupo após grupo
+	groupIndex.clear();
+	groups.clear();
+	for (const Mesh& mesh : meshes)
+	{
+		std::pair<Geometry*, int> key(mesh.geometry.get(), mesh.getLod());
+		std::map<std::pair<Geometry*, int>, int>::iterator it = groupIndex.find(key);
+		if (it == groupIndex.end())
+		{
+			it = groupIndex.emplace(key, (int)groups.size()).first;
+			Group group = { key.first, key.second, 0, 0 };
+			groups.push_back(group);
+		}
+		groups[it->second].count++;
+	}
+	size_t first = 0;
+	for (Group& group : groups)
+	{
+		group.first = first;
+		first += group.count;
+	}
+
+	std::vector<size_t> next(groups.size());
+	for (size_t g = 0; g < groups.size(); g++)
+		next[g] = groups[g].first;
+
+	compacted = false;
+	slotGeometry.resize(meshes.size());
+	slotLod.resize(meshes.size());
+	slotOfMesh.resize(meshes.size());
+	meshOfSlot.resize(meshes.size());
+	transforms.resize(meshes.size());
+	colors.resize(meshes.size());
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		Geometry* geometry = meshes[i].geometry.get();
+		size_t slot = next[groupIndex[std::make_pair(geometry, meshes[i].getLod())]]++;
+		slotGeometry[i] = geometry;
+		slotLod[i] = meshes[i].getLod();
+		slotOfMesh[i] = (uint32_t)slot;
+		meshOfSlot[slot] = (uint32_t)i;
+		store(slot, meshes[i]);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, meshes.size() * sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	if (!meshes.empty())
+		upload(0, meshes.size());
+	lastUploaded = (int)meshes.size();
+}
+
+int InstanceRenderer::groupFor(Geometry* geometry, int lod)
+{
+	//Um grupo novo começa vazio no fim do buffer
+	std::pair<Geometry*, int> key(geometry, lod);
+	std::map<std::pair<Geometry*, int>, int>::iterator it = groupIndex.find(key);
+	if (it != groupIndex.end())
+		return it->second;
+	Group group = { geometry, lod, slotOfMesh.size(), 0 };
+	groups.push_back(group);
+	groupIndex.emplace(key, (int)groups.size() - 1);
+	return (int)groups.size() - 1;
+}
+
+void InstanceRenderer::place(std::vector<Mesh>& meshes, uint32_t mesh, size_t slot, std::vector<size_t>& dirty)
+{
+	slotOfMesh[mesh] = (uint32_t)slot;
+	meshOfSlot[slot] = mesh;
+	store(slot, meshes[mesh]);
+	dirty.push_back(slot);
+}
+
+void InstanceRenderer::move(std::vector<Mesh>& meshes, uint32_t mesh, int to, std::vector<size_t>& dirty)
+{
+	//A Mesh sai pela borda do seu grupo voltada para o destino, deixando uma posição livre.
+	//Cada grupo no caminho passa a sua instância da outra ponta para essa posição, e a
+	//posição livre chega ao destino; cada grupo entre os dois reescreve uma instância
+	int from = groupIndex[std::make_pair(slotGeometry[mesh], slotLod[mesh])];
+	size_t slot = slotOfMesh[mesh];
+	if (to > from)
+	{
+		Group& source = groups[from];
+		place(meshes, meshOfSlot[source.first + source.count - 1], slot, dirty);
+		source.count--;
+		for (int g = from + 1; g < to; g++)
+		{
+			Group& group = groups[g];
+			if (group.count > 0)
+				place(meshes, meshOfSlot[group.first + group.count - 1], group.first - 1, dirty);
+			group.first--;
+		}
+		groups[to].first--;
+		place(meshes, mesh, groups[to].first, dirty);
+	}
+	else
+	{
+		Group& source = groups[from];
+		place(meshes, meshOfSlot[source.first], slot, dirty);
+		source.first++;
+		source.count--;
+		for (int g = from - 1; g > to; g--)
+		{
+			Group& group = groups[g];
+			if (group.count > 0)
+				place(meshes, meshOfSlot[group.first], group.first + group.count, dirty);
+			group.first++;
+		}
+		place(meshes, mesh, groups[to].first + groups[to].count, dirty);
+	}
+	groups[to].count++;
+}
+
+void InstanceRenderer::uploadSlots(const std::vector<size_t>& dirty)
+{
+	//Reenviar algumas instâncias intactas custa menos que um envio a mais
+	const size_t MAX_GAP = 32;
+	size_t i = 0;
+	while (i < dirty.size())
+	{
+		size_t first = dirty[i], last = dirty[i];
+		while (i < dirty.size() && dirty[i] <= last + MAX_GAP)
+			last = dirty[i++];
+		upload(first, last - first + 1);
+	}
+}
+
+void InstanceRenderer::sync(std::vector<Mesh>& meshes)
+{
+	lastUploaded = 0;
+
+	//Cena parada: nenhuma Mesh foi modificada desde o último quadro
+	if (meshes.size() == slotOfMesh.size() && Mesh::revision == seenRevision)
+		return;
+	unsigned long long previous = seenRevision;
+	seenRevision = Mesh::revision;
+
+	bool layoutChanged = meshes.size() != slotOfMesh.size();
+	for (size_t i = 0; i < meshes.size() && !layoutChanged; i++)
+		layoutChanged = meshes[i].geometry.get() != slotGeometry[i];
+	if (layoutChanged)
+	{
+		rebuild(meshes);
+		return;
+	}
+
+	//Troca de nível: só as instâncias deslocadas entre os grupos são reescritas
+	dirtySlots.clear();
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		int lod = meshes[i].getLod();
+		if (lod == slotLod[i])
+			continue;
+		move(meshes, (uint32_t)i, groupFor(slotGeometry[i], lod), dirtySlots);
+		slotLod[i] = lod;
+	}
+
+	//e as modificadas
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		if (meshes[i].modified <= previous)
+			continue;
+		size_t slot = slotOfMesh[i];
+		store(slot, meshes[i]);
+		dirtySlots.push_back(slot);
+	}
+	std::sort(dirtySlots.begin(), dirtySlots.end());
+	dirtySlots.erase(std::unique(dirtySlots.begin(), dirtySlots.end()), dirtySlots.end());
+	lastUploaded = (int)dirtySlots.size();
+	uploadSlots(dirtySlots);
+}
+
+void InstanceRenderer::draw(Shader* shader, const FrustumCuller* culler)
+{
+	//Sem nada descartado desenha direto do buffer com todas as instâncias
+	const std::vector<Group>* drawGroups = &groups;
+	GLuint buffer = instanceVBO;
+	if (culler != nullptr && culler->culledCount() > 0)
+	{
+		if (!compacted || culler->visibilityChanged())
+			compact(*culler);
+		drawGroups = &visibleGroups;
+		buffer = visibleVBO;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	shader->use();
+	UniformInt octahedralNormals = shader->uniformInt("octahedralNormals");
+	lastDrawCalls = 0;
+	lastTriangles = 0;
+	GLuint boundVAO = 0;
+	for (const Group& group : *drawGroups)
+	{
+		//Grupos esvaziados pelas trocas de nível continuam na lista até o próximo rebuild
+		if (group.count == 0)
+			continue;
+		Geometry* geometry = group.geometry;
+		//Grupos na mesma arena do GeometryPool dividem o VAO; só os atributos por instância mudam
+		if (geometry->VAO != boundVAO)
+		{
+			glBindVertexArray(geometry->VAO);
+			boundVAO = geometry->VAO;
+		}
+		shader->set(octahedralNormals, geometry->packedVertices ? 1 : 0);
+
+		//Os atributos por instância apontam para o trecho deste grupo no buffer.
+		//A matriz de modelo ocupa 4 localizações (uma por coluna)
+		size_t base = group.first * sizeof(InstanceData);
+		for (int column = 0; column < 4; column++)
+		{
+			glVertexAttribPointer(4 + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (GLvoid*)(base + column * sizeof(glm::vec4)));
+			glEnableVertexAttribArray(4 + column);
+			glVertexAttribDivisor(4 + column, 1);
+		}
+		glVertexAttribPointer(8, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (GLvoid*)(base + offsetof(InstanceData, color)));
+		glEnableVertexAttribArray(8);
+		glVertexAttribDivisor(8, 1);
+
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, geometry->lodIndexCount(group.lod), geometry->indexType, geometry->lodIndexOffset(group.lod), (GLsizei)group.count, geometry->baseVertex);
+		lastDrawCalls++;
+		lastTriangles += (unsigned long long)geometry->lodIndexCount(group.lod) / 3 * group.count;
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
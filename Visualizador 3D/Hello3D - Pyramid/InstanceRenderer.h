@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <map>
+
+#include <glad/glad.h>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "Shader.h"
+#include "TransformSystem.h"
+#include "FrustumCuller.h"
+#include "UploadRing.h"
+
+// Desenho instanciado: agrupa as Mesh que compartilham a mesma geometria e nível de detalhe,
+// mantém as matrizes de modelo e cores de todas elas num buffer de instâncias
+// persistente e desenha cada grupo com um só glDrawElementsInstanced.
+// O buffer só é refeito quando a lista de Mesh (ou a geometria de alguma) muda; uma Mesh que troca
+// de nível passa de um grupo para o outro deslocando só as bordas dos grupos entre os dois.
+// Fora isso apenas as Mesh modificadas são reenviadas, e uma cena parada não custa nada na CPU.
+// As matrizes são compostas em lote pelo TransformSystem direto no buffer mapeado.
+// Com culling, as instâncias visíveis são compactadas num segundo buffer, refeito
+// só quando o conjunto visível ou alguma instância muda.
+// Com um UploadRing os dados são escritos no anel e copiados para os buffers na GPU,
+// sem mapear buffers que ainda podem estar em uso.
+// Usa o shader PhongInstanced.vs, que lê model/cor dos atributos 4 a 8
+class InstanceRenderer
+{
+public:
+	InstanceRenderer() {}
+	~InstanceRenderer();
+	// ring (opcional) recebe os envios; o InstanceRenderer não chama ring->beginFrame()
+	void initialize(UploadRing* ring = nullptr);
+	// Atualiza o buffer de instâncias com as Mesh modificadas desde o último sync
+	void sync(std::vector<Mesh>& meshes);
+	// culler (opcional) indica quais Mesh estão visíveis no quadro
+	void draw(Shader* shader, const FrustumCuller* culler = nullptr);
+	int drawCalls() const { return lastDrawCalls; }
+	unsigned long long triangles() const { return lastTriangles; } //triângulos enviados no último draw
+	int uploadedInstances() const { return lastUploaded; } //instâncias enviadas no último sync
+
+private:
+	struct InstanceData
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+	};
+
+	struct Group
+	{
+		Geometry* geometry;
+		int lod;
+		size_t first;
+		size_t count;
+	};
+
+	void rebuild(std::vector<Mesh>& meshes);
+	void store(size_t slot, Mesh& mesh);
+	// Leva a Mesh para o grupo to; as posições reescritas vão para dirty
+	void move(std::vector<Mesh>& meshes, uint32_t mesh, int to, std::vector<size_t>& dirty);
+	void place(std::vector<Mesh>& meshes, uint32_t mesh, size_t slot, std::vector<size_t>& dirty);
+	int groupFor(Geometry* geometry, int lod);
+	void upload(size_t first, size_t count);
+	// Envia as posições em dirty (ordenadas, sem repetição), juntando as próximas num só envio
+	void uploadSlots(const std::vector<size_t>& dirty);
+	void compact(const FrustumCuller& culler);
+	void write(size_t first, size_t count, InstanceData* out);
+	void writeVisible(const FrustumCuller& culler, InstanceData* out);
+
+	std::vector<Group> groups;
+	std::map<std::pair<Geometry*, int>, int> groupIndex; //grupo de cada geometria e nível
+	std::vector<Geometry*> slotGeometry; //geometria de cada Mesh no último rebuild
+	std::vector<int> slotLod;            //e nível de detalhe
+	std::vector<uint32_t> slotOfMesh;    //posição de cada Mesh no buffer de instâncias
+	std::vector<uint32_t> meshOfSlot;
+	std::vector<size_t> dirtySlots;
+	std::vector<Group> visibleGroups;    //grupos no buffer compactado
+	TransformSystem transforms; //na ordem do buffer de instâncias
+	std::vector<glm::vec4> colors;
+	unsigned long long seenRevision = 0;
+	GLuint instanceVBO = 0;
+	GLuint visibleVBO = 0;
+	size_t visibleCapacity = 0; //instâncias que cabem no visibleVBO
+	UploadRing* ring = nullptr;
+	bool compacted = false; //visibleVBO corresponde às instâncias e visibilidade atuais
+	int lastDrawCalls = 0;
+	unsigned long long lastTriangles = 0;
+	int lastUploaded = 0;
+};
@@ -0,0 +1,102 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open(const std::string& filepath)
+{
+	close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	fileHandle = file;
+	length = (size_t)fileSize.QuadPart;
+	opened = true;
+
+	//Arquivo vazio não pode ser mapeado, mas é um arquivo válido
+	if (length == 0)
+		return true;
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		close();
+		return false;
+	}
+	mappingHandle = mapping;
+
+	bytes = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (bytes == nullptr)
+	{
+		close();
+		return false;
+	}
+#else
+	fd = ::open(filepath.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		fd = -1;
+		return false;
+	}
+	length = (size_t)st.st_size;
+	opened = true;
+
+	if (length == 0)
+		return true;
+
+	void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (view == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	//O parser percorre o arquivo do início ao fim uma única vez
+	madvise(view, length, MADV_SEQUENTIAL);
+	bytes = (const char*)view;
+#endif
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (bytes != nullptr)
+		UnmapViewOfFile(bytes);
+	if (mappingHandle != nullptr)
+		CloseHandle((HANDLE)mappingHandle);
+	if (fileHandle != nullptr)
+		CloseHandle((HANDLE)fileHandle);
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	if (bytes != nullptr)
+		munmap((void*)bytes, length);
+	if (fd >= 0)
+		::close(fd);
+	fd = -1;
+#endif
+	bytes = nullptr;
+	length = 0;
+	opened = false;
+}
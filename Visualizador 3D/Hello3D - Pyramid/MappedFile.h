@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Arquivo mapeado em memória somente para leitura.
+// O conteúdo fica acessível por data()/size() enquanto o objeto existir,
+// sem nenhuma cópia para buffers intermediários.
+class MappedFile
+{
+public:
+	MappedFile() {}
+	~MappedFile() { close(); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& filepath);
+	void close();
+	const char* data() const { return bytes; }
+	size_t size() const { return length; }
+	bool isOpen() const { return opened; }
+
+private:
+	const char* bytes = nullptr;
+	size_t length = 0;
+	bool opened = false;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#else
+	int fd = -1;
+#endif
+};
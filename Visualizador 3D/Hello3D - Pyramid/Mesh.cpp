@@ -1,32 +1,149 @@
 #include "Mesh.h"
+#include "Profiler.h"
 
-void Mesh::initialize(GLuint VAO, int nVertices, Shader* shader, glm::vec3 position, glm::vec3 color, glm::vec3 scale, float angle, glm::vec3 axis)
+unsigned long long Mesh::revision = 0;
+
+void Mesh::initialize(std::shared_ptr<Geometry> geometry, Shader* shader, glm::vec3 position, glm::vec3 color, glm::vec3 scale, float angle, glm::vec3 axis)
 {
-	this->VAO = VAO;
-	this->nVertices = nVertices;
+	this->geometry = geometry;
 	this->shader = shader;
+	//Sem shader (renderizador por software) não há uniforms para resolver
+	if (shader != nullptr)
+	{
+		this->modelUniform = shader->uniformMat4("model");
+		this->colorUniform = shader->uniformVec3("inputColor");
+		this->octahedralUniform = shader->uniformInt("octahedralNormals");
+	}
 	this->position = position;
 	this->scale = scale;
 	this->angle = angle;
 	this->axis = axis;
 	this->color = color;
 	this->defaultColor = color;
+	this->lod = 0;
+	touch(true);
+}
+
+void Mesh::touch(bool transform)
+{
+	if (transform)
+		modelDirty = boundsDirty = true;
+	modified = ++revision;
+}
+
+void Mesh::setPosition(glm::vec3 position)
+{
+	this->position = position;
+	touch(true);
+}
+
+void Mesh::translate(glm::vec3 offset)
+{
+	position += offset;
+	touch(true);
+}
+
+void Mesh::setScale(glm::vec3 scale)
+{
+	this->scale = scale;
+	touch(true);
+}
+
+void Mesh::setRotation(float angle, glm::vec3 axis)
+{
+	this->angle = angle;
+	this->axis = axis;
+	touch(true);
+}
+
+void Mesh::rotate(float delta, glm::vec3 axis)
+{
+	this->angle += delta;
+	this->axis = axis;
+	touch(true);
+}
+
+void Mesh::setColor(glm::vec3 color)
+{
+	if (color == this->color)
+		return;
+	this->color = color;
+	touch(false);
+}
+
+void Mesh::setLod(int level)
+{
+	if (level == lod)
+		return;
+	lod = level;
+	touch(false);
+}
+
+void Mesh::chooseLod(glm::vec3 cameraPos, float pixelsPerUnit, float maxPixels)
+{
+	//O erro da geometria está em coordenadas do modelo: a maior escala o leva para o mundo.
+	//A distância é até a superfície da esfera envolvente, o ponto mais próximo possível
+	const Bounds& world = worldBounds();
+	float distance = glm::max(glm::length(world.center - cameraPos) - world.radius, 1e-4f);
+	float scaleFactor = glm::max(glm::abs(scale.x), glm::max(glm::abs(scale.y), glm::abs(scale.z)));
+	int level = 0;
+	while (level + 1 < geometry->lodCount() && geometry->lodError(level + 1) * scaleFactor / distance * pixelsPerUnit <= maxPixels)
+		level++;
+	setLod(level);
+}
+
+const glm::mat4& Mesh::modelMatrix()
+{
+	if (modelDirty)
+	{
+		model = glm::mat4(1);
+		model = glm::translate(model, position);
+		model = glm::rotate(model, glm::radians(angle), axis);
+		model = glm::scale(model, scale);
+		modelDirty = false;
+	}
+	return model;
+}
+
+const Bounds& Mesh::worldBounds()
+{
+	if (boundsDirty)
+	{
+		bounds = transformBounds(geometry->bounds, modelMatrix());
+		boundsDirty = false;
+	}
+	return bounds;
 }
 
 void Mesh::update()
 {
-	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, position);
-	model = glm::rotate(model, glm::radians(angle), axis);
-	model = glm::scale(model, scale);
-	shader->setMat4("model", glm::value_ptr(model));
-	shader->setVec3("inputColor", color.r, color.g, color.b);
+	PROFILE_ZONE("Mesh::update");
+	//O uniform model é estado do programa, compartilhado por todas as Mesh,
+	//então é enviado a cada desenho; só o cálculo da matriz é evitado
+	//Vértices compactados trazem a caixa da quantização junto da matriz de modelo
+	if (geometry->packedVertices)
+		shader->set(modelUniform, glm::value_ptr(modelMatrix() * geometry->positionDecode));
+	else
+		shader->set(modelUniform, glm::value_ptr(modelMatrix()));
+	shader->set(colorUniform, color.r, color.g, color.b);
+	shader->set(octahedralUniform, geometry->packedVertices ? 1 : 0);
 
 }
 
 void Mesh::draw()
 {
-	glBindVertexArray(VAO);
-	glDrawArrays(GL_TRIANGLES, 0, nVertices);
+	GLuint boundVAO = 0;
+	draw(boundVAO);
 	glBindVertexArray(0);
+}
+
+void Mesh::draw(GLuint& boundVAO)
+{
+	PROFILE_ZONE("Mesh::draw");
+	if (geometry->VAO != boundVAO)
+	{
+		glBindVertexArray(geometry->VAO);
+		boundVAO = geometry->VAO;
+	}
+	glDrawElementsBaseVertex(GL_TRIANGLES, geometry->lodIndexCount(lod), geometry->indexType, geometry->lodIndexOffset(lod), geometry->baseVertex);
 }
\ No newline at end of file
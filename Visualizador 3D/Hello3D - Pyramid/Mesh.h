@@ -5,24 +5,70 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <memory>
+
 #include "Shader.h"
+#include "Geometry.h"
 
 class Mesh
 {
 public:
 	Mesh() {}
 	~Mesh() {}
-	void initialize(GLuint VAO, int nVertices, Shader* shader, glm::vec3 position = glm::vec3(0.0f), glm::vec3 color = glm::vec3(0.0, 0.0, 1.0), glm::vec3 scale = glm::vec3(1), float angle = 0.0, glm::vec3 axis = glm::vec3(0.0, 0.0, 1.0));
+	void initialize(std::shared_ptr<Geometry> geometry, Shader* shader, glm::vec3 position = glm::vec3(0.0f), glm::vec3 color = glm::vec3(0.0, 0.0, 1.0), glm::vec3 scale = glm::vec3(1), float angle = 0.0, glm::vec3 axis = glm::vec3(0.0, 0.0, 1.0));
 	void update();
+	const glm::mat4& modelMatrix(); //recalculada só quando a transformação mudou
+	const Bounds& worldBounds(); //volumes da geometria em coordenadas de mundo, também em cache
 	void draw();
-	GLuint VAO;
-	int nVertices;
+	// Desenha sem desvincular o VAO; boundVAO guarda o último vinculado, para que Mesh
+	// seguidas na mesma arena do GeometryPool não troquem de VAO
+	void draw(GLuint& boundVAO);
+
+	//Alterações de transformação e cor passam pelos setters, que marcam a Mesh como modificada
+	void setPosition(glm::vec3 position);
+	void translate(glm::vec3 offset);
+	void setScale(glm::vec3 scale);
+	void setRotation(float angle, glm::vec3 axis);
+	void rotate(float delta, glm::vec3 axis); //troca o eixo e acumula o ângulo
+	void setColor(glm::vec3 color);
+	void setDefaultColor(glm::vec3 color) { defaultColor = color; }
+	void setLod(int level); //nível de detalhe desenhado (Geometry::lods)
+	// Escolhe o nível mais simples cujo erro, projetado na tela a partir de cameraPos, não
+	// passa de maxPixels. pixelsPerUnit: pixels por unidade de comprimento à distância 1
+	// (altura da tela / (2 tan(fov / 2)))
+	void chooseLod(glm::vec3 cameraPos, float pixelsPerUnit, float maxPixels);
+
+	glm::vec3 getPosition() const { return position; }
+	glm::vec3 getScale() const { return scale; }
+	float getAngle() const { return angle; }
+	glm::vec3 getAxis() const { return axis; }
+	glm::vec3 getColor() const { return color; }
+	glm::vec3 getDefaultColor() const { return defaultColor; }
+	int getLod() const { return lod; }
+
+	std::shared_ptr<Geometry> geometry; //compartilhada entre as Mesh do mesmo arquivo
+	Shader* shader;
+	UniformMat4 modelUniform; //resolvidos uma vez em initialize
+	UniformVec3 colorUniform;
+	UniformInt octahedralUniform;
+	//Incrementado a cada modificação de qualquer Mesh; se não mudou, a cena está parada.
+	//Cada Mesh guarda o valor da sua última modificação, então quem consome as mudanças
+	//(instâncias, culling, BVH) só precisa lembrar a última revisão que viu
+	static unsigned long long revision;
+	unsigned long long modified = 0;
+
+private:
+	void touch(bool transform);
+
 	glm::vec3 position;
 	float angle;
 	glm::vec3 axis;
 	glm::vec3 scale;
 	glm::vec3 color;
 	glm::vec3 defaultColor;
-	Shader* shader;
-
+	int lod = 0;
+	glm::mat4 model = glm::mat4(1);
+	bool modelDirty = true;
+	Bounds bounds;
+	bool boundsDirty = true;
 };
\ No newline at end of file
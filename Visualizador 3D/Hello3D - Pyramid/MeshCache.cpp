@@ -0,0 +1,232 @@
+#include "MeshCache.h"
+#include "Profiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace
+{
+	const char MESH_CACHE_MAGIC[8] = { 'V', '3', 'D', 'M', 'E', 'S', 'H', '\0' };
+
+	struct MeshCacheHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t pathLength;
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		float color[3];
+		uint32_t vertexCount;
+		uint32_t stride;
+		uint32_t indexCount;
+		uint32_t indexType;
+		uint32_t attributeCount;
+		uint32_t lodCount;
+		uint32_t meshletCount;
+		uint32_t optimized;
+		uint32_t packed;
+		float positionOffset[3];
+		float positionScale[3];
+		uint64_t vertexOffset;
+		uint64_t vertexBytes;
+		uint64_t indexOffset;
+		uint64_t indexBytes;
+	};
+
+	bool fileStamp(const string& filepath, uint64_t& size, int64_t& time)
+	{
+#ifdef _WIN32
+		struct _stat64 st;
+		if (_stat64(filepath.c_str(), &st) != 0)
+			return false;
+#else
+		struct stat st;
+		if (stat(filepath.c_str(), &st) != 0)
+			return false;
+#endif
+		size = (uint64_t)st.st_size;
+		time = (int64_t)st.st_mtime;
+		return true;
+	}
+
+	uint64_t alignTo(uint64_t offset, uint64_t alignment)
+	{
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+}
+
+void buildMeshBuffers(const MeshData& mesh, vector<uint16_t>& shortIndices, MeshBuffers& buffers)
+{
+	buffers.vertices = mesh.vertices.data();
+	buffers.vertexBytes = mesh.vertices.size() * sizeof(float);
+	buffers.vertexCount = (uint32_t)mesh.vertexCount();
+	buffers.stride = OBJ_FLOATS_PER_VERTEX * sizeof(float);
+	buffers.indexCount = (uint32_t)mesh.indices.size();
+
+	//Índices de 16 bits bastam quando a malha tem até 65536 vértices únicos
+	if (mesh.vertexCount() <= 65536)
+	{
+		shortIndices.assign(mesh.indices.begin(), mesh.indices.end());
+		buffers.indices = shortIndices.data();
+		buffers.indexBytes = shortIndices.size() * sizeof(uint16_t);
+		buffers.indexType = GL_UNSIGNED_SHORT;
+	}
+	else
+	{
+		buffers.indices = mesh.indices.data();
+		buffers.indexBytes = mesh.indices.size() * sizeof(uint32_t);
+		buffers.indexType = GL_UNSIGNED_INT;
+	}
+
+	//Posição, cor, coordenada de textura e normal (mesma ordem do Phong.vs)
+	buffers.attributes = {
+		{ 0, 3, GL_FLOAT, GL_FALSE, 0 },
+		{ 1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float) },
+		{ 2, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float) },
+		{ 3, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float) }
+	};
+}
+
+string MeshCache::cachePath(const string& objPath)
+{
+	return objPath + ".meshcache";
+}
+
+bool MeshCache::open(const string& objPath, glm::vec3 color)
+{
+	PROFILE_ZONE("MeshCache::open");
+	close();
+
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	if (!fileStamp(objPath, sourceSize, sourceTime))
+		return false;
+	if (!file.open(cachePath(objPath)) || file.size() < sizeof(MeshCacheHeader))
+	{
+		close();
+		return false;
+	}
+
+	MeshCacheHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	const char* path = file.data() + sizeof(header);
+
+	bool valid = memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) == 0
+		&& header.version == MESH_CACHE_VERSION
+		&& header.sourceSize == sourceSize && header.sourceTime == sourceTime
+		&& header.color[0] == color.r && header.color[1] == color.g && header.color[2] == color.b
+		&& sizeof(header) + header.pathLength + header.attributeCount * sizeof(VertexAttribute) + header.lodCount * sizeof(MeshLod) + (uint64_t)header.meshletCount * sizeof(Meshlet) <= file.size()
+		&& header.pathLength == objPath.size() && memcmp(path, objPath.data(), objPath.size()) == 0
+		&& header.vertexOffset + header.vertexBytes <= file.size()
+		&& header.indexOffset + header.indexBytes <= file.size()
+		//Os tamanhos precisam bater com as contagens, que são o que o BVH e os envios usam
+		&& (header.indexType == GL_UNSIGNED_SHORT || header.indexType == GL_UNSIGNED_INT)
+		&& header.vertexBytes == (uint64_t)header.vertexCount * header.stride
+		&& header.indexBytes == (uint64_t)header.indexCount * (header.indexType == GL_UNSIGNED_SHORT ? 2 : 4);
+	if (!valid)
+	{
+		close();
+		return false;
+	}
+
+	//As tabelas vêm logo depois do caminho, sem alinhamento: são copiadas, e não lidas
+	//direto do arquivo mapeado
+	const char* table = path + header.pathLength;
+	view.attributes.resize(header.attributeCount);
+	memcpy(view.attributes.data(), table, header.attributeCount * sizeof(VertexAttribute));
+	table += header.attributeCount * sizeof(VertexAttribute);
+	view.lods.resize(header.lodCount);
+	memcpy(view.lods.data(), table, header.lodCount * sizeof(MeshLod));
+	table += header.lodCount * sizeof(MeshLod);
+	view.meshlets.resize(header.meshletCount);
+	memcpy(view.meshlets.data(), table, header.meshletCount * sizeof(Meshlet));
+
+	//Níveis e meshlets são trechos dos índices
+	for (const MeshLod& lod : view.lods)
+		valid = valid && (uint64_t)lod.firstIndex + lod.indexCount <= header.indexCount;
+	for (const Meshlet& meshlet : view.meshlets)
+		valid = valid && (uint64_t)meshlet.firstIndex + (uint64_t)meshlet.triangleCount * 3 <= header.indexCount;
+	if (!valid)
+	{
+		close();
+		return false;
+	}
+
+	view.vertices = file.data() + header.vertexOffset;
+	view.vertexBytes = (size_t)header.vertexBytes;
+	view.vertexCount = header.vertexCount;
+	view.stride = header.stride;
+	view.indices = file.data() + header.indexOffset;
+	view.indexBytes = (size_t)header.indexBytes;
+	view.indexCount = header.indexCount;
+	view.indexType = header.indexType;
+	view.optimized = header.optimized != 0;
+	view.packed = header.packed != 0;
+	view.positionOffset = glm::vec3(header.positionOffset[0], header.positionOffset[1], header.positionOffset[2]);
+	view.positionScale = glm::vec3(header.positionScale[0], header.positionScale[1], header.positionScale[2]);
+	return true;
+}
+
+bool MeshCache::write(const string& objPath, glm::vec3 color, const MeshBuffers& buffers)
+{
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	if (!fileStamp(objPath, header.sourceSize, header.sourceTime))
+		return false;
+
+	memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+	header.version = MESH_CACHE_VERSION;
+	header.pathLength = (uint32_t)objPath.size();
+	header.color[0] = color.r;  header.color[1] = color.g;  header.color[2] = color.b;
+	header.vertexCount = buffers.vertexCount;
+	header.stride = buffers.stride;
+	header.indexCount = buffers.indexCount;
+	header.indexType = buffers.indexType;
+	header.attributeCount = (uint32_t)buffers.attributes.size();
+	header.lodCount = (uint32_t)buffers.lods.size();
+	header.meshletCount = (uint32_t)buffers.meshlets.size();
+	header.optimized = buffers.optimized ? 1 : 0;
+	header.packed = buffers.packed ? 1 : 0;
+	memcpy(header.positionOffset, &buffers.positionOffset[0], sizeof(header.positionOffset));
+	memcpy(header.positionScale, &buffers.positionScale[0], sizeof(header.positionScale));
+
+	//Os dados ficam alinhados para poderem ser usados direto do arquivo mapeado
+	uint64_t offset = sizeof(header) + header.pathLength + header.attributeCount * sizeof(VertexAttribute) + header.lodCount * sizeof(MeshLod) + (uint64_t)header.meshletCount * sizeof(Meshlet);
+	header.vertexOffset = alignTo(offset, 16);
+	header.vertexBytes = buffers.vertexBytes;
+	header.indexOffset = alignTo(header.vertexOffset + header.vertexBytes, 16);
+	header.indexBytes = buffers.indexBytes;
+
+	//Grava num arquivo temporário e só então substitui o cache antigo,
+	//para que uma gravação interrompida nunca deixe um cache pela metade
+	string path = cachePath(objPath);
+	string tmpPath = path + ".tmp";
+	FILE* f = fopen(tmpPath.c_str(), "wb");
+	if (f == nullptr)
+		return false;
+
+	const char zeros[16] = { 0 };
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+		&& fwrite(objPath.data(), 1, objPath.size(), f) == objPath.size()
+		&& (header.attributeCount == 0 || fwrite(buffers.attributes.data(), sizeof(VertexAttribute), header.attributeCount, f) == header.attributeCount)
+		&& (header.lodCount == 0 || fwrite(buffers.lods.data(), sizeof(MeshLod), header.lodCount, f) == header.lodCount)
+		&& (header.meshletCount == 0 || fwrite(buffers.meshlets.data(), sizeof(Meshlet), header.meshletCount, f) == header.meshletCount)
+		&& fwrite(zeros, 1, (size_t)(header.vertexOffset - offset), f) == header.vertexOffset - offset
+		&& fwrite(buffers.vertices, 1, buffers.vertexBytes, f) == buffers.vertexBytes
+		&& fwrite(zeros, 1, (size_t)(header.indexOffset - header.vertexOffset - header.vertexBytes), f) == header.indexOffset - header.vertexOffset - header.vertexBytes
+		&& fwrite(buffers.indices, 1, buffers.indexBytes, f) == buffers.indexBytes;
+	ok = fclose(f) == 0 && ok;
+
+	if (ok)
+	{
+		remove(path.c_str());
+		ok = rename(tmpPath.c_str(), path.c_str()) == 0;
+	}
+	if (!ok)
+		remove(tmpPath.c_str());
+	return ok;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "MappedFile.h"
+#include "ObjLoader.h"
+
+// Versão do formato do cache; caches de outras versões são descartados e refeitos
+const uint32_t MESH_CACHE_VERSION = 5;
+
+// Descrição de um atributo de vértice, no formato dos parâmetros de glVertexAttribPointer
+struct VertexAttribute
+{
+	uint32_t location;
+	uint32_t components;
+	uint32_t type;
+	uint32_t normalized;
+	uint32_t offset;
+};
+
+// Nível de detalhe: trecho do buffer de índices desenhado no lugar da malha completa,
+// sobre os mesmos vértices. error é o desvio máximo estimado da superfície original,
+// em unidades do modelo (0 no nível 0, a malha completa)
+struct MeshLod
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error;
+};
+
+// Meshlet (Meshlets.h): até MESHLET_MAX_TRIANGLES triângulos seguidos no buffer de índices
+// do nível 0, usando até MESHLET_MAX_VERTICES vértices. center/radius envolvem os vértices
+// e o cone (eixo e coneCutoff, o seno do ângulo de abertura) contém as normais dos
+// triângulos, com o vértice coneApex atrás do plano de todos eles, em coordenadas do
+// modelo; coneCutoff 1 indica um cone que não permite descarte
+struct Meshlet
+{
+	uint32_t firstIndex;
+	uint32_t triangleCount;
+	uint32_t vertexCount;
+	glm::vec3 center;
+	float radius;
+	glm::vec3 coneAxis;
+	float coneCutoff;
+	glm::vec3 coneApex;
+};
+
+// Buffers de vértices e índices prontos para glBufferData, com o layout dos atributos.
+// Os ponteiros apontam para memória de quem montou a estrutura (MeshData ou cache mapeado)
+struct MeshBuffers
+{
+	const void* vertices = nullptr;
+	size_t vertexBytes = 0;
+	uint32_t vertexCount = 0;
+	uint32_t stride = 0;
+	const void* indices = nullptr;
+	size_t indexBytes = 0;
+	uint32_t indexCount = 0;
+	GLenum indexType = GL_UNSIGNED_INT;
+	std::vector<VertexAttribute> attributes;
+	//Níveis de detalhe, todos dentro de indices; vazio se não foram gerados (um nível só,
+	//com todos os índices)
+	std::vector<MeshLod> lods;
+	//Ordem de triângulos e vértices otimizada para o cache de vértices e o overdraw
+	//(MeshOptimizer.h)
+	bool optimized = false;
+	//Meshlets do nível 0, que ficam com os triângulos agrupados; vazio se não foram gerados
+	std::vector<Meshlet> meshlets;
+	//Vértices compactados (VertexPacking.h): a posição decodificada é
+	//positionOffset + positionScale * valor normalizado
+	bool packed = false;
+	glm::vec3 positionOffset = glm::vec3(0.0f);
+	glm::vec3 positionScale = glm::vec3(1.0f);
+};
+
+// Monta os buffers de uma malha no layout de 11 floats do loader.
+// Se a malha tem até 65536 vértices os índices são convertidos para 16 bits em shortIndices
+void buildMeshBuffers(const MeshData& mesh, std::vector<uint16_t>& shortIndices, MeshBuffers& buffers);
+
+// Cache binário da geometria já processada, gravado ao lado do .obj (<arquivo>.meshcache).
+// É válido apenas para o mesmo caminho, tamanho e data de modificação do .obj e a mesma cor
+class MeshCache
+{
+public:
+	// Mapeia o cache de objPath; retorna false se não existir ou estiver desatualizado
+	bool open(const std::string& objPath, glm::vec3 color);
+	void close() { file.close(); }
+	const MeshBuffers& buffers() const { return view; }
+
+	static bool write(const std::string& objPath, glm::vec3 color, const MeshBuffers& buffers);
+	static std::string cachePath(const std::string& objPath);
+
+private:
+	MappedFile file;
+	MeshBuffers view;
+};
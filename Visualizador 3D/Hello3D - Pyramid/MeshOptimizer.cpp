@@ -0,0 +1,346 @@
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+
+//GLM
+#include <glm/glm.hpp>
+
+using namespace std;
+
+namespace
+{
+	// Cache FIFO por carimbos: o vértice está no cache se entrou há no máximo size entradas
+	struct FifoCache
+	{
+		vector<uint32_t> stamps;
+		uint32_t time;
+		unsigned size;
+
+		FifoCache(size_t vertexCount, unsigned size) : stamps(vertexCount, 0), time(size + 1), size(size) {}
+
+		void reset() { time += size + 1; }
+		bool access(uint32_t v) //true se foi uma falta
+		{
+			if (time - stamps[v] <= size)
+				return false;
+			stamps[v] = time++;
+			return true;
+		}
+		int triangle(const uint32_t* corners) { return access(corners[0]) + access(corners[1]) + access(corners[2]); }
+	};
+
+	// Trecho de triângulos; sortKey mede o quanto ele está na frente da malha, vista de fora
+	struct Cluster
+	{
+		uint32_t first;
+		uint32_t count;
+		float sortKey;
+	};
+
+	glm::vec3 position(const float* vertices, uint32_t v)
+	{
+		const float* p = vertices + (size_t)v * OBJ_FLOATS_PER_VERTEX;
+		return glm::vec3(p[0], p[1], p[2]);
+	}
+}
+
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize)
+{
+	VertexCacheStats stats;
+	FifoCache cache(vertexCount, cacheSize);
+	vector<uint8_t> used(vertexCount, 0);
+	size_t usedCount = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		stats.misses += cache.access(indices[i]);
+		usedCount += !used[indices[i]];
+		used[indices[i]] = 1;
+	}
+	stats.acmr = indexCount >= 3 ? (float)stats.misses / (indexCount / 3) : 0.0f;
+	stats.atvr = usedCount > 0 ? (float)stats.misses / usedCount : 0.0f;
+	return stats;
+}
+
+OverdrawStats analyzeOverdraw(const uint32_t* indices, size_t indexCount, const float* vertices, int resolution)
+{
+	OverdrawStats stats;
+	glm::vec3 low(FLT_MAX), high(-FLT_MAX);
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		low = glm::min(low, position(vertices, indices[i]));
+		high = glm::max(high, position(vertices, indices[i]));
+	}
+	glm::vec3 extent = glm::max(high - low, glm::vec3(1e-20f));
+
+	vector<float> depth((size_t)resolution * resolution);
+	for (int view = 0; view < 6; view++)
+	{
+		//Eixo da vista e os outros dois como x e y da tela; depth cresce para longe da câmera
+		int axis = view / 2;
+		int ax = (axis + 1) % 3, ay = (axis + 2) % 3;
+		float direction = view % 2 == 0 ? 1.0f : -1.0f;
+		fill(depth.begin(), depth.end(), FLT_MAX);
+		for (size_t t = 0; t + 2 < indexCount; t += 3)
+		{
+			glm::vec3 p[3];
+			for (int k = 0; k < 3; k++)
+			{
+				glm::vec3 v = (position(vertices, indices[t + k]) - low) / extent;
+				p[k] = glm::vec3(v[ax] * resolution, v[ay] * resolution, v[axis] * direction);
+			}
+			float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+			if (area == 0.0f)
+				continue;
+			int x0 = max(0, (int)floor(min(p[0].x, min(p[1].x, p[2].x))));
+			int x1 = min(resolution - 1, (int)ceil(max(p[0].x, max(p[1].x, p[2].x))));
+			int y0 = max(0, (int)floor(min(p[0].y, min(p[1].y, p[2].y))));
+			int y1 = min(resolution - 1, (int)ceil(max(p[0].y, max(p[1].y, p[2].y))));
+			for (int y = y0; y <= y1; y++)
+				for (int x = x0; x <= x1; x++)
+				{
+					//Coordenadas baricêntricas no centro do pixel, com o sinal da área
+					float px = x + 0.5f, py = y + 0.5f;
+					float w0 = ((p[1].x - px) * (p[2].y - py) - (p[2].x - px) * (p[1].y - py)) / area;
+					float w1 = ((p[2].x - px) * (p[0].y - py) - (p[0].x - px) * (p[2].y - py)) / area;
+					float w2 = 1.0f - w0 - w1;
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+						continue;
+					float z = w0 * p[0].z + w1 * p[1].z + w2 * p[2].z;
+					float& stored = depth[(size_t)y * resolution + x];
+					if (z < stored)
+					{
+						stored = z;
+						stats.shaded++;
+					}
+				}
+		}
+		for (float z : depth)
+			stats.covered += z != FLT_MAX;
+	}
+	stats.overdraw = stats.covered > 0 ? (float)stats.shaded / stats.covered : 0.0f;
+	return stats;
+}
+
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize)
+{
+	PROFILE_ZONE("optimizeVertexCache");
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	//Triângulos de cada vértice (adjacência compacta) e quantos ainda não saíram
+	vector<uint32_t> live(vertexCount, 0);
+	for (size_t i = 0; i < indexCount; i++)
+		live[indices[i]]++;
+	vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+		offsets[v + 1] = offsets[v] + live[v];
+	vector<uint32_t> adjacency(indexCount);
+	vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < indexCount; i++)
+		adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+
+	vector<uint32_t> stamps(vertexCount, 0);
+	vector<uint8_t> emitted(triangleCount, 0);
+	vector<uint32_t> deadEnd;
+	vector<uint32_t> candidates;
+	vector<uint32_t> output;
+	output.reserve(indexCount);
+	uint32_t time = cacheSize + 1;
+	size_t cursor = 0;
+	long long fanning = indices[0];
+	while (fanning >= 0)
+	{
+		//Todos os triângulos pendentes em volta do vértice atual
+		candidates.clear();
+		for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+		{
+			uint32_t t = adjacency[a];
+			if (emitted[t])
+				continue;
+			emitted[t] = 1;
+			for (int k = 0; k < 3; k++)
+			{
+				uint32_t v = indices[t * 3 + k];
+				output.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if (time - stamps[v] > cacheSize)
+					stamps[v] = time++;
+			}
+		}
+
+		//Próximo leque: o vizinho mais antigo que ainda continua no cache depois de emitir
+		//os seus triângulos (cada um pode trazer até 2 vértices novos)
+		fanning = -1;
+		uint32_t bestPriority = 0;
+		for (uint32_t v : candidates)
+		{
+			if (live[v] == 0)
+				continue;
+			uint32_t priority = time - stamps[v] + 2 * live[v] <= cacheSize ? time - stamps[v] : 0;
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				fanning = v;
+			}
+		}
+		if (fanning >= 0)
+			continue;
+
+		//Beco sem saída: um vértice recente com triângulos pendentes, ou o próximo na ordem
+		while (!deadEnd.empty() && fanning < 0)
+		{
+			uint32_t v = deadEnd.back();
+			deadEnd.pop_back();
+			if (live[v] > 0)
+				fanning = v;
+		}
+		while (fanning < 0 && cursor < vertexCount)
+		{
+			if (live[cursor] > 0)
+				fanning = (long long)cursor;
+			cursor++;
+		}
+	}
+	memcpy(indices, output.data(), indexCount * sizeof(uint32_t));
+}
+
+void optimizeOverdraw(uint32_t* indices, size_t indexCount, const float* vertices, size_t vertexCount, float threshold, unsigned cacheSize)
+{
+	PROFILE_ZONE("optimizeOverdraw");
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	//Limites fortes: triângulos com os três vértices fora do cache
+	vector<uint32_t> hard;
+	FifoCache cache(vertexCount, cacheSize);
+	for (size_t t = 0; t < triangleCount; t++)
+		if (cache.triangle(&indices[t * 3]) == 3)
+			hard.push_back((uint32_t)t);
+	if (hard.empty() || hard[0] != 0)
+		hard.insert(hard.begin(), 0);
+	hard.push_back((uint32_t)triangleCount);
+
+	//Limites fracos: dentro de cada trecho, corta assim que o ACMR acumulado desde o
+	//último corte fica abaixo do ACMR do trecho inteiro vezes threshold. Cada corte
+	//recomeça o cache, porque o trecho pode ir para qualquer posição da lista
+	vector<Cluster> clusters;
+	for (size_t h = 0; h + 1 < hard.size(); h++)
+	{
+		uint32_t start = hard[h], end = hard[h + 1];
+		cache.reset();
+		size_t misses = 0;
+		for (uint32_t t = start; t < end; t++)
+			misses += cache.triangle(&indices[t * 3]);
+		float limit = threshold * misses / (end - start);
+
+		cache.reset();
+		uint32_t first = start;
+		misses = 0;
+		for (uint32_t t = start; t < end; t++)
+		{
+			misses += cache.triangle(&indices[t * 3]);
+			if (t + 1 < end && (float)misses / (t + 1 - first) <= limit)
+			{
+				Cluster cluster = { first, t + 1 - first, 0.0f };
+				clusters.push_back(cluster);
+				first = t + 1;
+				misses = 0;
+				cache.reset();
+			}
+		}
+		Cluster cluster = { first, end - first, 0.0f };
+		clusters.push_back(cluster);
+	}
+
+	//Centro de cada trecho e da malha (ponderados pela área) e normal média do trecho
+	vector<glm::vec3> centers(clusters.size()), normals(clusters.size());
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		glm::vec3 center(0.0f), normal(0.0f);
+		float area = 0.0f;
+		for (uint32_t t = clusters[c].first; t < clusters[c].first + clusters[c].count; t++)
+		{
+			glm::vec3 a = position(vertices, indices[t * 3]);
+			glm::vec3 b = position(vertices, indices[t * 3 + 1]);
+			glm::vec3 d = position(vertices, indices[t * 3 + 2]);
+			glm::vec3 cross = glm::cross(b - a, d - a);
+			float triangleArea = glm::length(cross);
+			center += (a + b + d) * (triangleArea / 3.0f);
+			normal += cross;
+			area += triangleArea;
+		}
+		meshCenter += center;
+		meshArea += area;
+		centers[c] = area > 0.0f ? center / area : center;
+		float length = glm::length(normal);
+		normals[c] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+	}
+	if (meshArea > 0.0f)
+		meshCenter /= meshArea;
+	for (size_t c = 0; c < clusters.size(); c++)
+		clusters[c].sortKey = glm::dot(centers[c] - meshCenter, normals[c]);
+
+	stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+	vector<uint32_t> output;
+	output.reserve(indexCount);
+	for (const Cluster& cluster : clusters)
+		output.insert(output.end(), indices + cluster.first * 3, indices + (cluster.first + cluster.count) * 3);
+	memcpy(indices, output.data(), indexCount * sizeof(uint32_t));
+}
+
+void optimizeVertexFetch(MeshData& mesh)
+{
+	PROFILE_ZONE("optimizeVertexFetch");
+	size_t vertexCount = mesh.vertexCount();
+	vector<uint32_t> remap(vertexCount, UINT32_MAX);
+	uint32_t next = 0;
+	for (uint32_t& index : mesh.indices)
+	{
+		if (remap[index] == UINT32_MAX)
+			remap[index] = next++;
+		index = remap[index];
+	}
+
+	vector<float> vertices((size_t)next * OBJ_FLOATS_PER_VERTEX);
+	for (size_t v = 0; v < vertexCount; v++)
+		if (remap[v] != UINT32_MAX)
+			memcpy(&vertices[(size_t)remap[v] * OBJ_FLOATS_PER_VERTEX], &mesh.vertices[v * OBJ_FLOATS_PER_VERTEX], OBJ_FLOATS_PER_VERTEX * sizeof(float));
+	mesh.vertices.swap(vertices);
+}
+
+void optimizeMesh(MeshData& mesh, const vector<MeshLod>& lods, VertexCacheStats* before, VertexCacheStats* after)
+{
+	PROFILE_ZONE("optimizeMesh");
+	vector<MeshLod> ranges = lods;
+	if (ranges.empty())
+	{
+		MeshLod whole = { 0, (uint32_t)mesh.indices.size(), 0.0f };
+		ranges.push_back(whole);
+	}
+	if (before != nullptr)
+		*before = analyzeVertexCache(&mesh.indices[ranges[0].firstIndex], ranges[0].indexCount, mesh.vertexCount());
+
+	//Os vértices são os mesmos em todos os níveis; só a ordem dos triângulos de cada um muda
+	for (const MeshLod& range : ranges)
+	{
+		if (range.indexCount == 0)
+			continue;
+		uint32_t* indices = &mesh.indices[range.firstIndex];
+		optimizeVertexCache(indices, range.indexCount, mesh.vertexCount());
+		optimizeOverdraw(indices, range.indexCount, mesh.vertices.data(), mesh.vertexCount());
+	}
+	optimizeVertexFetch(mesh);
+
+	if (after != nullptr)
+		*after = analyzeVertexCache(&mesh.indices[ranges[0].firstIndex], ranges[0].indexCount, mesh.vertexCount());
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "ObjLoader.h"
+#include "MeshCache.h"
+
+// Tamanho do cache de vértices pós-transformação simulado (FIFO), em vértices
+const unsigned VERTEX_CACHE_SIZE = 16;
+// Piora aceita no ACMR ao dividir a malha em grupos para o overdraw (1.05 = 5%)
+const float OVERDRAW_THRESHOLD = 1.05f;
+
+// Resultado da simulação de um cache FIFO sobre a lista de índices.
+// ACMR: vértices transformados por triângulo (0.5 é o ideal numa malha regular, 3 o pior);
+// ATVR: vértices transformados por vértice da malha (1 é o ideal)
+struct VertexCacheStats
+{
+	size_t misses = 0;
+	float acmr = 0.0f;
+	float atvr = 0.0f;
+};
+
+// Simula um cache FIFO com cacheSize entradas desenhando indices (3 por triângulo)
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// Fragmentos que passam no teste de profundidade por pixel coberto (1 é o ideal), somados
+// em 6 vistas ortográficas (dos dois lados de cada eixo) com resolution x resolution pixels.
+// Como no programa, sem descarte das faces de trás
+struct OverdrawStats
+{
+	size_t covered = 0;
+	size_t shaded = 0;
+	float overdraw = 0.0f;
+};
+
+// Rasteriza indices na CPU nas 6 vistas e conta os fragmentos; vertices no layout de 11 floats
+OverdrawStats analyzeOverdraw(const uint32_t* indices, size_t indexCount, const float* vertices, int resolution = 256);
+
+// Reordena os triângulos para o cache de vértices com o Tipsify (Sander, Nehab e Barczak,
+// "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"): os triângulos
+// saem em leques em volta de um vértice, e o próximo vértice é o vizinho que ainda está
+// no cache e tem triângulos pendentes; sem nenhum, volta para os vértices recentes
+// (pilha de becos sem saída) ou segue pela ordem dos vértices. Linear no número de índices
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// Reordena os trechos de uma lista já otimizada para o cache para reduzir o overdraw.
+// Os trechos (começam onde o cache recomeça, com os três vértices de um triângulo fora
+// dele, e são subdivididos enquanto o ACMR não piorar mais que threshold) são ordenados
+// de fora para dentro: primeiro os que estão longe do centro da malha e virados para
+// fora, que tendem a cobrir os outros, como no artigo do Tipsify. O ACMR final pode
+// piorar um pouco mais que threshold, porque o cache recomeça a cada troca de trecho.
+// vertices: layout de 11 floats do loader
+void optimizeOverdraw(uint32_t* indices, size_t indexCount, const float* vertices, size_t vertexCount, float threshold = OVERDRAW_THRESHOLD, unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// Renumera os vértices na ordem do primeiro uso pelos índices, para que a leitura dos
+// vértices siga a memória; vértices sem uso são descartados
+void optimizeVertexFetch(MeshData& mesh);
+
+// As três etapas na malha inteira, cada nível de detalhe (lods) otimizado no seu trecho
+// dos índices. before/after (opcionais) recebem as estatísticas do nível 0
+void optimizeMesh(MeshData& mesh, const std::vector<MeshLod>& lods, VertexCacheStats* before = nullptr, VertexCacheStats* after = nullptr);
@@ -0,0 +1,594 @@
+#include "MeshSimplifier.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+#include <queue>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+
+//GLM
+#include <glm/glm.hpp>
+
+using namespace std;
+
+namespace
+{
+	const size_t MIN_CHUNK_TRIANGLES = 20000; //trechos menores não compensam a divisão
+	const double ATTRIBUTE_WEIGHT = 0.01;     //custo dos atributos, relativo ao quadrado da diagonal da malha
+	const double NORMAL_WEIGHT = 1.0;         //normal oposta custa como uma coordenada de textura a 1 de distância
+	const double LENGTH_WEIGHT = 1e-4;        //desempate em regiões planas: prefere as arestas curtas
+	const double FLIP_COS = 0.2;              //normal de um triângulo não pode girar mais que ~78 graus
+	const double PASS_SLACK = 1.15;           //folga deixada pela primeira passada em trechos
+
+	// Soma dos quadrados das distâncias a um conjunto de planos: matriz 4x4 simétrica
+	struct Quadric
+	{
+		double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+		void addPlane(const glm::dvec3& n, double d)
+		{
+			a2 += n.x * n.x; ab += n.x * n.y; ac += n.x * n.z; ad += n.x * d;
+			b2 += n.y * n.y; bc += n.y * n.z; bd += n.y * d;
+			c2 += n.z * n.z; cd += n.z * d;
+			d2 += d * d;
+		}
+
+		void add(const Quadric& q)
+		{
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+		}
+
+		double evaluate(const glm::dvec3& p) const
+		{
+			return a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+				+ b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+				+ c2 * p.z * p.z + 2 * cd * p.z + d2;
+		}
+	};
+
+	// Dados da malha inteira, só lidos pelos trechos: vértices, posição soldada de cada
+	// vértice (vértices com a mesma posição e atributos diferentes formam costuras) e pesos
+	struct SimplifySource
+	{
+		const float* vertices = nullptr;
+		vector<uint32_t> positionOf; //primeiro vértice com a mesma posição
+		vector<glm::vec3> normals;   //normais unitárias (zero se o arquivo não tiver)
+		glm::vec3 low, high;
+		double attributeScale = 0.0;
+		double lengthScale = 0.0;
+
+		const float* vertex(uint32_t v) const { return vertices + (size_t)v * OBJ_FLOATS_PER_VERTEX; }
+		glm::dvec3 position(uint32_t v) const { const float* p = vertex(v); return glm::dvec3(p[0], p[1], p[2]); }
+
+		// Diferença de coordenada de textura e de normal entre dois vértices
+		double attributeDistance(uint32_t a, uint32_t b) const
+		{
+			if (a == b)
+				return 0.0;
+			const float* va = vertex(a);
+			const float* vb = vertex(b);
+			double du = va[6] - vb[6], dv = va[7] - vb[7];
+			double normal = normals[a] == glm::vec3(0.0f) || normals[b] == glm::vec3(0.0f) ? 0.0 : 1.0 - glm::dot(normals[a], normals[b]);
+			return du * du + dv * dv + NORMAL_WEIGHT * normal;
+		}
+	};
+
+	struct PositionKey
+	{
+		uint32_t x, y, z;
+		bool operator==(const PositionKey& other) const { return x == other.x && y == other.y && z == other.z; }
+	};
+
+	struct PositionHash
+	{
+		size_t operator()(const PositionKey& key) const { return (key.x * 73856093u) ^ (key.y * 19349663u) ^ (key.z * 83492791u); }
+	};
+
+	void buildSource(const float* vertices, size_t vertexCount, SimplifySource& source)
+	{
+		source.vertices = vertices;
+		source.positionOf.resize(vertexCount);
+		source.normals.resize(vertexCount);
+		unordered_map<PositionKey, uint32_t, PositionHash> first;
+		first.reserve(vertexCount);
+		source.low = glm::vec3(FLT_MAX);
+		source.high = glm::vec3(-FLT_MAX);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			const float* p = source.vertex((uint32_t)v);
+			PositionKey key;
+			memcpy(&key, p, sizeof(key));
+			source.positionOf[v] = first.emplace(key, (uint32_t)v).first->second;
+			glm::vec3 normal(p[8], p[9], p[10]);
+			float length = glm::length(normal);
+			source.normals[v] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+			source.low = glm::min(source.low, glm::vec3(p[0], p[1], p[2]));
+			source.high = glm::max(source.high, glm::vec3(p[0], p[1], p[2]));
+		}
+		double diagonal2 = vertexCount > 0 ? glm::dot(glm::dvec3(source.high - source.low), glm::dvec3(source.high - source.low)) : 0.0;
+		source.attributeScale = ATTRIBUTE_WEIGHT * diagonal2;
+		source.lengthScale = LENGTH_WEIGHT;
+	}
+
+	// Simplificação de um conjunto de triângulos da malha. Trabalha com posições locais
+	// (as soldadas que aparecem nos triângulos); os cantos guardam o vértice original
+	class Simplifier
+	{
+	public:
+		Simplifier(const SimplifySource& source, const uint32_t* triangles, size_t count);
+		void simplify(size_t targetTriangles);
+		void output(vector<uint32_t>& indices) const;
+		size_t triangleCount() const { return live; }
+		double error() const { return sqrt(maxError); }
+
+	private:
+		struct Candidate
+		{
+			double cost;
+			uint32_t from, to, stamp;
+			bool operator<(const Candidate& other) const { return cost > other.cost; } //heap de mínimo
+		};
+
+		double cost(uint32_t from, uint32_t to, double& geometric);
+		bool linkCondition(uint32_t from, uint32_t to);
+		double mapWedges(uint32_t from, uint32_t to, vector<pair<uint32_t, uint32_t> >* map) const;
+		void evaluate(uint32_t p);
+		void collapse(uint32_t from, uint32_t to);
+		void compact(uint32_t p);
+		void neighbors(uint32_t p, vector<uint32_t>& out) const;
+		bool contains(uint32_t triangle, uint32_t p) const;
+
+		const SimplifySource& source;
+		vector<uint32_t> corners;   //vértice de cada canto, 3 por triângulo
+		vector<uint32_t> cornerPos; //posição local de cada canto
+		vector<uint8_t> alive;
+		size_t live = 0;
+		vector<glm::dvec3> positions;
+		vector<Quadric> quadrics;
+		vector<vector<uint32_t> > trianglesAt;
+		vector<vector<uint32_t> > wedgesAt; //vértices (com atributos diferentes) de cada posição
+		vector<uint8_t> locked, removed;
+		vector<uint32_t> stamps; //candidatos com stamp antigo no heap estão obsoletos
+		vector<double> bestCost; //candidato atual de cada posição
+		vector<uint32_t> bestTo;
+		priority_queue<Candidate> heap;
+		double maxError = 0.0;
+		vector<uint32_t> scratchFrom, scratchTo, scratchNeighbors;
+		vector<pair<double, uint32_t> > scratchCosts;
+		vector<pair<uint32_t, uint32_t> > scratchMap;
+	};
+
+	Simplifier::Simplifier(const SimplifySource& source, const uint32_t* triangles, size_t count)
+		: source(source), corners(triangles, triangles + count * 3), alive(count, 1), live(count)
+	{
+		//Posições locais: as posições soldadas dos cantos, sem repetição
+		vector<uint32_t> unique(corners.size());
+		for (size_t i = 0; i < corners.size(); i++)
+			unique[i] = source.positionOf[corners[i]];
+		sort(unique.begin(), unique.end());
+		unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+		cornerPos.resize(corners.size());
+		for (size_t i = 0; i < corners.size(); i++)
+			cornerPos[i] = (uint32_t)(lower_bound(unique.begin(), unique.end(), source.positionOf[corners[i]]) - unique.begin());
+
+		size_t nPositions = unique.size();
+		positions.resize(nPositions);
+		for (size_t p = 0; p < nPositions; p++)
+			positions[p] = source.position(unique[p]);
+		quadrics.resize(nPositions);
+		trianglesAt.resize(nPositions);
+		wedgesAt.resize(nPositions);
+		locked.assign(nPositions, 0);
+		removed.assign(nPositions, 0);
+		stamps.assign(nPositions, 0);
+		bestCost.assign(nPositions, DBL_MAX);
+		bestTo.assign(nPositions, 0);
+
+		vector<uint64_t> edges;
+		edges.reserve(corners.size());
+		for (size_t t = 0; t < count; t++)
+		{
+			const uint32_t* p = &cornerPos[t * 3];
+			glm::dvec3 normal = glm::cross(positions[p[1]] - positions[p[0]], positions[p[2]] - positions[p[0]]);
+			double length = glm::length(normal);
+			Quadric plane;
+			if (length > 0.0)
+				plane.addPlane(normal / length, -glm::dot(normal / length, positions[p[0]]));
+			for (int k = 0; k < 3; k++)
+			{
+				trianglesAt[p[k]].push_back((uint32_t)t);
+				vector<uint32_t>& wedges = wedgesAt[p[k]];
+				if (find(wedges.begin(), wedges.end(), corners[t * 3 + k]) == wedges.end())
+					wedges.push_back(corners[t * 3 + k]);
+				quadrics[p[k]].add(plane);
+				uint32_t a = p[k], b = p[(k + 1) % 3];
+				if (a != b)
+					edges.push_back((uint64_t)min(a, b) << 32 | max(a, b));
+			}
+		}
+
+		//Arestas com um só triângulo (borda da malha ou do trecho) ou com mais de dois
+		//(não-manifold) travam as duas pontas
+		sort(edges.begin(), edges.end());
+		for (size_t i = 0; i < edges.size(); )
+		{
+			size_t j = i;
+			while (j < edges.size() && edges[j] == edges[i])
+				j++;
+			if (j - i != 2)
+				locked[edges[i] >> 32] = locked[edges[i] & 0xffffffffu] = 1;
+			i = j;
+		}
+
+		for (size_t p = 0; p < nPositions; p++)
+			evaluate((uint32_t)p);
+	}
+
+	bool Simplifier::contains(uint32_t triangle, uint32_t p) const
+	{
+		const uint32_t* c = &cornerPos[triangle * 3];
+		return c[0] == p || c[1] == p || c[2] == p;
+	}
+
+	void Simplifier::neighbors(uint32_t p, vector<uint32_t>& out) const
+	{
+		out.clear();
+		for (uint32_t t : trianglesAt[p])
+		{
+			if (!alive[t])
+				continue;
+			for (int k = 0; k < 3; k++)
+				if (cornerPos[t * 3 + k] != p)
+					out.push_back(cornerPos[t * 3 + k]);
+		}
+		sort(out.begin(), out.end());
+		out.erase(unique(out.begin(), out.end()), out.end());
+	}
+
+	double Simplifier::mapWedges(uint32_t from, uint32_t to, vector<pair<uint32_t, uint32_t> >* map) const
+	{
+		//Cada vértice de from vai para o vértice de to com atributos mais parecidos
+		double total = 0.0;
+		for (uint32_t wedge : wedgesAt[from])
+		{
+			double best = DBL_MAX;
+			uint32_t target = wedgesAt[to][0];
+			for (uint32_t candidate : wedgesAt[to])
+			{
+				double distance = source.attributeDistance(wedge, candidate);
+				if (distance < best)
+				{
+					best = distance;
+					target = candidate;
+				}
+			}
+			total += best;
+			if (map != nullptr)
+				map->push_back(make_pair(wedge, target));
+		}
+		return total;
+	}
+
+	bool Simplifier::linkCondition(uint32_t from, uint32_t to)
+	{
+		//Os vizinhos comuns às duas posições são só os vértices opostos dos triângulos da
+		//aresta; senão o colapso dobra a malha sobre si mesma
+		size_t shared = 0;
+		for (uint32_t t : trianglesAt[from])
+			shared += alive[t] && contains(t, to);
+		neighbors(from, scratchFrom);
+		neighbors(to, scratchTo);
+		size_t common = 0;
+		for (size_t i = 0, j = 0; i < scratchFrom.size() && j < scratchTo.size(); )
+		{
+			if (scratchFrom[i] < scratchTo[j])
+				i++;
+			else if (scratchTo[j] < scratchFrom[i])
+				j++;
+			else
+			{
+				common++;
+				i++;
+				j++;
+			}
+		}
+		return common == shared;
+	}
+
+	double Simplifier::cost(uint32_t from, uint32_t to, double& geometric)
+	{
+		const glm::dvec3& target = positions[to];
+		Quadric quadric = quadrics[from];
+		quadric.add(quadrics[to]);
+		geometric = max(0.0, quadric.evaluate(target));
+
+		//Os triângulos que não somem não podem virar do avesso nem degenerar
+		for (uint32_t t : trianglesAt[from])
+		{
+			if (!alive[t] || contains(t, to))
+				continue;
+			glm::dvec3 p[3], moved[3];
+			for (int k = 0; k < 3; k++)
+			{
+				p[k] = positions[cornerPos[t * 3 + k]];
+				moved[k] = cornerPos[t * 3 + k] == from ? target : p[k];
+			}
+			glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+			glm::dvec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+			double lengthBefore = glm::length(before);
+			if (lengthBefore > 0.0 && glm::dot(before, after) <= FLIP_COS * lengthBefore * glm::length(after))
+				return DBL_MAX;
+		}
+
+		glm::dvec3 edge = positions[from] - target;
+		return geometric + source.attributeScale * mapWedges(from, to, nullptr) + source.lengthScale * glm::dot(edge, edge);
+	}
+
+	void Simplifier::evaluate(uint32_t p)
+	{
+		stamps[p]++;
+		bestCost[p] = DBL_MAX;
+		if (locked[p] || removed[p])
+			return;
+		neighbors(p, scratchNeighbors);
+		scratchCosts.clear();
+		double geometric;
+		for (uint32_t q : scratchNeighbors)
+		{
+			double c = cost(p, q, geometric);
+			if (c < DBL_MAX)
+				scratchCosts.push_back(make_pair(c, q));
+		}
+		//A condição de ligação é mais cara: só é conferida, em ordem de custo, até a
+		//primeira vizinha que a satisfaz
+		sort(scratchCosts.begin(), scratchCosts.end());
+		for (const pair<double, uint32_t>& entry : scratchCosts)
+		{
+			if (!linkCondition(p, entry.second))
+				continue;
+			Candidate best = { entry.first, p, entry.second, stamps[p] };
+			heap.push(best);
+			bestCost[p] = entry.first;
+			bestTo[p] = entry.second;
+			return;
+		}
+	}
+
+	void Simplifier::compact(uint32_t p)
+	{
+		vector<uint32_t>& triangles = trianglesAt[p];
+		triangles.erase(remove_if(triangles.begin(), triangles.end(), [this](uint32_t t) { return !alive[t]; }), triangles.end());
+	}
+
+	void Simplifier::collapse(uint32_t from, uint32_t to)
+	{
+		scratchMap.clear();
+		mapWedges(from, to, &scratchMap);
+		for (uint32_t t : trianglesAt[from])
+		{
+			if (!alive[t])
+				continue;
+			if (contains(t, to))
+			{
+				alive[t] = 0;
+				live--;
+				continue;
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				if (cornerPos[t * 3 + k] != from)
+					continue;
+				cornerPos[t * 3 + k] = to;
+				for (const pair<uint32_t, uint32_t>& entry : scratchMap)
+					if (entry.first == corners[t * 3 + k])
+						corners[t * 3 + k] = entry.second;
+			}
+			trianglesAt[to].push_back(t);
+		}
+		quadrics[to].add(quadrics[from]);
+		removed[from] = 1;
+		vector<uint32_t>().swap(trianglesAt[from]);
+		vector<uint32_t>().swap(wedgesAt[from]);
+		compact(to);
+
+		//Mudaram os custos de to e, nos vizinhos (que agora incluem os de from), os colapsos
+		//até to. Um vizinho cujo candidato era from ou to é reavaliado por inteiro; nos
+		//outros basta ver se ir até to ficou mais barato. Os demais custos quase não mudam
+		//(as quádricas são as mesmas) e são conferidos quando saem do heap
+		vector<uint32_t> around;
+		neighbors(to, around);
+		evaluate(to);
+		for (uint32_t q : around)
+		{
+			compact(q);
+			if (locked[q])
+				continue;
+			if (bestCost[q] == DBL_MAX || bestTo[q] == from || bestTo[q] == to)
+			{
+				evaluate(q);
+				continue;
+			}
+			double geometric;
+			double c = cost(q, to, geometric);
+			if (c < bestCost[q] && linkCondition(q, to))
+			{
+				Candidate candidate = { c, q, to, ++stamps[q] };
+				heap.push(candidate);
+				bestCost[q] = c;
+				bestTo[q] = to;
+			}
+		}
+	}
+
+	void Simplifier::simplify(size_t targetTriangles)
+	{
+		while (live > targetTriangles && !heap.empty())
+		{
+			Candidate candidate = heap.top();
+			heap.pop();
+			if (removed[candidate.from] || removed[candidate.to] || candidate.stamp != stamps[candidate.from])
+				continue;
+
+			//Vizinhanças a duas arestas de distância podem ter mudado o custo desde que o
+			//candidato entrou no heap: confere antes de colapsar
+			double geometric;
+			double current = cost(candidate.from, candidate.to, geometric);
+			if (current == DBL_MAX || !linkCondition(candidate.from, candidate.to))
+			{
+				evaluate(candidate.from);
+				continue;
+			}
+			if (current > candidate.cost * (1.0 + 1e-9) + 1e-30)
+			{
+				candidate.cost = current;
+				heap.push(candidate);
+				bestCost[candidate.from] = current;
+				continue;
+			}
+			maxError = max(maxError, geometric);
+			collapse(candidate.from, candidate.to);
+		}
+	}
+
+	void Simplifier::output(vector<uint32_t>& indices) const
+	{
+		for (size_t t = 0; t < alive.size(); t++)
+			if (alive[t])
+				indices.insert(indices.end(), &corners[t * 3], &corners[t * 3] + 3);
+	}
+
+	uint32_t spreadBits(uint32_t x)
+	{
+		x &= 0x3ff;
+		x = (x | (x << 16)) & 0x30000ff;
+		x = (x | (x << 8)) & 0x300f00f;
+		x = (x | (x << 4)) & 0x30c30c3;
+		x = (x | (x << 2)) & 0x9249249;
+		return x;
+	}
+
+	// Ordena os triângulos pelo código de Morton do centroide: trechos contíguos da lista
+	// ficam compactos no espaço, com poucas arestas na divisa
+	void sortMorton(const SimplifySource& source, vector<uint32_t>& indices)
+	{
+		size_t count = indices.size() / 3;
+		glm::vec3 scale = 1023.0f / glm::max(source.high - source.low, glm::vec3(1e-20f));
+		vector<pair<uint32_t, uint32_t> > keys(count);
+		for (size_t t = 0; t < count; t++)
+		{
+			glm::vec3 centroid = glm::vec3(source.position(indices[t * 3]) + source.position(indices[t * 3 + 1]) + source.position(indices[t * 3 + 2])) / 3.0f;
+			glm::uvec3 cell = glm::uvec3(glm::clamp((centroid - source.low) * scale, glm::vec3(0.0f), glm::vec3(1023.0f)));
+			keys[t] = make_pair(spreadBits(cell.x) | spreadBits(cell.y) << 1 | spreadBits(cell.z) << 2, (uint32_t)t);
+		}
+		sort(keys.begin(), keys.end());
+		vector<uint32_t> sorted(indices.size());
+		for (size_t t = 0; t < count; t++)
+			memcpy(&sorted[t * 3], &indices[keys[t].second * 3], 3 * sizeof(uint32_t));
+		indices.swap(sorted);
+	}
+
+	// Simplifica indices até target triângulos; em malhas grandes, por trechos em paralelo
+	void simplifyChunks(const SimplifySource& source, const vector<uint32_t>& indices, size_t target, ThreadPool* pool, vector<uint32_t>& out, double& error)
+	{
+		size_t triangles = indices.size() / 3;
+		size_t chunks = pool != nullptr && pool->size() > 1 ? min<size_t>(pool->size() * 2, triangles / MIN_CHUNK_TRIANGLES) : 1;
+		out.clear();
+		if (chunks <= 1)
+		{
+			Simplifier simplifier(source, indices.data(), triangles);
+			simplifier.simplify(target);
+			simplifier.output(out);
+			error = simplifier.error();
+			return;
+		}
+
+		//As bordas dos trechos ficam travadas; a segunda passada desloca os trechos em meio
+		//trecho, e as bordas da primeira passam a ser interiores
+		vector<uint32_t> current = indices;
+		error = 0.0;
+		for (int pass = 0; pass < 2; pass++)
+		{
+			size_t count = current.size() / 3;
+			size_t passTarget = pass == 0 ? (size_t)(target * PASS_SLACK) : target;
+			if (passTarget >= count)
+				continue;
+			sortMorton(source, current);
+			size_t chunkSize = (count + chunks - 1) / chunks;
+			vector<size_t> starts(1, 0);
+			for (size_t start = pass == 0 ? chunkSize : chunkSize / 2; start < count; start += chunkSize)
+				starts.push_back(start);
+			starts.push_back(count);
+
+			double ratio = (double)passTarget / count;
+			vector<vector<uint32_t> > results(starts.size() - 1);
+			vector<double> errors(starts.size() - 1);
+			pool->parallelFor((int)results.size(), [&](int c) {
+				size_t size = starts[c + 1] - starts[c];
+				Simplifier simplifier(source, &current[starts[c] * 3], size);
+				simplifier.simplify((size_t)ceil(size * ratio));
+				simplifier.output(results[c]);
+				errors[c] = simplifier.error();
+			});
+			current.clear();
+			for (size_t c = 0; c < results.size(); c++)
+				current.insert(current.end(), results[c].begin(), results[c].end());
+			error += *max_element(errors.begin(), errors.end());
+		}
+		out.swap(current);
+	}
+}
+
+void simplifyMesh(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, size_t targetTriangles, vector<uint32_t>& out, float& error)
+{
+	PROFILE_ZONE("simplifyMesh");
+	SimplifySource source;
+	buildSource(vertices, vertexCount, source);
+	Simplifier simplifier(source, indices, indexCount / 3);
+	simplifier.simplify(targetTriangles);
+	out.clear();
+	simplifier.output(out);
+	error = (float)simplifier.error();
+}
+
+void generateLods(MeshData& mesh, vector<MeshLod>& lods, int nThreads)
+{
+	PROFILE_ZONE("generateLods");
+	lods.clear();
+	MeshLod base = { 0, (uint32_t)mesh.indices.size(), 0.0f };
+	lods.push_back(base);
+	if (mesh.indices.size() / 3 < 2 * MIN_LOD_TRIANGLES)
+		return;
+
+	SimplifySource source;
+	buildSource(mesh.vertices.data(), mesh.vertexCount(), source);
+	unique_ptr<ThreadPool> pool;
+	if (nThreads != 1 && mesh.indices.size() / 3 >= 2 * MIN_CHUNK_TRIANGLES)
+		pool.reset(new ThreadPool(nThreads));
+
+	//Cada nível parte do anterior; o erro acumula o de todos os níveis até ele
+	vector<uint32_t> previous(mesh.indices), level;
+	double error = 0.0;
+	for (int l = 1; l < MAX_LOD_LEVELS; l++)
+	{
+		size_t target = previous.size() / 3 / 2;
+		if (target < MIN_LOD_TRIANGLES)
+			break;
+		double levelError;
+		simplifyChunks(source, previous, target, pool.get(), level, levelError);
+		//Malha travada (bordas, costuras caras): um nível quase igual ao anterior não vale a memória
+		if (level.size() > previous.size() * 9 / 10)
+			break;
+		error += levelError;
+		MeshLod lod = { (uint32_t)mesh.indices.size(), (uint32_t)level.size(), (float)error };
+		lods.push_back(lod);
+		mesh.indices.insert(mesh.indices.end(), level.begin(), level.end());
+		previous.swap(level);
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "ObjLoader.h"
+#include "MeshCache.h"
+
+// Níveis de detalhe de uma malha, contando a malha completa (nível 0)
+const int MAX_LOD_LEVELS = 5;
+// Níveis com menos triângulos que isso não são gerados
+const size_t MIN_LOD_TRIANGLES = 64;
+
+// Simplificação por colapso de arestas com a métrica de erro quádrica (Garland & Heckbert).
+// Cada posição acumula as quádricas dos planos dos seus triângulos; o colapso mais barato
+// leva uma posição até a vizinha (meia-aresta: nenhum vértice novo é criado, então os
+// níveis usam o mesmo buffer de vértices da malha original).
+// O custo considera também os atributos: cada canto que muda de vértice vai para o vértice
+// da posição de destino com coordenada de textura e normal mais próximas, e a diferença
+// entra no custo. Assim costuras de textura e quinas com normais separadas só são
+// desfeitas quando o resto da malha já ficou mais caro.
+// Colapsos que invertem triângulos ou tornam a malha não-manifold são recusados, e
+// posições na borda da malha (arestas com um só triângulo) ficam travadas.
+// vertices: layout de 11 floats do loader; indices: 3 por triângulo.
+// Retorna os índices simplificados em out (no máximo targetTriangles triângulos, se os
+// colapsos permitirem) e o desvio estimado em error
+void simplifyMesh(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, size_t targetTriangles, std::vector<uint32_t>& out, float& error);
+
+// Gera até MAX_LOD_LEVELS - 1 níveis, cada um com metade dos triângulos do anterior e
+// simplificado a partir dele, e acrescenta os índices de cada nível ao fim de mesh.indices.
+// lods recebe o nível 0 (os índices originais) e os gerados; para quando um nível ficaria
+// abaixo de MIN_LOD_TRIANGLES ou quase não consegue reduzir o anterior.
+// Malhas grandes são divididas em trechos (pela ordem de Morton dos triângulos) simplificados
+// em paralelo com nThreads (<= 0 usa todos os núcleos): as bordas entre trechos ficam
+// travadas numa passada e são simplificadas numa segunda, com os trechos deslocados
+void generateLods(MeshData& mesh, std::vector<MeshLod>& lods, int nThreads = 1);
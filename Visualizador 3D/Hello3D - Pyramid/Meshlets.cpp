@@ -0,0 +1,258 @@
+#include "Meshlets.h"
+#include "FrustumCuller.h"
+#include "Profiler.h"
+
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+using namespace std;
+
+namespace
+{
+	glm::vec3 positionOf(const MeshData& mesh, uint32_t vertex)
+	{
+		const float* p = &mesh.vertices[(size_t)vertex * OBJ_FLOATS_PER_VERTEX];
+		return glm::vec3(p[0], p[1], p[2]);
+	}
+
+	// Posição exata de um vértice, para soldar os vértices separados por costuras
+	struct PositionKey
+	{
+		uint32_t x, y, z;
+		bool operator==(const PositionKey& other) const { return x == other.x && y == other.y && z == other.z; }
+	};
+
+	struct PositionHash
+	{
+		size_t operator()(const PositionKey& key) const { return (key.x * 73856093u) ^ (key.y * 19349663u) ^ (key.z * 83492791u); }
+	};
+
+	glm::vec3 normalizeOrZero(glm::vec3 v)
+	{
+		float length = glm::length(v);
+		return length > 0.0f ? v / length : glm::vec3(0.0f);
+	}
+
+	// Esfera e cone de um meshlet já com os triângulos em triangles
+	void meshletBounds(const MeshData& mesh, const vector<uint32_t>& triangles, const vector<glm::vec3>& normals,
+		const uint32_t* cornerOf, const vector<uint32_t>& vertices, Meshlet& meshlet)
+	{
+		glm::vec3 low(FLT_MAX), high(-FLT_MAX);
+		for (uint32_t v : vertices)
+		{
+			low = glm::min(low, positionOf(mesh, v));
+			high = glm::max(high, positionOf(mesh, v));
+		}
+		meshlet.center = (low + high) * 0.5f;
+		meshlet.radius = 0.0f;
+		for (uint32_t v : vertices)
+			meshlet.radius = max(meshlet.radius, glm::length(positionOf(mesh, v) - meshlet.center));
+
+		//Eixo pela média das normais; o cone se abre até a normal mais afastada. Triângulos
+		//degenerados não têm lado e não restringem o cone
+		glm::vec3 sum(0.0f);
+		for (uint32_t t : triangles)
+			sum += normals[t];
+		meshlet.coneAxis = normalizeOrZero(sum);
+		float minDot = 1.0f;
+		for (uint32_t t : triangles)
+			if (normals[t] != glm::vec3(0.0f))
+				minDot = min(minDot, glm::dot(normals[t], meshlet.coneAxis));
+		//Com as normais espalhadas por mais de um hemisfério nenhuma câmera vê todas de costas
+		meshlet.coneCutoff = meshlet.coneAxis == glm::vec3(0.0f) || minDot <= 0.0f ? 1.0f : sqrt(1.0f - minDot * minDot);
+
+		//Vértice do cone: o ponto do eixo atrás do plano de todos os triângulos. Uma câmera
+		//atrás de todos os planos vê todos de costas
+		float behind = 0.0f;
+		if (meshlet.coneCutoff < 1.0f)
+			for (uint32_t t : triangles)
+				if (normals[t] != glm::vec3(0.0f))
+				{
+					glm::vec3 corner = positionOf(mesh, cornerOf[t * 3]);
+					behind = max(behind, glm::dot(meshlet.center - corner, normals[t]) / glm::dot(meshlet.coneAxis, normals[t]));
+				}
+		meshlet.coneApex = meshlet.center - meshlet.coneAxis * behind;
+	}
+}
+
+void buildMeshlets(MeshData& mesh, size_t firstIndex, size_t indexCount, vector<Meshlet>& meshlets)
+{
+	PROFILE_ZONE("buildMeshlets");
+	meshlets.clear();
+	uint32_t* indices = mesh.indices.data() + firstIndex;
+	size_t triangleCount = indexCount / 3;
+	size_t vertexCount = mesh.vertexCount();
+
+	//Normais geométricas (pela ordem dos vértices), que decidem o lado de cada triângulo
+	vector<glm::vec3> normals(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		glm::vec3 a = positionOf(mesh, indices[t * 3]);
+		glm::vec3 b = positionOf(mesh, indices[t * 3 + 1]);
+		glm::vec3 c = positionOf(mesh, indices[t * 3 + 2]);
+		normals[t] = normalizeOrZero(glm::cross(b - a, c - a));
+	}
+
+	//Vizinhança pela posição soldada: vértices com a mesma posição e atributos diferentes
+	//(costuras de textura e quinas) não separam a malha em pedaços
+	vector<uint32_t> weld(vertexCount);
+	{
+		unordered_map<PositionKey, uint32_t, PositionHash> first;
+		first.reserve(vertexCount);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			PositionKey key;
+			memcpy(&key, &mesh.vertices[v * OBJ_FLOATS_PER_VERTEX], sizeof(key));
+			weld[v] = first.emplace(key, (uint32_t)v).first->second;
+		}
+	}
+
+	//Triângulos de cada posição, em listas contíguas
+	vector<uint32_t> adjacencyStart(vertexCount + 1, 0), adjacency(triangleCount * 3);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		adjacencyStart[weld[indices[i]] + 1]++;
+	for (size_t v = 0; v < vertexCount; v++)
+		adjacencyStart[v + 1] += adjacencyStart[v];
+	vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		adjacency[fill[weld[indices[i]]]++] = (uint32_t)(i / 3);
+
+	vector<uint8_t> used(triangleCount, 0);
+	//Meshlet que já usa cada vértice
+	vector<uint32_t> owner(vertexCount, UINT32_MAX);
+	vector<uint32_t> order, triangles, vertices, candidates;
+	order.reserve(triangleCount);
+	size_t seed = 0;
+	while (order.size() < triangleCount)
+	{
+		while (used[seed])
+			seed++;
+		uint32_t id = (uint32_t)meshlets.size();
+		triangles.clear();
+		vertices.clear();
+		candidates.clear();
+		glm::vec3 normalSum(0.0f);
+
+		auto add = [&](uint32_t t) {
+			used[t] = 1;
+			triangles.push_back(t);
+			normalSum += normals[t];
+			for (int k = 0; k < 3; k++)
+			{
+				uint32_t v = indices[t * 3 + k];
+				if (owner[v] == id)
+					continue;
+				owner[v] = id;
+				vertices.push_back(v);
+				uint32_t w = weld[v];
+				for (uint32_t a = adjacencyStart[w]; a < adjacencyStart[w + 1]; a++)
+					if (!used[adjacency[a]])
+						candidates.push_back(adjacency[a]);
+			}
+		};
+		add((uint32_t)seed);
+
+		//Cresce pelos vizinhos enquanto couber; sem vizinho livre que caiba, fecha o meshlet
+		while (triangles.size() < MESHLET_MAX_TRIANGLES)
+		{
+			glm::vec3 axis = normalizeOrZero(normalSum);
+			size_t kept = 0;
+			int best = -1;
+			float bestScore = FLT_MAX;
+			for (size_t c = 0; c < candidates.size(); c++)
+			{
+				uint32_t t = candidates[c];
+				if (used[t])
+					continue;
+				candidates[kept++] = t;
+				int added = (owner[indices[t * 3]] != id) + (owner[indices[t * 3 + 1]] != id) + (owner[indices[t * 3 + 2]] != id);
+				if (vertices.size() + added > MESHLET_MAX_VERTICES)
+					continue;
+				//Cada vértice novo pesa tanto quanto meia volta da normal em relação ao eixo
+				float score = added + 2.0f * (1.0f - glm::dot(normals[t], axis));
+				if (score < bestScore)
+				{
+					bestScore = score;
+					best = (int)t;
+				}
+			}
+			candidates.resize(kept);
+			if (best < 0)
+				break;
+			add((uint32_t)best);
+		}
+
+		Meshlet meshlet;
+		meshlet.firstIndex = (uint32_t)(firstIndex + order.size() * 3);
+		meshlet.triangleCount = (uint32_t)triangles.size();
+		meshlet.vertexCount = (uint32_t)vertices.size();
+		meshletBounds(mesh, triangles, normals, indices, vertices, meshlet);
+		meshlets.push_back(meshlet);
+		order.insert(order.end(), triangles.begin(), triangles.end());
+	}
+
+	vector<uint32_t> reordered(triangleCount * 3);
+	for (size_t i = 0; i < triangleCount; i++)
+		for (int k = 0; k < 3; k++)
+			reordered[i * 3 + k] = indices[order[i] * 3 + k];
+	copy(reordered.begin(), reordered.end(), indices);
+}
+
+MeshletView meshletView(const glm::mat4& viewProjection, const glm::mat4& model, glm::vec3 cameraPos)
+{
+	MeshletView view;
+	extractFrustumPlanes(viewProjection * model, view.planes);
+	view.cameraPos = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+	return view;
+}
+
+int classifyMeshlet(const Meshlet& meshlet, const MeshletView& view)
+{
+	for (int p = 0; p < 6; p++)
+		if (glm::dot(glm::vec3(view.planes[p]), meshlet.center) + view.planes[p].w < -meshlet.radius)
+			return MESHLET_OUTSIDE;
+
+	//Todos os triângulos estão de costas se a direção da câmera ao vértice do cone fica a
+	//menos de 90 graus menos a abertura do cone do seu eixo: dot(d, eixo) >= seno da abertura * |d|
+	if (meshlet.coneCutoff < 1.0f)
+	{
+		glm::vec3 direction = meshlet.coneApex - view.cameraPos;
+		if (glm::dot(direction, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(direction))
+			return MESHLET_BACKFACING;
+	}
+	return MESHLET_VISIBLE;
+}
+
+void MeshletStats::add(const Meshlet& meshlet, int visibility)
+{
+	meshlets++;
+	triangles += meshlet.triangleCount;
+	if (visibility == MESHLET_OUTSIDE)
+	{
+		outsideMeshlets++;
+		outsideTriangles += meshlet.triangleCount;
+	}
+	else if (visibility == MESHLET_BACKFACING)
+	{
+		backfacingMeshlets++;
+		backfacingTriangles += meshlet.triangleCount;
+	}
+}
+
+void MeshletStats::add(const MeshletStats& other)
+{
+	meshlets += other.meshlets;
+	triangles += other.triangles;
+	outsideMeshlets += other.outsideMeshlets;
+	outsideTriangles += other.outsideTriangles;
+	backfacingMeshlets += other.backfacingMeshlets;
+	backfacingTriangles += other.backfacingTriangles;
+}
+
+float MeshletStats::rejectionRate() const
+{
+	return triangles > 0 ? (float)(outsideTriangles + backfacingTriangles) / triangles : 0.0f;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "ObjLoader.h"
+#include "MeshCache.h"
+
+// Limites de cada meshlet, os mesmos dos mesh shaders (64 vértices e 124 triângulos
+// cabem nos buffers de saída de um grupo)
+const size_t MESHLET_MAX_VERTICES = 64;
+const size_t MESHLET_MAX_TRIANGLES = 124;
+
+// Divide os triângulos de mesh.indices[firstIndex, firstIndex + indexCount) em meshlets e
+// os reordena dentro desse trecho, para que cada meshlet seja um intervalo contínuo.
+// Cada meshlet cresce a partir do primeiro triângulo livre (na ordem atual, que depois do
+// MeshOptimizer.h já é local) pelos triângulos vizinhos (pela posição, atravessando as
+// costuras), preferindo os que trazem menos vértices novos e têm a normal mais próxima do
+// eixo do cone, o que deixa esferas e cones apertados. vertices no layout de 11 floats do loader
+void buildMeshlets(MeshData& mesh, size_t firstIndex, size_t indexCount, std::vector<Meshlet>& meshlets);
+
+// Frustum e câmera de um quadro levados para o espaço do objeto de uma Mesh: os planos são
+// os de viewProjection * model e a câmera passa pela inversa do modelo. Os dois testes
+// continuam exatos para qualquer matriz de modelo afim, inclusive com escala não uniforme
+struct MeshletView
+{
+	glm::vec4 planes[6];
+	glm::vec3 cameraPos;
+};
+
+MeshletView meshletView(const glm::mat4& viewProjection, const glm::mat4& model, glm::vec3 cameraPos);
+
+// Resultado do teste de um meshlet
+const int MESHLET_VISIBLE = 0;
+const int MESHLET_OUTSIDE = 1;    //esfera inteira fora de algum plano do frustum
+const int MESHLET_BACKFACING = 2; //todos os triângulos de costas para a câmera
+
+// Teste conservador: um meshlet só é descartado se nenhum dos seus triângulos pode
+// aparecer. De costas vale para superfícies fechadas, como o desenho não descarta as faces
+// de trás: o lado de dentro de uma malha aberta deixaria de aparecer
+int classifyMeshlet(const Meshlet& meshlet, const MeshletView& view);
+
+// Triângulos testados e descartados, somados em vários testes
+struct MeshletStats
+{
+	size_t meshlets = 0;
+	size_t triangles = 0;
+	size_t outsideMeshlets = 0;
+	size_t outsideTriangles = 0;
+	size_t backfacingMeshlets = 0;
+	size_t backfacingTriangles = 0;
+
+	void add(const Meshlet& meshlet, int visibility);
+	void add(const MeshletStats& other);
+	// Fração dos triângulos testados que foram descartados
+	float rejectionRate() const;
+};
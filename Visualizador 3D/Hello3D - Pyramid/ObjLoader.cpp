@@ -0,0 +1,619 @@
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+
+using namespace std;
+
+namespace
+{
+	const double powersOf10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+		1e21, 1e22
+	};
+
+	inline bool isBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline bool isDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	inline const char* skipBlanks(const char* p, const char* end)
+	{
+		while (p < end && isBlank(*p))
+			p++;
+		return p;
+	}
+
+	inline const char* skipLine(const char* p, const char* end)
+	{
+		const char* nl = (const char*)memchr(p, '\n', end - p);
+		return nl ? nl + 1 : end;
+	}
+
+	// Lê um inteiro com sinal opcional a partir de p
+	inline const char* scanInt(const char* p, const char* end, int& out)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			p++;
+		}
+		int value = 0;
+		while (p < end && isDigit(*p))
+		{
+			value = value * 10 + (*p - '0');
+			p++;
+		}
+		out = negative ? -value : value;
+		return p;
+	}
+
+	// Lê um float em notação decimal ou científica a partir de p.
+	// A mantissa é acumulada como inteiro e escalada uma única vez no final,
+	// o que dá o mesmo resultado de strtof exceto em casos raríssimos de arredondamento
+	inline const char* scanFloat(const char* p, const char* end, float& out)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			p++;
+		}
+
+		uint64_t mantissa = 0;
+		int exponent = 0;
+		while (p < end && isDigit(*p))
+		{
+			if (mantissa < 100000000000000000ULL)
+				mantissa = mantissa * 10 + (*p - '0');
+			else
+				exponent++;
+			p++;
+		}
+		if (p < end && *p == '.')
+		{
+			p++;
+			while (p < end && isDigit(*p))
+			{
+				if (mantissa < 100000000000000000ULL)
+				{
+					mantissa = mantissa * 10 + (*p - '0');
+					exponent--;
+				}
+				p++;
+			}
+		}
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			int e;
+			p = scanInt(p + 1, end, e);
+			exponent += e;
+		}
+
+		double value = (double)mantissa;
+		if (exponent < 0)
+			value = exponent >= -22 ? value / powersOf10[-exponent] : value * pow(10.0, exponent);
+		else if (exponent > 0)
+			value = exponent <= 22 ? value * powersOf10[exponent] : value * pow(10.0, exponent);
+
+		out = (float)(negative ? -value : value);
+		return p;
+	}
+
+	// Converte um índice do .obj (base 1, ou negativo relativo ao fim) para base 0.
+	// Retorna -1 se o índice estiver ausente ou fora do intervalo
+	inline int resolveIndex(int index, size_t count)
+	{
+		if (index > 0)
+			return (size_t)index <= count ? index - 1 : -1;
+		if (index < 0)
+			return (size_t)(-index) <= count ? (int)count + index : -1;
+		return -1;
+	}
+
+	struct Corner
+	{
+		int v, vt, vn;
+	};
+
+	// Face como lida do arquivo: os índices ficam crus (como no .obj) junto com
+	// quantos v/vt/vn o trecho já tinha lido, para que a resolução dos índices
+	// feita depois da junção seja idêntica à de uma leitura sequencial
+	struct FaceRecord
+	{
+		size_t firstCorner;
+		int nCorners;
+		size_t nPositions, nTexCoords, nNormals;
+	};
+
+	// Trecho do arquivo (sempre começando e terminando em fim de linha)
+	struct ObjChunk
+	{
+		const char* begin;
+		const char* end;
+		vector <glm::vec3> positions;
+		vector <glm::vec2> texCoords;
+		vector <glm::vec3> normals;
+		vector <Corner> corners;
+		vector <FaceRecord> faces;
+		size_t nTriangles = 0;
+
+		//Preenchidos na junção: deslocamentos globais deste trecho
+		size_t basePositions = 0, baseTexCoords = 0, baseNormals = 0;
+		size_t firstTriangle = 0;
+	};
+
+	//Trechos menores que isso não compensam uma thread
+	const size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+	void parseChunk(ObjChunk& chunk)
+	{
+		PROFILE_ZONE("OBJ parse chunk");
+		const char* p = chunk.begin;
+		const char* end = chunk.end;
+
+		while (p < end)
+		{
+			p = skipBlanks(p, end);
+			if (p >= end)
+				break;
+
+			if (p[0] == 'v' && p + 1 < end)
+			{
+				if (isBlank(p[1]))
+				{
+					glm::vec3 v;
+					p = scanFloat(skipBlanks(p + 2, end), end, v.x);
+					p = scanFloat(skipBlanks(p, end), end, v.y);
+					p = scanFloat(skipBlanks(p, end), end, v.z);
+					chunk.positions.push_back(v);
+				}
+				else if (p[1] == 't' && p + 2 < end && isBlank(p[2]))
+				{
+					glm::vec2 vt;
+					p = scanFloat(skipBlanks(p + 3, end), end, vt.s);
+					p = scanFloat(skipBlanks(p, end), end, vt.t);
+					chunk.texCoords.push_back(vt);
+				}
+				else if (p[1] == 'n' && p + 2 < end && isBlank(p[2]))
+				{
+					glm::vec3 vn;
+					p = scanFloat(skipBlanks(p + 3, end), end, vn.x);
+					p = scanFloat(skipBlanks(p, end), end, vn.y);
+					p = scanFloat(skipBlanks(p, end), end, vn.z);
+					chunk.normals.push_back(vn);
+				}
+			}
+			else if (p[0] == 'f' && p + 1 < end && isBlank(p[1]))
+			{
+				FaceRecord face;
+				face.firstCorner = chunk.corners.size();
+				face.nPositions = chunk.positions.size();
+				face.nTexCoords = chunk.texCoords.size();
+				face.nNormals = chunk.normals.size();
+
+				p++;
+				while (true)
+				{
+					p = skipBlanks(p, end);
+					if (p >= end || !(isDigit(*p) || *p == '-' || *p == '+'))
+						break;
+
+					//Cada canto tem o formato v, v/vt, v//vn ou v/vt/vn
+					Corner c = { 0, 0, 0 };
+					p = scanInt(p, end, c.v);
+					if (p < end && *p == '/')
+					{
+						p++;
+						if (p < end && *p != '/')
+							p = scanInt(p, end, c.vt);
+						if (p < end && *p == '/')
+							p = scanInt(p + 1, end, c.vn);
+					}
+					chunk.corners.push_back(c);
+				}
+
+				face.nCorners = (int)(chunk.corners.size() - face.firstCorner);
+				if (face.nCorners >= 3)
+				{
+					chunk.faces.push_back(face);
+					chunk.nTriangles += face.nCorners - 2;
+				}
+				else
+				{
+					chunk.corners.resize(face.firstCorner);
+				}
+			}
+
+			p = skipLine(p, end);
+		}
+	}
+
+	// Gera os vértices intercalados das faces do trecho, já com os índices
+	// resolvidos contra os atributos globais (todos os trechos juntos)
+	void emitChunk(const ObjChunk& chunk, const vector<glm::vec3>& positions, const vector<glm::vec2>& texCoords,
+		const vector<glm::vec3>& normals, glm::vec3 color, float* out)
+	{
+		for (const FaceRecord& face : chunk.faces)
+		{
+			size_t nPositions = chunk.basePositions + face.nPositions;
+			size_t nTexCoords = chunk.baseTexCoords + face.nTexCoords;
+			size_t nNormals = chunk.baseNormals + face.nNormals;
+			const Corner* corners = &chunk.corners[face.firstCorner];
+
+			//Triangulação em leque: (0, i, i + 1)
+			for (int i = 1; i + 1 < face.nCorners; i++)
+			{
+				const Corner tri[3] = { corners[0], corners[i], corners[i + 1] };
+				for (int k = 0; k < 3; k++)
+				{
+					int v = resolveIndex(tri[k].v, nPositions);
+					int vt = resolveIndex(tri[k].vt, nTexCoords);
+					int vn = resolveIndex(tri[k].vn, nNormals);
+
+					glm::vec3 pos = v >= 0 ? positions[v] : glm::vec3(0.0f);
+					glm::vec2 uv = vt >= 0 ? texCoords[vt] : glm::vec2(0.0f);
+					glm::vec3 nrm = vn >= 0 ? normals[vn] : glm::vec3(0.0f);
+
+					out[0] = pos.x;  out[1] = pos.y;  out[2] = pos.z;
+					out[3] = color.r;  out[4] = color.g;  out[5] = color.b;
+					out[6] = uv.s;  out[7] = uv.t;
+					out[8] = nrm.x;  out[9] = nrm.y;  out[10] = nrm.z;
+					out += OBJ_FLOATS_PER_VERTEX;
+				}
+			}
+		}
+	}
+
+	// Resultado da leitura (ainda sem gerar vértices): trechos com as faces e
+	// os atributos de todos os trechos já concatenados em ordem de arquivo
+	struct ParsedOBJ
+	{
+		vector <ObjChunk> chunks;
+		vector <glm::vec3> positions;
+		vector <glm::vec2> texCoords;
+		vector <glm::vec3> normals;
+		size_t nTriangles = 0;
+		unique_ptr<ThreadPool> pool;
+	};
+
+	bool readOBJ(const string& filepath, int nThreads, ParsedOBJ& obj)
+	{
+		PROFILE_ZONE("OBJ read");
+		MappedFile file;
+		if (!file.open(filepath))
+		{
+			cout << "Problema ao encontrar o arquivo " << filepath << endl;
+			return false;
+		}
+
+		if (nThreads <= 0)
+			nThreads = ThreadPool::hardwareThreads();
+
+		//Divide o arquivo em trechos de tamanho parecido, cortando sempre em fim de linha.
+		//Mais trechos que threads equilibram melhor a carga entre linhas v e f
+		const char* data = file.data();
+		const char* end = data + file.size();
+		size_t nChunks = nThreads == 1 ? 1 : (size_t)nThreads * 4;
+		nChunks = max((size_t)1, min(nChunks, file.size() / MIN_CHUNK_BYTES));
+
+		vector <ObjChunk>& chunks = obj.chunks;
+		chunks.resize(nChunks);
+		const char* begin = data;
+		for (size_t i = 0; i < nChunks; i++)
+		{
+			const char* cut = i + 1 == nChunks ? end : data + file.size() / nChunks * (i + 1);
+			if (cut < begin)
+				cut = begin;
+			if (cut < end)
+				cut = skipLine(cut, end);
+			chunks[i].begin = begin;
+			chunks[i].end = cut;
+			begin = cut;
+		}
+
+		obj.pool.reset(new ThreadPool(min((int)nChunks, nThreads)));
+		obj.pool->parallelFor((int)nChunks, [&](int i) { parseChunk(chunks[i]); });
+
+		//Junção em ordem de arquivo: deslocamentos globais de cada trecho
+		size_t nPositions = 0, nTexCoords = 0, nNormals = 0, nTriangles = 0;
+		for (ObjChunk& chunk : chunks)
+		{
+			chunk.basePositions = nPositions;
+			chunk.baseTexCoords = nTexCoords;
+			chunk.baseNormals = nNormals;
+			chunk.firstTriangle = nTriangles;
+			nPositions += chunk.positions.size();
+			nTexCoords += chunk.texCoords.size();
+			nNormals += chunk.normals.size();
+			nTriangles += chunk.nTriangles;
+		}
+		obj.nTriangles = nTriangles;
+
+		if (nChunks == 1)
+		{
+			obj.positions.swap(chunks[0].positions);
+			obj.texCoords.swap(chunks[0].texCoords);
+			obj.normals.swap(chunks[0].normals);
+		}
+		else
+		{
+			obj.positions.resize(nPositions);
+			obj.texCoords.resize(nTexCoords);
+			obj.normals.resize(nNormals);
+			obj.pool->parallelFor((int)nChunks, [&](int i) {
+				PROFILE_ZONE("OBJ merge chunk");
+				ObjChunk& chunk = chunks[i];
+				copy(chunk.positions.begin(), chunk.positions.end(), obj.positions.begin() + chunk.basePositions);
+				copy(chunk.texCoords.begin(), chunk.texCoords.end(), obj.texCoords.begin() + chunk.baseTexCoords);
+				copy(chunk.normals.begin(), chunk.normals.end(), obj.normals.begin() + chunk.baseNormals);
+				vector<glm::vec3>().swap(chunk.positions);
+				vector<glm::vec2>().swap(chunk.texCoords);
+				vector<glm::vec3>().swap(chunk.normals);
+			});
+		}
+		return true;
+	}
+
+	// Tabela hash de endereçamento aberto: trinca (v, vt, vn) -> vértice único
+	class VertexTable
+	{
+	public:
+		VertexTable(size_t expected)
+		{
+			size_t capacity = 1024;
+			while (capacity < expected * 2)
+				capacity <<= 1;
+			slots.assign(capacity, Slot());
+		}
+
+		// Retorna o índice do vértice; se a trinca é nova, usa newIndex
+		uint32_t findOrInsert(int v, int vt, int vn, uint32_t newIndex, bool& inserted)
+		{
+			if ((used + 1) * 2 > slots.size())
+				grow();
+			size_t mask = slots.size() - 1;
+			size_t i = hash(v, vt, vn) & mask;
+			while (true)
+			{
+				Slot& slot = slots[i];
+				if (slot.index == EMPTY)
+				{
+					slot.v = v;  slot.vt = vt;  slot.vn = vn;
+					slot.index = newIndex;
+					used++;
+					inserted = true;
+					return newIndex;
+				}
+				if (slot.v == v && slot.vt == vt && slot.vn == vn)
+				{
+					inserted = false;
+					return slot.index;
+				}
+				i = (i + 1) & mask;
+			}
+		}
+
+	private:
+		static const uint32_t EMPTY = 0xFFFFFFFFu;
+
+		struct Slot
+		{
+			int v = 0, vt = 0, vn = 0;
+			uint32_t index = EMPTY;
+		};
+
+		static size_t hash(int v, int vt, int vn)
+		{
+			uint64_t h = (uint32_t)v * 0x9E3779B97F4A7C15ULL;
+			h ^= ((uint32_t)vt + 0x7F4A7C15ULL) * 0xC2B2AE3D27D4EB4FULL;
+			h ^= ((uint32_t)vn + 0x165667B1ULL) * 0x165667B19E3779F9ULL;
+			return (size_t)(h ^ (h >> 29));
+		}
+
+		void grow()
+		{
+			vector<Slot> old;
+			old.swap(slots);
+			slots.assign(old.size() * 2, Slot());
+			size_t mask = slots.size() - 1;
+			for (const Slot& slot : old)
+			{
+				if (slot.index == EMPTY)
+					continue;
+				size_t i = hash(slot.v, slot.vt, slot.vn) & mask;
+				while (slots[i].index != EMPTY)
+					i = (i + 1) & mask;
+				slots[i] = slot;
+			}
+		}
+
+		vector<Slot> slots;
+		size_t used = 0;
+	};
+}
+
+bool parseOBJ(const string& filepath, glm::vec3 color, vector<float>& vbuffer, int nThreads)
+{
+	ParsedOBJ obj;
+	if (!readOBJ(filepath, nThreads, obj))
+		return false;
+
+	size_t first = vbuffer.size();
+	vbuffer.resize(first + obj.nTriangles * 3 * OBJ_FLOATS_PER_VERTEX);
+	float* out = vbuffer.data() + first;
+	obj.pool->parallelFor((int)obj.chunks.size(), [&](int i) {
+		const ObjChunk& chunk = obj.chunks[i];
+		emitChunk(chunk, obj.positions, obj.texCoords, obj.normals, color, out + chunk.firstTriangle * 3 * OBJ_FLOATS_PER_VERTEX);
+	});
+
+	return true;
+}
+
+bool parseOBJIndexed(const string& filepath, glm::vec3 color, MeshData& mesh, int nThreads)
+{
+	ParsedOBJ obj;
+	if (!readOBJ(filepath, nThreads, obj))
+		return false;
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+	mesh.indices.reserve(obj.nTriangles * 3);
+	mesh.vertices.reserve(obj.positions.size() * OBJ_FLOATS_PER_VERTEX);
+
+	//A deduplicação percorre as faces em ordem de arquivo, então a numeração
+	//dos vértices é a ordem do primeiro uso e não depende do número de threads
+	PROFILE_ZONE("OBJ deduplicate");
+	VertexTable table(obj.positions.size());
+	for (const ObjChunk& chunk : obj.chunks)
+	{
+		for (const FaceRecord& face : chunk.faces)
+		{
+			size_t nPositions = chunk.basePositions + face.nPositions;
+			size_t nTexCoords = chunk.baseTexCoords + face.nTexCoords;
+			size_t nNormals = chunk.baseNormals + face.nNormals;
+			const Corner* corners = &chunk.corners[face.firstCorner];
+
+			uint32_t faceIndices[3];
+			for (int i = 0; i < face.nCorners; i++)
+			{
+				int v = resolveIndex(corners[i].v, nPositions);
+				int vt = resolveIndex(corners[i].vt, nTexCoords);
+				int vn = resolveIndex(corners[i].vn, nNormals);
+
+				bool inserted;
+				uint32_t index = table.findOrInsert(v, vt, vn, (uint32_t)mesh.vertexCount(), inserted);
+				if (inserted)
+				{
+					glm::vec3 pos = v >= 0 ? obj.positions[v] : glm::vec3(0.0f);
+					glm::vec2 uv = vt >= 0 ? obj.texCoords[vt] : glm::vec2(0.0f);
+					glm::vec3 nrm = vn >= 0 ? obj.normals[vn] : glm::vec3(0.0f);
+					const float vertex[OBJ_FLOATS_PER_VERTEX] = {
+						pos.x, pos.y, pos.z, color.r, color.g, color.b, uv.s, uv.t, nrm.x, nrm.y, nrm.z
+					};
+					mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + OBJ_FLOATS_PER_VERTEX);
+				}
+
+				//Triangulação em leque: (0, i - 1, i)
+				if (i == 0)
+					faceIndices[0] = index;
+				else if (i == 1)
+					faceIndices[2] = index;
+				else
+				{
+					faceIndices[1] = faceIndices[2];
+					faceIndices[2] = index;
+					mesh.indices.insert(mesh.indices.end(), faceIndices, faceIndices + 3);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+bool parseOBJStream(const string& filepath, glm::vec3 color, vector<float>& vbuffer)
+{
+	vector <glm::vec3> vertices;
+	vector <glm::vec2> texCoords;
+	vector <glm::vec3> normals;
+
+	ifstream inputFile;
+	inputFile.open(filepath.c_str());
+	if (!inputFile.is_open())
+	{
+		cout << "Problema ao encontrar o arquivo " << filepath << endl;
+		return false;
+	}
+
+	char line[100];
+	string sline;
+
+	while (!inputFile.eof())
+	{
+		inputFile.getline(line, 100);
+		sline = line;
+
+		string word;
+
+		istringstream ssline(line);
+		ssline >> word;
+
+		if (word == "v")
+		{
+			glm::vec3 v;
+			ssline >> v.x >> v.y >> v.z;
+			vertices.push_back(v);
+		}
+		if (word == "vt")
+		{
+			glm::vec2 vt;
+			ssline >> vt.s >> vt.t;
+			texCoords.push_back(vt);
+		}
+		if (word == "vn")
+		{
+			glm::vec3 vn;
+			ssline >> vn.x >> vn.y >> vn.z;
+			normals.push_back(vn);
+		}
+		if (word == "f")
+		{
+			string tokens[3];
+
+			ssline >> tokens[0] >> tokens[1] >> tokens[2];
+
+			for (int i = 0; i < 3; i++)
+			{
+				//Recuperando os indices de v
+				int pos = tokens[i].find("/");
+				string token = tokens[i].substr(0, pos);
+				int index = atoi(token.c_str()) - 1;
+
+				vbuffer.push_back(vertices[index].x);
+				vbuffer.push_back(vertices[index].y);
+				vbuffer.push_back(vertices[index].z);
+				vbuffer.push_back(color.r);
+				vbuffer.push_back(color.g);
+				vbuffer.push_back(color.b);
+
+				//Recuperando os indices de vts
+				tokens[i] = tokens[i].substr(pos + 1);
+				pos = tokens[i].find("/");
+				token = tokens[i].substr(0, pos);
+				index = atoi(token.c_str()) - 1;
+
+				vbuffer.push_back(texCoords[index].s);
+				vbuffer.push_back(texCoords[index].t);
+
+				//Recuperando os indices de vns
+				tokens[i] = tokens[i].substr(pos + 1);
+				index = atoi(tokens[i].c_str()) - 1;
+
+				vbuffer.push_back(normals[index].x);
+				vbuffer.push_back(normals[index].y);
+				vbuffer.push_back(normals[index].z);
+			}
+		}
+	}
+	inputFile.close();
+
+	return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//GLM
+#include <glm/glm.hpp>
+
+// Número de floats por vértice no buffer intercalado gerado pelo loader:
+// posição (x, y, z), cor (r, g, b), coordenada de textura (s, t) e normal (x, y, z)
+const int OBJ_FLOATS_PER_VERTEX = 11;
+
+// Geometria indexada: cada trinca (v, vt, vn) distinta do arquivo vira um único
+// vértice no layout de 11 floats, e os triângulos referenciam esses vértices
+struct MeshData
+{
+	std::vector<float> vertices;
+	std::vector<uint32_t> indices;
+
+	size_t vertexCount() const { return vertices.size() / OBJ_FLOATS_PER_VERTEX; }
+};
+
+// Lê um arquivo .obj mapeando-o em memória e interpretando os registros
+// v/vt/vn/f diretamente no buffer mapeado (sem streams e sem locale).
+// Faces com mais de 3 vértices são trianguladas em leque.
+// Preenche vbuffer com um vértice de 11 floats por canto de triângulo.
+// Com nThreads > 1 o arquivo é dividido em trechos (em fim de linha) lidos em
+// paralelo e juntados em ordem; o resultado é idêntico byte a byte ao de 1 thread.
+// nThreads <= 0 usa todos os núcleos
+bool parseOBJ(const std::string& filepath, glm::vec3 color, std::vector<float>& vbuffer, int nThreads = 1);
+
+// Mesma leitura de parseOBJ, mas deduplicando os vértices em vez de repetir
+// os 11 floats a cada canto de triângulo
+bool parseOBJIndexed(const std::string& filepath, glm::vec3 color, MeshData& mesh, int nThreads = 1);
+
+// Implementação original (getline + istringstream), mantida como referência
+// para os benchmarks de carregamento
+bool parseOBJStream(const std::string& filepath, glm::vec3 color, std::vector<float>& vbuffer);
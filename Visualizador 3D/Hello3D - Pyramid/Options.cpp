@@ -0,0 +1,107 @@
+#include "Options.h"
+
+#include <string>
+#include <cstdlib>
+
+using namespace std;
+
+AppOptions parseOptions(int argc, char** argv)
+{
+	AppOptions options;
+	bool framesGiven = false, outputGiven = false;
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc)
+			options.loaderThreads = atoi(argv[++i]);
+		else if (arg == "--no-cache")
+			options.useMeshCache = false;
+		else if (arg == "--cold-cache")
+			options.rebuildMeshCache = true;
+		else if (arg == "--instanced")
+			options.instanced = true;
+		else if (arg == "--indirect")
+			options.indirect = true;
+		else if (arg == "--no-cull")
+			options.frustumCulling = false;
+		else if (arg == "--bvh-cull")
+			options.bvhCulling = true;
+		else if (arg == "--scene" && i + 1 < argc)
+			options.valid = options.scene.load(argv[++i]) && options.valid;
+		else if (arg == "--model" && i + 1 < argc)
+			options.scene.models.push_back(argv[++i]);
+		else if (arg == "--camera" && i + 7 < argc)
+		{
+			CameraKey key;
+			key.time = (float)atof(argv[++i]);
+			for (int k = 0; k < 3; k++)
+				key.position[k] = (float)atof(argv[++i]);
+			for (int k = 0; k < 3; k++)
+				key.target[k] = (float)atof(argv[++i]);
+			options.scene.addCameraKey(key);
+		}
+		else if (arg == "--headless")
+			options.headless = true;
+		else if (arg == "--frames" && i + 1 < argc)
+		{
+			options.frames = atoi(argv[++i]);
+			framesGiven = true;
+		}
+		else if (arg == "--size" && i + 2 < argc)
+		{
+			options.width = atoi(argv[++i]);
+			options.height = atoi(argv[++i]);
+		}
+		else if (arg == "--output" && i + 1 < argc)
+		{
+			options.outputPrefix = argv[++i];
+			outputGiven = true;
+		}
+		else if (arg == "--egl")
+			options.egl = true;
+		else if (arg == "--benchmark")
+			options.benchmark = true;
+		else if (arg == "--json" && i + 1 < argc)
+			options.benchmarkJson = argv[++i];
+		else if (arg == "--warmup" && i + 1 < argc)
+			options.warmupFrames = atoi(argv[++i]);
+		else if (arg == "--software")
+			options.software = true;
+		else if (arg == "--profile" && i + 1 < argc)
+			options.profilePath = argv[++i];
+		else if (arg == "--sync-load")
+			options.asyncLoading = false;
+		else if (arg == "--load-threads" && i + 1 < argc)
+			options.loadThreads = atoi(argv[++i]);
+		else if (arg == "--load-queue" && i + 1 < argc)
+			options.loadQueue = atoi(argv[++i]);
+		else if (arg == "--upload-budget" && i + 1 < argc)
+			options.uploadBudgetMs = atof(argv[++i]);
+		else if (arg == "--upload-ring" && i + 1 < argc)
+			options.uploadRingMB = atoi(argv[++i]);
+		else if (arg == "--no-pool")
+			options.geometryPool = false;
+		else if (arg == "--no-lod")
+			options.lod = false;
+		else if (arg == "--lod-pixels" && i + 1 < argc)
+			options.lodPixels = (float)atof(argv[++i]);
+		else if (arg == "--optimize-mesh")
+			options.optimizeMesh = true;
+		else if (arg == "--float-vertices")
+			options.packedVertices = false;
+		else if (arg == "--meshlets")
+			options.meshlets = true;
+		else if (arg == "--instances" && i + 2 < argc)
+		{
+			options.instanceModel = argv[++i];
+			options.instanceCount = atoi(argv[++i]);
+		}
+	}
+
+	//O benchmark mede o desenho, não a gravação das imagens
+	if (options.benchmark && !framesGiven)
+		options.frames = 300;
+	if (options.benchmark && !outputGiven)
+		options.outputPrefix.clear();
+	return options;
+}
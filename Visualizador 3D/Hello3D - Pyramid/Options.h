@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+
+#include "Scene.h"
+
+// Opções de execução lidas da linha de comando
+//   --threads <n>    threads usadas na leitura dos .obj (0 = todos os núcleos)
+//   --no-cache       não lê nem grava o cache binário das malhas
+//   --cold-cache     ignora os caches existentes e refaz todos (para medir a carga a frio)
+//   --instanced      desenha agrupando as Mesh por geometria (glDrawElementsInstanced)
+//   --indirect       desenha a cena com glMultiDrawElementsIndirect, uma chamada por arena do
+//                    GeometryPool (ver IndirectRenderer.h); sem suporte no contexto, volta
+//                    ao desenho por Mesh
+//   --instances <arquivo> <n>   cena de teste com n cópias do modelo, em grade (sem perguntar os modelos)
+//   --no-cull        desenha todos os objetos, sem o culling por frustum
+//   --bvh-cull       faz o culling percorrendo a BVH da cena em vez de testar a lista inteira
+//   --scene <arquivo>           modelos e caminho de câmera lidos do arquivo (ver Scene.h)
+//   --model <arquivo>           acrescenta um modelo à cena (pode repetir)
+//   --camera <t> <px> <py> <pz> <ax> <ay> <az>   acrescenta uma chave ao caminho de câmera
+//   --headless       desenha num framebuffer fora da tela, com a janela invisível, e encerra
+//   --frames <n>     quadros desenhados no modo headless, percorrendo o caminho de câmera
+//   --size <l> <a>   largura e altura das imagens do modo headless
+//   --output <prefixo>          imagens gravadas como <prefixo>0000.ppm ("" não grava)
+//   --egl            cria o contexto pela EGL (Mesa/llvmpipe em máquinas sem GPU)
+//   --benchmark      percorre o caminho de câmera em --frames quadros (300 por padrão) sem
+//                    vsync e grava tempos de CPU/GPU, draw calls e triângulos em JSON.
+//                    Com --headless desenha fora da tela; não grava imagens sem --output
+//   --json <arquivo> destino do resultado do --benchmark (padrão: console)
+//   --warmup <n>     quadros iniciais fora das estatísticas do --benchmark (padrão 10)
+//   --software       desenha na CPU (SoftwareRenderer.h), sem janela nem OpenGL, os --frames
+//                    quadros do caminho de câmera, gravados como no --headless. --threads
+//                    vale também para o desenho
+//   --profile <arquivo>         liga o profiler de zonas e grava o trace (formato Chrome)
+//                               ao sair ou ao apertar T
+//   --sync-load      lê todos os modelos antes do primeiro quadro. Sem ela a janela abre
+//                    logo e os modelos aparecem conforme ficam prontos (ver AsyncLoader.h);
+//                    os modos headless e benchmark sempre carregam antes de desenhar
+//   --load-threads <n>          threads que leem os modelos em segundo plano (padrão 2)
+//   --load-queue <n>            geometrias lidas que podem esperar pelo envio (padrão 4)
+//   --upload-budget <ms>        tempo de cada quadro reservado ao envio para a GPU (padrão 2)
+//   --upload-ring <MB>          bytes por quadro do anel de envio (UploadRing.h) usado pelas
+//                               instâncias e pela carga em segundo plano (padrão 8; 0 desliga)
+//   --no-pool        cada geometria com VAO e buffers próprios, em vez das arenas do GeometryPool
+//   --no-lod         desenha sempre a malha completa, sem gerar os níveis de detalhe
+//                    (MeshSimplifier.h) na carga
+//   --lod-pixels <px>           erro de simplificação aceito na tela, em pixels, na escolha
+//                               do nível de cada Mesh (padrão 1)
+//   --optimize-mesh  reordena triângulos e vértices dos modelos para o cache de vértices, o
+//                    overdraw e a leitura dos vértices (MeshOptimizer.h); o cache binário
+//                    guarda a malha já otimizada
+//   --float-vertices vértices no layout de 11 floats, em vez do compactado de 16 bytes
+//                    (VertexPacking.h). O --software sempre usa floats
+//   --meshlets       divide a malha completa dos modelos em meshlets (Meshlets.h) na carga e,
+//                    a cada quadro, descarta na CPU os que estão fora do frustum ou de
+//                    costas; só os que sobram são desenhados, pelo caminho indireto (liga o
+//                    --indirect) ou pelo --software. Como as faces de trás não são
+//                    descartadas no desenho, serve para modelos fechados
+struct AppOptions
+{
+	int loaderThreads = 0;
+	bool useMeshCache = true;
+	bool rebuildMeshCache = false;
+	bool instanced = false;
+	bool indirect = false;
+	std::string instanceModel;
+	int instanceCount = 0;
+	bool frustumCulling = true;
+	bool bvhCulling = false;
+	SceneDescription scene;
+	bool headless = false;
+	int frames = 1;
+	int width = 1200, height = 1200;
+	std::string outputPrefix = "frame";
+	bool egl = false;
+	bool benchmark = false;
+	std::string benchmarkJson;
+	int warmupFrames = 10;
+	std::string profilePath;
+	bool software = false;
+	bool asyncLoading = true;
+	int loadThreads = 2;
+	int loadQueue = 4;
+	double uploadBudgetMs = 2.0;
+	int uploadRingMB = 8;
+	bool geometryPool = true;
+	bool lod = true;
+	float lodPixels = 1.0f;
+	bool optimizeMesh = false;
+	bool packedVertices = true;
+	bool meshlets = false;
+	// false se alguma opção não pôde ser lida (por exemplo, uma cena inválida)
+	bool valid = true;
+};
+
+AppOptions parseOptions(int argc, char** argv);
@@ -13,6 +13,7 @@
 #include <vector>
 #include <fstream>
 #include <sstream>
+#include <cstdio>
 
 using namespace std;
 
@@ -29,6 +30,33 @@ using namespace std;
 
 #include "Shader.h"
 #include "Mesh.h"
+#include "ObjLoader.h"
+#include "Benchmarks.h"
+#include "MeshCache.h"
+#include "Options.h"
+#include "GeometryRegistry.h"
+#include "InstanceRenderer.h"
+#include "IndirectRenderer.h"
+#include "FrustumCuller.h"
+#include "SceneTree.h"
+#include "FrameUniforms.h"
+#include "Framebuffer.h"
+#include "FrameRecorder.h"
+#include "Profiler.h"
+#include "SoftwareRenderer.h"
+#include "AsyncLoader.h"
+#include "GLExtensions.h"
+#include "UploadRing.h"
+#include "GeometryPool.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "VertexPacking.h"
+#include "Meshlets.h"
+
+#include <chrono>
+#include <map>
+#include <cstdint>
+#include <atomic>
 
 // Protótipo da função de callback de teclado
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
@@ -39,10 +67,47 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 // scroll callback
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
+// clique do mouse (seleção do modelo sob o cursor)
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+int pickModel(GLFWwindow* window, double x, double y, uint32_t& triangle);
+
 vector <string> readModels();
 
+// Nomes dos modelos da cena; também põe a câmera no início do caminho
+vector <string> sceneModels();
+
+// Posição do i-ésimo dos count modelos da cena
+glm::vec3 modelPosition(int i, int count);
+
+// Mostra quantos modelos foram carregados e em quanto tempo
+void reportLoad(chrono::steady_clock::time_point loadStart);
+
+// Carrega os modelos da cena em models (shader nulo no renderizador por software)
+void loadModels(Shader* shader);
+
+// Começa a carga dos modelos da cena em segundo plano (ver AsyncLoader.h)
+void startLoading(AsyncLoader& loader);
+
+// Acrescenta a models as Mesh de uma geometria que acabou de chegar à GPU
+void addLoadedModels(PreparedGeometry& prepared, shared_ptr<Geometry> geometry, Shader* shader);
+
+// Avança a luz um passo no seu caminho (mesmo passo a cada quadro)
+void stepLight(float& light_x, float& light_y);
+
+// Mostra quantos triângulos os meshlets descartaram (--meshlets), somados em todos os quadros
+void reportMeshlets(const MeshletStats& stats);
+
+// Cena, laço de desenho e relatórios da janela; retorna o código de saída do programa
+int runViewer(GLFWwindow* window, const GLubyte* renderer);
+
+// Modo --software: desenha os quadros na CPU, sem criar janela nem contexto OpenGL
+int renderSoftware();
+
 // Protótipos das funções
-int loadOBJ(string filepath, int& nVerts, glm::vec3 color);
+shared_ptr<Geometry> loadOBJ(const string& filepath, glm::vec3 color);
+
+// Parte da carga feita na CPU (parse ou cache, caixa envolvente e BVH); roda em qualquer thread
+bool prepareOBJ(PreparedGeometry& prepared, int nThreads);
 
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 1200, HEIGHT = 1200;
@@ -87,16 +152,53 @@ vector <int> numberOfVertices;
 
 int selected = 0;
 
+//Cor dos modelos carregados
+const glm::vec3 modelColor = glm::vec3(0.46, 0.38, 0.16);
+
+AppOptions options;
+GeometryRegistry geometries;
+
+//Arenas com os vértices e índices de todas as geometrias estáticas (ver GeometryPool.h)
+GeometryPool geometryPool;
+
+//Arquivos preparados por prepareOBJ e quantos deles vieram do cache (somados pelas threads da carga)
+atomic<int> preparedFiles(0), cachedFiles(0);
+
+//BVH com as Mesh da cena, atualizada só para as que se moveram
+SceneTree sceneTree;
+
 double axisX = 1.0;
 double axisY = 1.0;
 double axisZ = 1.0;
 
 
 // Função MAIN
-int main()
+int main(int argc, char** argv)
 {
+	// Modos de benchmark rodam sem janela (ver Benchmarks.h) e saem com 1 se uma conferência falhar
+	int benchmarkStatus = runBenchmarks(argc, argv);
+	if (benchmarkStatus != BENCHMARK_NOT_RUN)
+		return benchmarkStatus;
+
+	options = parseOptions(argc, argv);
+	if (!options.valid)
+		return 1;
+
+	//O profiler fica desligado (uma leitura de bool por zona) se não houver onde gravar o trace
+	if (!options.profilePath.empty()) {
+		Profiler::setEnabled(true);
+		Profiler::setThreadName("main");
+	}
+
+	if (options.software)
+		return renderSoftware();
+
 	// Inicialização da GLFW
-	glfwInit();
+	if (!glfwInit())
+	{
+		cout << "Failed to initialize GLFW" << endl;
+		return 1;
+	}
 
 	//Muita atenção aqui: alguns ambientes não aceitam essas configurações
 	//Você deve adaptar para a versão do OpenGL suportada por sua placa
@@ -111,8 +213,26 @@ int main()
 	//	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 	//#endif
 
+	//Sem interação a janela só fornece o contexto: fica invisível e o desenho vai para um FBO.
+	//Drivers Mesa só oferecem versões acima da 3.0 no perfil core
+	if (options.headless)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	}
+	if (options.egl)
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+
 	// Criação da janela GLFW
 	GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Visualizador 3D", nullptr, nullptr);
+	if (window == nullptr)
+	{
+		cout << "Failed to create GLFW window" << endl;
+		glfwTerminate();
+		return 1;
+	}
 	glfwMakeContextCurrent(window);
 
 	// Fazendo o registro da função de callback para a janela GLFW
@@ -124,6 +244,9 @@ int main()
 	//callback do scroll
 	glfwSetScrollCallback(window, scroll_callback);
 
+	//callback dos botões do mouse
+	glfwSetMouseButtonCallback(window, mouse_button_callback);
+
 	//desabilitando cursor mouse
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -133,6 +256,8 @@ int main()
 		std::cout << "Failed to initialize GLAD" << std::endl;
 
 	}
+	//Funções de versões acima da 3.3 (glBufferStorage etc.), quando o contexto oferece
+	loadGLExtensions((GLADloadproc)glfwGetProcAddress);
 
 	// Obtendo as informações de versão
 	const GLubyte* renderer = glGetString(GL_RENDERER); /* get renderer string */
@@ -140,58 +265,113 @@ int main()
 	cout << "Renderer: " << renderer << endl;
 	cout << "OpenGL version supported " << version << endl;
 
+	//Os objetos da cena e do desenho são locais de runViewer: liberam seus buffers antes do fim do contexto
+	int status = runViewer(window, renderer);
+
+	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
+	glfwTerminate();
+	return status;
+}
+
+int runViewer(GLFWwindow* window, const GLubyte* renderer)
+{
 	// Definindo as dimensões da viewport com as mesmas dimensões da janela da aplicação
 	int width, height;
 	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
 
+	//No modo headless a viewport e a projeção usam o tamanho do framebuffer fora da tela
+	Framebuffer offscreen;
+	if (options.headless)
+	{
+		if (!offscreen.initialize(options.width, options.height))
+		{
+			cout << "Framebuffer fora da tela incompleto" << endl;
+			return 1;
+		}
+		offscreen.bind();
+		width = options.width;
+		height = options.height;
+	}
+
 
 	// Compilando e buildando o programa de shader
 	Shader shader("Phong.vs", "Phong.fs");
+	Shader instancedShader("PhongInstanced.vs", "Phong.fs");
 
-	glm::mat4 model = glm::mat4(1); //matriz identidade;
-	GLint modelLoc = glGetUniformLocation(shader.ID, "model");
-	//
-	model = glm::rotate(model, /*(GLfloat)glfwGetTime()*/glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-	glUniformMatrix4fv(modelLoc, 1, FALSE, glm::value_ptr(model));
-
-	//Definindo a matriz de view (posição e orientação da câmera)
-	glm::mat4 view = glm::lookAt(glm::vec3(0.0, 0.0, 3.0), glm::vec3(0.0, 0.0, 0.0), glm::vec3(0.0, 1.0, 0.0));
-	GLint viewLoc = glGetUniformLocation(shader.ID, "view");
-	glUniformMatrix4fv(viewLoc, 1, FALSE, glm::value_ptr(view));
-
-	//Definindo a matriz de projeção perpectiva
-	glm::mat4 projection = glm::perspective(glm::radians(fov), (GLfloat)width / (GLfloat)height, 0.1f, 100.0f);
-	GLint projLoc = glGetUniformLocation(shader.ID, "projection");
-	glUniformMatrix4fv(projLoc, 1, FALSE, glm::value_ptr(projection));
+	//O programa do desenho indireto só é compilado se o contexto oferecer o necessário
+	unique_ptr<Shader> indirectShader;
+	if (options.meshlets) {
+		options.indirect = true;
+	}
+	if (options.indirect && !IndirectRenderer::isSupported()) {
+		cout << "Contexto sem glMultiDrawElementsIndirect ou gl_DrawIDARB: desenhando por Mesh" << endl;
+		options.indirect = false;
+	}
+	if (options.indirect) {
+		indirectShader.reset(new Shader("PhongIndirect.vs", "Phong.fs"));
+	}
 
 	glEnable(GL_DEPTH_TEST);
 
-	model = glm::mat4(1);
-	glUseProgram(shader.ID);
+	//Buffer com os dados do quadro (view, projection, luz e câmera), lido por todos os shaders
+	FrameUniforms frameUniforms;
+	frameUniforms.initialize();
+	FrameData frame;
+	frame.lightColor = glm::vec4(5.0f, 5.0f, 5.0f, 1.0f);
 
-	//Definindo as propriedades do material 
-	shader.setFloat("ka", 0.2);
-	shader.setFloat("kd", 0.5);
-	shader.setFloat("ks", 0.5);
-	shader.setFloat("q", 100);
-	shader.setFloat("n", 0.2);
+	vector<Shader*> programs = { &instancedShader, &shader };
+	if (indirectShader) {
+		programs.push_back(indirectShader.get());
+	}
+	PhongMaterial material;
+	for (Shader* program : programs) {
+		program->use();
+
+		//Definindo as propriedades do material (as mesmas do renderizador por software)
+		program->setFloat("ka", material.ka);
+		program->setFloat("kd", material.kd);
+		program->setFloat("ks", material.ks);
+		program->setFloat("q", material.q);
+		program->setFloat("n", 0.2);
+	}
+
+	//Anel de envio para as instâncias e a carga em segundo plano (sem ele, cada envio mapeia
+	//ou atualiza o buffer de destino direto)
+	UploadRing ring;
+	if (options.uploadRingMB > 0) {
+		ring.initialize((size_t)options.uploadRingMB << 20);
+		cout << "Anel de envio: " << UploadRing::REGIONS << " x " << options.uploadRingMB << " MB" << (ring.isPersistent() ? " (mapeamento persistente)" : " (sem glBufferStorage)") << endl;
+	}
+	UploadRing* uploads = ring.isInitialized() ? &ring : nullptr;
 
-	//Definindo as propriedades da fonte de luz
-	shader.setVec3("lightPos", 10, 5, 0);
-	shader.setVec3("lightColor", 5.0f, 5.0f, 5.0f);
+	//Arenas de 64 MB de vértices e 32 MB de índices; sem o pool cada geometria tem seus buffers
+	if (options.geometryPool) {
+		geometryPool.initialize(64 << 20, 32 << 20);
+	}
 
-	int nVerts;
+	InstanceRenderer instances;
+	instances.initialize(uploads);
 
-	vector <string> modelNames = readModels();
-	GLuint VAO;
-	for (int i = 0; i < modelNames.size(); i++) {
-		VAO = loadOBJ("../" + modelNames[i], nVerts, glm::vec3(0.46, 0.38, 0.16));
-		if (VAO != -1) {
-			Mesh mesh;
-			mesh.initialize(VAO, nVerts, &shader, glm::vec3(3.0 * i, 0, 0.0), glm::vec3(0.46, 0.38, 0.16));
-			models.push_back(mesh);
-		}
+	IndirectRenderer indirect;
+	if (options.indirect) {
+		indirect.initialize(uploads);
+	}
+	MeshletStats meshletStats;
+
+	//Descarta os objetos fora do campo de visão antes de desenhar
+	FrustumCuller culler;
+
+	//Na janela interativa os modelos são lidos em segundo plano e aparecem conforme ficam
+	//prontos; os modos headless e benchmark precisam da cena inteira desde o primeiro quadro
+	AsyncLoader loader(options.loadThreads, options.loadQueue);
+	chrono::steady_clock::time_point loadStart = chrono::steady_clock::now();
+	bool asyncLoading = options.asyncLoading && !options.headless && !options.benchmark;
+	if (asyncLoading) {
+		startLoading(loader);
+	}
+	else {
+		loadModels(&shader);
 	}
 
 	glEnable(GL_DEPTH_TEST);
@@ -199,74 +379,429 @@ int main()
 	float light_y = -10;
 	float light_x = -10;
 
-	
+	//Mesh destacada como selecionada no momento
+	int highlighted = -1;
+
+	//Tempo médio por quadro, mostrado no título da janela a cada segundo
+	double titleTime = glfwGetTime();
+	int framesSinceTitle = 0;
+
+	//Quadros já desenhados (os modos headless e benchmark param em options.frames)
+	bool scripted = options.headless || options.benchmark;
+	int frameIndex = 0;
+	chrono::steady_clock::time_point renderStart = chrono::steady_clock::now();
+
+	//No benchmark o quadro não espera pelo vsync e cada um tem seu tempo registrado
+	FrameRecorder recorder;
+	if (options.benchmark) {
+		glfwSwapInterval(0);
+		recorder.initialize(options.frames);
+	}
 
 	// Loop da aplicação - "game loop"
-	while (!glfwWindowShouldClose(window))
+	while (scripted ? frameIndex < options.frames : !glfwWindowShouldClose(window))
 	{
+		if (options.benchmark) {
+			recorder.beginFrame();
+		}
+		PROFILE_ZONE("frame");
+		ring.beginFrame();
+
 		// Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
 		glfwPollEvents();
 
+		//Geometrias prontas vão para a GPU dentro do tempo reservado por quadro
+		if (!loader.finished()) {
+			loader.upload(options.uploadBudgetMs, [&shader](PreparedGeometry& prepared, shared_ptr<Geometry> geometry) {
+				addLoadedModels(prepared, geometry, &shader);
+			}, uploads, &geometryPool);
+			if (loader.finished()) {
+				reportLoad(loadStart);
+			}
+		}
+
+		//Sem interação a câmera segue o caminho da cena, do primeiro ao último quadro.
+		//A luz avança um passo fixo por quadro, então também se repete a cada execução
+		if (scripted) {
+			options.scene.sampleCamera(options.frames > 1 ? frameIndex / float(options.frames - 1) : 0.0f, cameraPos, cameraFront);
+		}
+
 		// Limpa o buffer de cor
 		glClearColor(1.0f, 1.0f, 1.0f, 1.0f); //cor de fundo
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		{
+			PROFILE_ZONE("clear");
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		}
 
 		glLineWidth(5);
 		glPointSize(0);
 
 
-		//giro da luz
-		if (light_x > 10) {
-			speed *= -1;
+		stepLight(light_x, light_y);
+
+		float angle = (GLfloat)glfwGetTime() * 2;
+
+		glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+
+		glm::mat4 projection = glm::perspective(glm::radians(fov), (GLfloat)width / (GLfloat)height, 0.1f, 100.0f);
+
+		//Um único envio por quadro, compartilhado pelos dois programas
+		frame.view = view;
+		frame.projection = projection;
+		frame.lightPos = glm::vec4(light_x, light_y, 0.0f, 1.0f);
+		frame.cameraPos = glm::vec4(cameraPos, 1.0f);
+		{
+			PROFILE_ZONE("frame uniforms");
+			frameUniforms.update(frame);
 		}
-		else if (light_x < -10) {
-			speed *= -1;
+
+		{
+			PROFILE_ZONE("scene tree");
+			sceneTree.update(models);
+		}
+		{
+			PROFILE_ZONE("culling");
+			if (options.frustumCulling && options.bvhCulling) {
+				culler.resize(models.size());
+				culler.cull(projection * view, sceneTree.tree());
+			}
+			else if (options.frustumCulling) {
+				culler.update(models);
+				culler.cull(projection * view);
+			}
 		}
 
-		light_x += speed;
-		light_y = sqrt(-(light_x * light_x) + 100);
+		//Nível de detalhe pelo erro projetado na tela; as Mesh descartadas mantêm o nível
+		//anterior, para não serem reenviadas à toa
+		if (options.lod) {
+			PROFILE_ZONE("lod selection");
+			float pixelsPerUnit = height / (2.0f * tan(glm::radians(fov) / 2.0f));
+			for (size_t i = 0; i < models.size(); i++) {
+				if (options.frustumCulling && !culler.isVisible(i)) {
+					continue;
+				}
+				models[i].chooseLod(cameraPos, pixelsPerUnit, options.lodPixels);
+			}
+		}
 
-		if (speed < 0) {
-			light_y *= -1;
+		//Só as Mesh cuja seleção mudou trocam de cor
+		if (highlighted != selected) {
+			if (highlighted >= 0 && highlighted < (int)models.size()) {
+				models[highlighted].setColor(models[highlighted].getDefaultColor());
+			}
+			if (selected >= 0 && selected < (int)models.size()) {
+				models[selected].setColor(glm::vec3(0.1, 0.1, 0.3));
+			}
+			highlighted = selected;
 		}
 
-		shader.setVec3("lightPos", light_x, light_y, 0);
+		// Chamada de desenho - drawcall
+		int drawCalls = 0;
+		unsigned long long triangles = 0;
+		if (options.indirect) {
+			//Um glMultiDrawElementsIndirect por arena; só as Mesh modificadas são reenviadas
+			{
+				PROFILE_ZONE("indirect sync");
+				indirect.sync(models);
+			}
+			PROFILE_ZONE("indirect draw");
+			if (options.meshlets) {
+				indirect.drawMeshlets(models, indirectShader.get(), frame, options.frustumCulling ? &culler : nullptr);
+				meshletStats.add(indirect.meshletStats());
+			}
+			else {
+				indirect.draw(indirectShader.get(), options.frustumCulling ? &culler : nullptr);
+			}
+			drawCalls = indirect.drawCalls();
+			triangles = indirect.triangles();
+		}
+		else if (options.instanced) {
+			//Um glDrawElementsInstanced por geometria; só as instâncias modificadas são reenviadas
+			{
+				PROFILE_ZONE("instances sync");
+				instances.sync(models);
+			}
+			PROFILE_ZONE("instances draw");
+			instances.draw(&instancedShader, options.frustumCulling ? &culler : nullptr);
+			drawCalls = instances.drawCalls();
+			triangles = instances.triangles();
+		}
+		else {
+			PROFILE_ZONE("draw");
+			shader.use();
+			//As Mesh do pool dividem o VAO da arena, vinculado uma vez só
+			GLuint boundVAO = 0;
+			for (int i = 0; i < models.size(); i++) {
+				if (options.frustumCulling && !culler.isVisible(i)) {
+					continue;
+				}
+				models[i].update();
+				models[i].draw(boundVAO);
+				drawCalls++;
+				triangles += models[i].geometry->lodIndexCount(models[i].getLod()) / 3;
+			}
+			glBindVertexArray(0);
+		}
+		
+		frameIndex++;
+		if (options.headless) {
+			if (!options.outputPrefix.empty()) {
+				PROFILE_ZONE("write frame");
+				char number[16];
+				snprintf(number, sizeof(number), "%04d", frameIndex - 1);
+				string filepath = options.outputPrefix + number + ".ppm";
+				if (!offscreen.writePPM(filepath))
+					cout << "Nao foi possivel gravar " << filepath << endl;
+			}
+		}
+		else {
+			// Troca os buffers da tela
+			{
+				PROFILE_ZONE("swap");
+				glfwSwapBuffers(window);
+			}
 
+			framesSinceTitle++;
+			if (glfwGetTime() - titleTime >= 1.0) {
+				double msPerFrame = (glfwGetTime() - titleTime) * 1000.0 / framesSinceTitle;
+				string title = "Visualizador 3D - " + to_string(msPerFrame) + " ms/quadro, " + to_string(models.size()) + " modelos";
+				if (options.frustumCulling) {
+					title += " (" + to_string(culler.drawnCount()) + " desenhados, " + to_string(culler.culledCount()) + " descartados)";
+				}
+				glfwSetWindowTitle(window, title.c_str());
+				titleTime = glfwGetTime();
+				framesSinceTitle = 0;
+			}
+		}
 
-		float angle = (GLfloat)glfwGetTime() * 2;
+		if (options.benchmark) {
+			recorder.endFrame(drawCalls, triangles, ring.frameStats());
+		}
+	}
+	if (scripted) {
+		glFinish();
+		double renderMs = chrono::duration<double, milli>(chrono::steady_clock::now() - renderStart).count();
+		cout << frameIndex << " quadros de " << width << "x" << height << " em " << renderMs << " ms" << endl;
+	}
+	if (options.meshlets && options.indirect) {
+		reportMeshlets(meshletStats);
+	}
+	if (ring.isInitialized()) {
+		ring.beginFrame();
+		const UploadStats& sent = ring.totalStats();
+		cout << "Anel de envio: " << sent.bytes / 1024.0 << " KB enviados, " << sent.stalls << " esperas pela GPU (" << sent.stallMs << " ms), "
+			<< sent.rejected / 1024.0 << " KB fora do anel" << endl;
+	}
+	if (options.benchmark) {
+		recorder.finish();
+		vector<pair<string, string> > info = {
+			{ "renderer", "\"" + string((const char*)renderer) + "\"" },
+			{ "width", to_string(width) },
+			{ "height", to_string(height) },
+			{ "models", to_string(models.size()) },
+			{ "instanced", options.instanced ? "true" : "false" },
+			{ "indirect", options.indirect ? "true" : "false" },
+			{ "lod", options.lod ? "true" : "false" },
+			{ "meshlets", options.meshlets && options.indirect ? "true" : "false" },
+			{ "culling", !options.frustumCulling ? "\"none\"" : options.bvhCulling ? "\"bvh\"" : "\"flat\"" },
+			{ "headless", options.headless ? "true" : "false" }
+		};
+		if (!recorder.writeJSON(options.benchmarkJson, options.warmupFrames, info))
+			cout << "Nao foi possivel gravar " << options.benchmarkJson << endl;
+	}
 
-		glUniformMatrix4fv(modelLoc, 1, FALSE, glm::value_ptr(model));
+	if (!options.profilePath.empty()) {
+		if (Profiler::writeChromeTrace(options.profilePath))
+			cout << "Trace gravado em " << options.profilePath << endl;
+		else
+			cout << "Nao foi possivel gravar " << options.profilePath << endl;
+	}
 
-		glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-		glUniformMatrix4fv(viewLoc, 1, FALSE, glm::value_ptr(view));
+	// Pede pra OpenGL desalocar os buffers (a última Mesh de cada geometria libera o VAO/VBO/EBO)
+	loader.stop();
+	models.clear();
+	geometryPool.shutdown();
+	return 0;
+}
 
+vector <string> sceneModels()
+{
+	//Cena de teste com muitas cópias do mesmo modelo, os modelos da cena passada na linha
+	//de comando, ou os escolhidos pelo usuário
+	vector <string> modelNames;
+	if (options.instanceCount > 0)
+		modelNames.assign(options.instanceCount, options.instanceModel);
+	else if (!options.scene.models.empty() || options.headless || options.software)
+		modelNames = options.scene.models;
+	else
+		modelNames = readModels();
 
-		glm::mat4 projection = glm::perspective(glm::radians(fov), (GLfloat)width / (GLfloat)height, 0.1f, 100.0f);
-		glUniformMatrix4fv(projLoc, 1, FALSE, glm::value_ptr(projection));
+	//A câmera começa na primeira chave do caminho, se houver
+	options.scene.sampleCamera(0.0f, cameraPos, cameraFront);
+	return modelNames;
+}
 
-		
+glm::vec3 modelPosition(int i, int count)
+{
+	int gridSide = (int)ceil(sqrt((double)count));
+	return options.instanceCount > 0 ? glm::vec3(3.0 * (i % gridSide), 0, -3.0 * (i / gridSide)) : glm::vec3(6.0 * i, 0, 0.0);
+}
 
-		// Chamada de desenho - drawcall
-		for (int i = 0; i < models.size(); i++) {
-			if (i == selected) {
-				models[i].color = glm::vec3(0.1, 0.1, 0.3);
-			}
-			else {
-				models[i].color = models[i].defaultColor;
-			}
-			models[i].update();
-			models[i].draw();
-			i++;
+void reportLoad(chrono::steady_clock::time_point loadStart)
+{
+	double loadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - loadStart).count();
+	cout << models.size() << " modelos (" << geometries.loadCount() << " arquivos lidos) carregados em " << loadMs
+		<< " ms (" << (!options.useMeshCache ? string("cache desligado") : to_string(cachedFiles) + " de " + to_string(preparedFiles) + " vindos do cache") << ")" << endl;
+	if (geometryPool.isInitialized()) {
+		GeometryPool::Stats pool = geometryPool.stats();
+		cout << "Pool de geometria: " << pool.geometries << " geometrias em " << pool.arenas << " arena(s), " << pool.usedBytes / 1024 << " de "
+			<< pool.capacityBytes / 1024 << " KB usados, " << pool.freeFragments << " trechos livres" << endl;
+	}
+}
+
+void reportMeshlets(const MeshletStats& stats)
+{
+	cout << "Meshlets: " << 100.0f * stats.rejectionRate() << "% dos " << stats.triangles << " triangulos testados descartados ("
+		<< stats.outsideTriangles << " fora do frustum, " << stats.backfacingTriangles << " de costas; "
+		<< stats.outsideMeshlets + stats.backfacingMeshlets << " de " << stats.meshlets << " meshlets)" << endl;
+}
+
+void loadModels(Shader* shader)
+{
+	vector <string> modelNames = sceneModels();
+
+	chrono::steady_clock::time_point loadStart = chrono::steady_clock::now();
+	for (int i = 0; i < modelNames.size(); i++) {
+		PROFILE_ZONE("load model");
+		//Arquivos repetidos compartilham a mesma geometria (um parse e um envio para a GPU)
+		shared_ptr<Geometry> geometry = geometries.acquire("../" + modelNames[i], modelColor, loadOBJ);
+		if (geometry) {
+			Mesh mesh;
+			mesh.initialize(geometry, shader, modelPosition(i, (int)modelNames.size()), modelColor);
+			models.push_back(mesh);
 		}
-		
-		// Troca os buffers da tela
-		glfwSwapBuffers(window);
 	}
-	// Pede pra OpenGL desalocar os buffers
-	glDeleteVertexArrays(1, &VAO);
-	
-	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
-	glfwTerminate();
+	reportLoad(loadStart);
+}
+
+void startLoading(AsyncLoader& loader)
+{
+	vector <string> modelNames = sceneModels();
+
+	//Um pedido por arquivo; as cópias do mesmo arquivo vão nas posições do pedido
+	vector <unique_ptr<PreparedGeometry> > requests;
+	map <string, PreparedGeometry*> byPath;
+	for (size_t i = 0; i < modelNames.size(); i++) {
+		string filepath = "../" + modelNames[i];
+		PreparedGeometry*& request = byPath[GeometryRegistry::canonicalPath(filepath)];
+		if (request == nullptr) {
+			requests.push_back(unique_ptr<PreparedGeometry>(new PreparedGeometry()));
+			request = requests.back().get();
+			request->filepath = filepath;
+			request->color = modelColor;
+		}
+		request->positions.push_back(modelPosition((int)i, (int)modelNames.size()));
+	}
+
+	//Uma thread fica livre para o laço de desenho; as outras são divididas entre as
+	//threads da carga, que leem arquivos diferentes ao mesmo tempo
+	int parseThreads = options.loaderThreads > 0 ? options.loaderThreads : max(1, (ThreadPool::hardwareThreads() - 1) / max(1, options.loadThreads));
+	loader.start(move(requests), [parseThreads](PreparedGeometry& prepared) {
+		return prepareOBJ(prepared, parseThreads);
+	});
+}
+
+void addLoadedModels(PreparedGeometry& prepared, shared_ptr<Geometry> geometry, Shader* shader)
+{
+	//Registrada como se tivesse sido lida por acquire, para que cargas futuras do mesmo arquivo a reaproveitem
+	geometries.acquire(prepared.filepath, prepared.color, [&geometry](const string&, glm::vec3) { return geometry; });
+	for (const glm::vec3& position : prepared.positions) {
+		Mesh mesh;
+		mesh.initialize(geometry, shader, position, prepared.color);
+		models.push_back(mesh);
+	}
+}
+
+void stepLight(float& light_x, float& light_y)
+{
+	//giro da luz
+	if (light_x > 10) {
+		speed *= -1;
+	}
+	else if (light_x < -10) {
+		speed *= -1;
+	}
+
+	light_x += speed;
+	light_y = sqrt(-(light_x * light_x) + 100);
+
+	if (speed < 0) {
+		light_y *= -1;
+	}
+}
+
+int renderSoftware()
+{
+	loadModels(nullptr);
+
+	//Mesmo destaque da seleção que o desenho com OpenGL
+	if (selected >= 0 && selected < (int)models.size()) {
+		models[selected].setColor(glm::vec3(0.1, 0.1, 0.3));
+	}
+
+	SoftwareRenderer renderer(options.loaderThreads);
+	renderer.resize(options.width, options.height);
+	renderer.setMeshletCulling(options.meshlets);
+	MeshletStats meshletStats;
+	PhongMaterial material;
+	FrustumCuller culler;
+	FrameData frame;
+	frame.lightColor = glm::vec4(5.0f, 5.0f, 5.0f, 1.0f);
+	float light_y = -10;
+	float light_x = -10;
+
+	double renderMs = 0.0, worstMs = 0.0;
+	size_t triangles = 0;
+	for (int frameIndex = 0; frameIndex < options.frames; frameIndex++) {
+		options.scene.sampleCamera(options.frames > 1 ? frameIndex / float(options.frames - 1) : 0.0f, cameraPos, cameraFront);
+		stepLight(light_x, light_y);
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		frame.view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+		frame.projection = glm::perspective(glm::radians(fov), (GLfloat)options.width / (GLfloat)options.height, 0.1f, 100.0f);
+		frame.lightPos = glm::vec4(light_x, light_y, 0.0f, 1.0f);
+		frame.cameraPos = glm::vec4(cameraPos, 1.0f);
+		if (options.frustumCulling) {
+			culler.update(models);
+			culler.cull(frame.projection * frame.view);
+		}
+		renderer.render(models, frame, material, glm::vec3(1.0f, 1.0f, 1.0f), options.frustumCulling ? &culler : nullptr);
+		double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+		renderMs += ms;
+		worstMs = max(worstMs, ms);
+		triangles = renderer.triangleCount();
+		meshletStats.add(renderer.meshletStats());
+
+		if (!options.outputPrefix.empty()) {
+			PROFILE_ZONE("write frame");
+			char number[16];
+			snprintf(number, sizeof(number), "%04d", frameIndex);
+			string filepath = options.outputPrefix + number + ".ppm";
+			if (!renderer.writePPM(filepath))
+				cout << "Nao foi possivel gravar " << filepath << endl;
+		}
+	}
+	cout << options.frames << " quadros de " << options.width << "x" << options.height << " na CPU: "
+		<< renderMs / max(options.frames, 1) << " ms por quadro em media, " << worstMs << " ms no pior caso ("
+		<< triangles << " triangulos no ultimo)" << endl;
+	if (options.meshlets) {
+		reportMeshlets(meshletStats);
+	}
+
+	if (!options.profilePath.empty() && Profiler::writeChromeTrace(options.profilePath))
+		cout << "Trace gravado em " << options.profilePath << endl;
+
+	models.clear();
 	return 0;
 }
 
@@ -298,20 +833,38 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * float(0.1);
 	}
 
+	//M alterna entre olhar com o mouse e usar o cursor para selecionar com o clique
+	if (key == GLFW_KEY_M && action == GLFW_PRESS)
+	{
+		bool captured = glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED;
+		glfwSetInputMode(window, GLFW_CURSOR, captured ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
+		firstMouse = true;
+	}
+	//T grava o trace do profiler até aqui (com --profile)
+	if (key == GLFW_KEY_T && action == GLFW_PRESS && !options.profilePath.empty())
+	{
+		if (Profiler::writeChromeTrace(options.profilePath))
+			cout << "Trace gravado em " << options.profilePath << endl;
+	}
+
+
+	//Enquanto a carga em segundo plano não entregou nenhum modelo não há o que selecionar
+	if (models.empty())
+		return;
 
 	//Ecolha de desenho
 	if (key == GLFW_KEY_Q && action == GLFW_PRESS)
 	{
-		selected -= 2;
+		selected -= 1;
 		if (selected < 0) {
-			selected = models.size();
+			selected = models.size() - 1;
 		}
 		cout << "Modelo selecionado : " << selected << "\n";
 	}
 
 	if (key == GLFW_KEY_E && action == GLFW_PRESS)
 	{
-		selected += 2;
+		selected += 1;
 		if (selected > (models.size() - 1)) {
 			selected = 0;
 		}
@@ -321,46 +874,42 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 	//translate
 	if (key == GLFW_KEY_UP)
 	{
-		models[selected].position.z -= 0.1;
+		models[selected].translate(glm::vec3(0.0, 0.0, -0.1));
 	}
 
 	if (key == GLFW_KEY_DOWN)
 	{
-		models[selected].position.z += 0.1;
+		models[selected].translate(glm::vec3(0.0, 0.0, 0.1));
 	}
 
 	if (key == GLFW_KEY_LEFT)
 	{
-		models[selected].position.x -= 0.1;
+		models[selected].translate(glm::vec3(-0.1, 0.0, 0.0));
 	}
 
 	if (key == GLFW_KEY_RIGHT)
 	{
-		models[selected].position.x += 0.1;
+		models[selected].translate(glm::vec3(0.1, 0.0, 0.0));
 	}
 
 	if (key == GLFW_KEY_RIGHT_SHIFT)
 	{
-		models[selected].position.y += 0.1;
+		models[selected].translate(glm::vec3(0.0, 0.1, 0.0));
 	}
 
 	if (key == GLFW_KEY_RIGHT_CONTROL)
 	{
-		models[selected].position.y -= 0.1;
+		models[selected].translate(glm::vec3(0.0, -0.1, 0.0));
 	}
 
 	//scale
 	if (key == GLFW_KEY_O)
 	{
-		models[selected].scale.x -= 0.1;
-		models[selected].scale.y -= 0.1;
-		models[selected].scale.z -= 0.1;
+		models[selected].setScale(models[selected].getScale() - glm::vec3(0.1));
 	}
 	if (key == GLFW_KEY_P)
 	{
-		models[selected].scale.x += 0.1;
-		models[selected].scale.y += 0.1;
-		models[selected].scale.z += 0.1;
+		models[selected].setScale(models[selected].getScale() + glm::vec3(0.1));
 	}
 
 	//rotation
@@ -397,14 +946,12 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 
 	if (key == GLFW_KEY_K)
 	{
-		models[selected].axis = glm::vec3(axisX, axisY, axisZ);
-		models[selected].angle += 0.5;
+		models[selected].rotate(0.5, glm::vec3(axisX, axisY, axisZ));
 	}
 	if (key == GLFW_KEY_L)
 	{
 
-		models[selected].axis = glm::vec3(axisX, axisY, axisZ);
-		models[selected].angle -= 0.5;
+		models[selected].rotate(-0.5, glm::vec3(axisX, axisY, axisZ));
 	}
 	if (key == GLFW_KEY_C && action == GLFW_PRESS)
 	{
@@ -421,13 +968,16 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		cout << "Valor b (0 - 1.0): ";
 		cin >> b;
 
-		models[selected].defaultColor = glm::vec3(r, g, b);
+		models[selected].setDefaultColor(glm::vec3(r, g, b));
 	}
-
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 {
+	//Com o cursor livre (tecla M) o mouse serve para selecionar, não para olhar
+	if (glfwGetInputMode(window, GLFW_CURSOR) != GLFW_CURSOR_DISABLED)
+		return;
+
 	float sensitivity = 0.05;
 
 	if (firstMouse)
@@ -460,169 +1010,196 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 	fov -= yoffset;
 }
 
-
-// Esta função está bastante harcoded - objetivo é criar os buffers que armazenam a 
-// geometria de um triângulo
-// Apenas atributo coordenada nos vértices
-// 1 VBO com as coordenadas, VAO com apenas 1 ponteiro para atributo
-// A função retorna o identificador do VAO
-
-int loadOBJ(string filepath, int& nVerts, glm::vec3 color)
+void mouse_button_callback(GLFWwindow* window, int button, int action, int)
 {
-	vector <Vertex> vertices;
-	vector <GLuint> indices;
-	vector <glm::vec2> texCoords;
-	vector <glm::vec3> normals;
-	vector <GLfloat> vbuffer;
+	if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS)
+		return;
 
-	ifstream inputFile;
-	inputFile.open(filepath.c_str());
-	if (inputFile.is_open())
+	//Com o cursor preso à câmera a seleção é pelo centro da tela
+	double x, y;
+	if (glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED)
 	{
-		char line[100];
-		string sline;
-
-
-
-		while (!inputFile.eof())
-		{
-			inputFile.getline(line, 100);
-			sline = line;
-
-			string word;
-
-			istringstream ssline(line);
-			ssline >> word;
-
-			//cout << word << " ";
-			if (word == "v")
-			{
-				Vertex v;
-
-				ssline >> v.position.x >> v.position.y >> v.position.z;
-				v.color.r = color.r;  v.color.g = color.g;  v.color.b = color.b;
-
-				vertices.push_back(v);
-			}
-			if (word == "vt")
-			{
-				glm::vec2 vt;
-
-				ssline >> vt.s >> vt.t;
+		int width, height;
+		glfwGetWindowSize(window, &width, &height);
+		x = width * 0.5;
+		y = height * 0.5;
+	}
+	else
+		glfwGetCursorPos(window, &x, &y);
 
-				texCoords.push_back(vt);
-			}
-			if (word == "vn")
-			{
-				glm::vec3 vn;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	uint32_t triangle = 0;
+	int picked = pickModel(window, x, y, triangle);
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	if (picked >= 0)
+	{
+		selected = picked;
+		cout << "Modelo selecionado : " << selected << " (triangulo " << triangle << ", " << ms << " ms)\n";
+	}
+}
 
-				ssline >> vn.x >> vn.y >> vn.z;
+// Raio do olho passando pelo ponto (x, y) da janela: a BVH da cena dá os modelos
+// cuja caixa ele atravessa e a BVH de triângulos de cada um dá o ponto exato.
+// Retorna o índice do modelo mais próximo atingido, ou -1
+int pickModel(GLFWwindow* window, double x, double y, uint32_t& triangle)
+{
+	int width, height;
+	glfwGetWindowSize(window, &width, &height);
+	glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+	glm::mat4 projection = glm::perspective(glm::radians(fov), (GLfloat)width / (GLfloat)height, 0.1f, 100.0f);
+	glm::vec4 viewport(0.0f, 0.0f, (float)width, (float)height);
+	glm::vec3 nearPoint = glm::unProject(glm::vec3(x, height - y, 0.0), view, projection, viewport);
+	glm::vec3 farPoint = glm::unProject(glm::vec3(x, height - y, 1.0), view, projection, viewport);
+	glm::vec3 direction = farPoint - nearPoint;
+
+	//t vai de 0 (plano near) a 1 (plano far); a direção não é normalizada, então o
+	//mesmo t vale no espaço do modelo depois de aplicar a inversa da matriz
+	sceneTree.update(models);
+	int picked = -1;
+	float closest = 1.0f;
+	sceneTree.tree().queryRay(nearPoint, direction, closest, [&](int i, float) {
+		glm::mat4 inverse = glm::inverse(models[i].modelMatrix());
+		glm::vec3 origin = glm::vec3(inverse * glm::vec4(nearPoint, 1.0f));
+		glm::vec3 localDirection = glm::vec3(inverse * glm::vec4(direction, 0.0f));
+		if (models[i].geometry->triangles.raycast(origin, localDirection, closest, triangle))
+			picked = i;
+		return closest;
+	});
+	return picked;
+}
 
-				normals.push_back(vn);
-			}
-			if (word == "f")
-			{
-				string tokens[3];
-
-				ssline >> tokens[0] >> tokens[1] >> tokens[2];
-
-				for (int i = 0; i < 3; i++)
-				{
-					//Recuperando os indices de v
-					int pos = tokens[i].find("/");
-					string token = tokens[i].substr(0, pos);
-					int index = atoi(token.c_str()) - 1;
-					indices.push_back(index);
-
-					vbuffer.push_back(vertices[index].position.x);
-					vbuffer.push_back(vertices[index].position.y);
-					vbuffer.push_back(vertices[index].position.z);
-					vbuffer.push_back(vertices[index].color.r);
-					vbuffer.push_back(vertices[index].color.g);
-					vbuffer.push_back(vertices[index].color.b);
-
-					//Recuperando os indices de vts
-					tokens[i] = tokens[i].substr(pos + 1);
-					pos = tokens[i].find("/");
-					token = tokens[i].substr(0, pos);
-					index = atoi(token.c_str()) - 1;
-
-					vbuffer.push_back(texCoords[index].s);
-					vbuffer.push_back(texCoords[index].t);
-
-					//Recuperando os indices de vns
-					tokens[i] = tokens[i].substr(pos + 1);
-					index = atoi(tokens[i].c_str()) - 1;
-
-					vbuffer.push_back(normals[index].x);
-					vbuffer.push_back(normals[index].y);
-					vbuffer.push_back(normals[index].z);
-				}
-			}
 
-		}
+// Esta função está bastante harcoded - objetivo é criar os buffers que armazenam a 
+// geometria de um triângulo
+// Apenas atributo coordenada nos vértices
+// 1 VBO com as coordenadas, VAO com apenas 1 ponteiro para atributo
+// A função retorna a geometria (VAO, VBO e EBO), compartilhável entre várias Mesh
 
+bool prepareOBJ(PreparedGeometry& prepared, int nThreads)
+{
+	PROFILE_ZONE("prepareOBJ");
+	const string& filepath = prepared.filepath;
+	MeshBuffers& buffers = prepared.buffers;
+	preparedFiles++;
+
+	//O renderizador por software lê os vértices em floats
+	bool packedVertices = options.packedVertices && !options.software;
+
+	//Com um cache válido a geometria vem pronta do arquivo mapeado, sem nenhum parse.
+	//Um cache gravado sem os níveis de detalhe, a otimização ou os meshlets não serve
+	//quando eles estão ligados, nem um gravado no outro formato de vértice
+	if (options.useMeshCache && !options.rebuildMeshCache && prepared.cache.open(filepath, prepared.color)
+		&& (!options.lod || !prepared.cache.buffers().lods.empty())
+		&& (!options.optimizeMesh || prepared.cache.buffers().optimized)
+		&& (!options.meshlets || !prepared.cache.buffers().meshlets.empty())
+		&& prepared.cache.buffers().packed == packedVertices)
+	{
+		buffers = prepared.cache.buffers();
+		cachedFiles++;
 	}
 	else
 	{
-		cout << "Problema ao encontrar o arquivo " << filepath << endl;
+		//Leitura do arquivo mapeado em memória, em paralelo, com vértices deduplicados (ver ObjLoader.cpp)
+		if (!parseOBJIndexed(filepath, prepared.color, prepared.mesh, nThreads))
+			return false;
+		//Os níveis simplificados vão para o fim dos índices, no mesmo buffer
+		vector<MeshLod> lods;
+		if (options.lod)
+			generateLods(prepared.mesh, lods, nThreads);
+		if (options.optimizeMesh)
+		{
+			VertexCacheStats before, after;
+			optimizeMesh(prepared.mesh, lods, &before, &after);
+			cout << filepath << ": ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << endl;
+		}
+		//Os meshlets reagrupam os triângulos do nível 0, partindo da ordem já otimizada
+		vector<Meshlet> meshlets;
+		if (options.meshlets)
+		{
+			buildMeshlets(prepared.mesh, 0, lods.empty() ? prepared.mesh.indices.size() : lods[0].indexCount, meshlets);
+			cout << filepath << ": " << meshlets.size() << " meshlets" << endl;
+		}
+		PROFILE_ZONE("mesh buffers and cache write");
+		if (packedVertices)
+			buildPackedMeshBuffers(prepared.mesh, prepared.shortIndices, prepared.packedVertices, buffers);
+		else
+			buildMeshBuffers(prepared.mesh, prepared.shortIndices, buffers);
+		buffers.lods = lods;
+		buffers.optimized = options.optimizeMesh;
+		buffers.meshlets = meshlets;
+
+		//Sem índices a malha teria um vértice por índice do nível 0; os outros níveis não contam
+		size_t baseIndexCount = lods.empty() ? buffers.indexCount : lods[0].indexCount;
+		cout << filepath << ": " << baseIndexCount << " -> " << buffers.vertexCount << " vertices, "
+			<< baseIndexCount * OBJ_FLOATS_PER_VERTEX * sizeof(GLfloat) / 1024 << " KB -> " << (buffers.vertexBytes + buffers.indexBytes) / 1024 << " KB" << endl;
+		if (buffers.packed)
+			cout << filepath << ": vertices compactados " << buffers.vertexCount * OBJ_FLOATS_PER_VERTEX * sizeof(GLfloat) / 1024
+				<< " KB -> " << buffers.vertexBytes / 1024 << " KB" << endl;
+
+		if (options.useMeshCache && !MeshCache::write(filepath, prepared.color, buffers))
+			cout << "Nao foi possivel gravar " << MeshCache::cachePath(filepath) << endl;
 	}
-	inputFile.close();
-
-	GLuint VBO, VAO;
-
-	nVerts = vbuffer.size() / 11; //Provisório
-
-	//Geração do identificador do VBO
-	glGenBuffers(1, &VBO);
-
-	//Faz a conexão (vincula) do buffer como um buffer de array
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-	//Envia os dados do array de floats para o buffer da OpenGl
-	glBufferData(GL_ARRAY_BUFFER, vbuffer.size() * sizeof(GLfloat), vbuffer.data(), GL_STATIC_DRAW);
 
-	//Geração do identificador do VAO (Vertex Array Object)
-	glGenVertexArrays(1, &VAO);
-
-	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
-	// e os ponteiros para os atributos 
-	glBindVertexArray(VAO);
-
-	//Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando: 
-	// Localização no shader * (a localização dos atributos devem ser correspondentes no layout especificado no vertex shader)
-	// Numero de valores que o atributo tem (por ex, 3 coordenadas xyz) 
-	// Tipo do dado
-	// Se está normalizado (entre zero e um)
-	// Tamanho em bytes 
-	// Deslocamento a partir do byte zero 
-
-	//Atributo posição (x, y, z)
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-
-	//Atributo cor (r, g, b)
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
-
-	//Atributo coordenada de textura (s, t)
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-
-	//Atributo normal do vértice (x, y, z)
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-
-
-	// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice 
-	// atualmente vinculado - para que depois possamos desvincular com segurança
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	// Desvincula o VAO (é uma boa prática desvincular qualquer buffer ou array para evitar bugs medonhos)
-	glBindVertexArray(0);
+	PROFILE_ZONE("bounds and triangle BVH");
+	//Com vértices compactados, caixa e seleção usam as posições decodificadas, as mesmas
+	//que o shader desenha
+	const void* positions = buffers.vertices;
+	size_t positionStride = buffers.stride;
+	vector<glm::vec3> unpacked;
+	if (buffers.packed)
+	{
+		unpackPositions(buffers, unpacked);
+		positions = unpacked.data();
+		positionStride = sizeof(glm::vec3);
+	}
+	prepared.bounds = computeBounds(positions, buffers.vertexCount, positionStride);
+	//A seleção com o mouse usa sempre a malha completa (nível 0)
+	uint32_t baseIndexCount = buffers.lods.empty() ? buffers.indexCount : buffers.lods[0].indexCount;
+	prepared.triangles.build(positions, buffers.vertexCount, positionStride, buffers.indices, baseIndexCount, buffers.indexType == GL_UNSIGNED_SHORT, nThreads);
+
+	//As arenas do pool só guardam índices de 32 bits
+	if (geometryPool.isInitialized())
+		widenIndices(prepared);
+	return true;
+}
 
-	return VAO;
+shared_ptr<Geometry> loadOBJ(const string& filepath, glm::vec3 color)
+{
+	PROFILE_ZONE("loadOBJ");
+	PreparedGeometry prepared;
+	prepared.filepath = filepath;
+	prepared.color = color;
+	if (!prepareOBJ(prepared, options.loaderThreads))
+		return nullptr;
+	const MeshBuffers& buffers = prepared.buffers;
+
+	//O renderizador por software lê a geometria da memória; não há contexto OpenGL
+	if (options.software)
+	{
+		shared_ptr<Geometry> geometry = make_shared<Geometry>();
+		geometry->nVertices = buffers.vertexCount;
+		geometry->indexType = buffers.indexType;
+		geometry->bounds = prepared.bounds;
+		geometry->triangles = move(prepared.triangles);
+
+		//O SoftwareRenderer desenha só a malha completa: os níveis ficam de fora da cópia
+		uint32_t indexCount = buffers.lods.empty() ? buffers.indexCount : buffers.lods[0].indexCount;
+		geometry->nIndices = indexCount;
+		geometry->meshlets = buffers.meshlets;
+		const float* vertices = (const float*)buffers.vertices;
+		geometry->vertices.assign(vertices, vertices + buffers.vertexBytes / sizeof(float));
+		geometry->indices.resize(indexCount);
+		for (uint32_t i = 0; i < indexCount; i++)
+			geometry->indices[i] = buffers.indexType == GL_UNSIGNED_SHORT ? ((const uint16_t*)buffers.indices)[i] : ((const uint32_t*)buffers.indices)[i];
+		return geometry;
+	}
 
+	//Na carga síncrona os dados vão de uma vez só
+	PROFILE_ZONE("GPU upload");
+	shared_ptr<Geometry> geometry = createGeometry(prepared, &geometryPool);
+	size_t offset = 0;
+	uploadGeometry(prepared, *geometry, offset, SIZE_MAX);
+	return geometry;
 }
 
 
@@ -637,7 +1214,6 @@ vector <string> readModels() {
 		cout << "Qual eh o modelo #" << i << " ?";
 		cin >> modelName;
 		modelNames.push_back(modelName);
-		modelNames.push_back(modelName);
 	}
 	return modelNames;
 }
\ No newline at end of file
@@ -1,5 +1,5 @@
-﻿//C�digo fonte do Fragment Shader (em GLSL)
 #version 450
+//C�digo fonte do Fragment Shader (em GLSL)
 
 //Informa��es recebidas do vertex shader
 in vec3 finalColor;
@@ -13,12 +13,16 @@ uniform float ks;
 uniform float n;
 uniform float q;
 
-//Propriedades da fonte de luz
-uniform vec3 lightPos;
-uniform vec3 lightColor;
-
-//Posi��o da c�mera 
-uniform vec3 cameraPos;
+//Propriedades da fonte de luz e posição da câmera: dados constantes do quadro
+//(FrameUniforms.h), compartilhados por todos os programas
+layout (std140, binding = 0) uniform FrameData
+{
+	mat4 view;
+	mat4 projection;
+	vec4 lightPos;
+	vec4 lightColor;
+	vec4 cameraPos;
+};
 
 //Buffer de sa�da (color buffer)
 out vec4 color;
@@ -26,18 +30,18 @@ out vec4 color;
 void main()
 {
     // Ambient
-    vec3 ambient =  lightColor * ka;
+    vec3 ambient =  lightColor.rgb * ka;
     // Diffuse 
     vec3 N = normalize(scaledNormal);
-    vec3 L = normalize(lightPos - fragPos);
+    vec3 L = normalize(lightPos.xyz - fragPos);
     float diff = max(dot(N, L), 0.0);
-    vec3 diffuse = diff * lightColor * kd;
+    vec3 diffuse = diff * lightColor.rgb * kd;
     
     // Specular
     vec3 R = reflect(-L,N);
-    vec3 V = normalize(cameraPos - fragPos);
+    vec3 V = normalize(cameraPos.xyz - fragPos);
     float spec = pow(max(dot(R,V),0.0),q);
-    vec3 specular = spec * ks * lightColor;
+    vec3 specular = spec * ks * lightColor.rgb;
         
     vec3 result = (ambient + diffuse) * finalColor + specular;
 
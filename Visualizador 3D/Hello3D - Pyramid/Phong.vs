@@ -1,5 +1,5 @@
-﻿// C�digo fonte do Vertex Shader (em GLSL)
 #version 450
+// C�digo fonte do Vertex Shader (em GLSL)
 
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 color;
@@ -7,10 +7,31 @@ layout (location = 2) in vec2 texc;
 layout (location = 3) in vec3 normal;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 uniform vec3 inputColor;
 
+//Dados constantes do quadro (FrameUniforms.h), compartilhados por todos os programas
+layout (std140, binding = 0) uniform FrameData
+{
+	mat4 view;
+	mat4 projection;
+	vec4 lightPos;
+	vec4 lightColor;
+	vec4 cameraPos;
+};
+
+//Vértices no formato compactado: normais octaédricas
+uniform bool octahedralNormals;
+
+//Normal octaédrica do formato compactado (VertexPacking.h): só x e y chegam no atributo
+vec3 octDecode(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
 out vec3 finalColor;
 out vec3 scaledNormal;
 out vec3 fragPos;
@@ -21,7 +42,8 @@ void main()
 	gl_Position = projection * view * model * vec4(position, 1.0);
 	finalColor = inputColor;
 	//Vetor normal escalada
-	scaledNormal = normal; // mat3(transpose(inverse(model))) * normal;
+	vec3 vertexNormal = octahedralNormals ? octDecode(normal.xy) : normal;
+	scaledNormal = vertexNormal; // mat3(transpose(inverse(model))) * vertexNormal;
 	//Posi��o do v�rtice com a transforma��o do objeto 
 	fragPos = vec3(model * vec4(position, 1.0));
 }
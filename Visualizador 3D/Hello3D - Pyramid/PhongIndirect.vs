@@ -0,0 +1,71 @@
+#version 450
+#extension GL_ARB_shader_draw_parameters : require
+// Código fonte do Vertex Shader para o desenho com glMultiDrawElementsIndirect (em GLSL)
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 color;
+layout (location = 2) in vec2 texc;
+layout (location = 3) in vec3 normal;
+
+//Dados de cada desenho (IndirectRenderer.h), na mesma ordem dos comandos
+struct DrawData
+{
+	mat4 model;
+	vec4 color;
+};
+
+layout (std430, binding = 1) readonly buffer DrawBuffer
+{
+	DrawData draws[];
+};
+
+//Posição do primeiro comando desta chamada no buffer: gl_DrawIDARB recomeça em 0 a cada chamada
+uniform int drawOffset;
+
+//Com os meshlets (IndirectRenderer::drawMeshlets) vários comandos desenham a mesma Mesh:
+//drawIndices leva cada comando aos dados da sua Mesh
+layout (std430, binding = 2) readonly buffer DrawIndexBuffer
+{
+	uint drawIndices[];
+};
+uniform bool indexedDraws;
+
+//Dados constantes do quadro (FrameUniforms.h), compartilhados por todos os programas
+layout (std140, binding = 0) uniform FrameData
+{
+	mat4 view;
+	mat4 projection;
+	vec4 lightPos;
+	vec4 lightColor;
+	vec4 cameraPos;
+};
+
+//Vértices no formato compactado: normais octaédricas
+uniform bool octahedralNormals;
+
+//Normal octaédrica do formato compactado (VertexPacking.h): só x e y chegam no atributo
+vec3 octDecode(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+out vec3 finalColor;
+out vec3 scaledNormal;
+out vec3 fragPos;
+
+void main()
+{
+	int command = drawOffset + gl_DrawIDARB;
+	DrawData draw = draws[indexedDraws ? drawIndices[command] : command];
+	gl_Position = projection * view * draw.model * vec4(position, 1.0);
+	finalColor = draw.color.rgb;
+	//Vetor normal escalada
+	vec3 vertexNormal = octahedralNormals ? octDecode(normal.xy) : normal;
+	scaledNormal = vertexNormal; // mat3(transpose(inverse(draw.model))) * vertexNormal;
+	//Posição do vértice com a transformação do objeto
+	fragPos = vec3(draw.model * vec4(position, 1.0));
+}
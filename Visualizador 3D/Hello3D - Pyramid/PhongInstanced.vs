@@ -0,0 +1,49 @@
+#version 450
+// Código fonte do Vertex Shader para desenho instanciado (em GLSL)
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 color;
+layout (location = 2) in vec2 texc;
+layout (location = 3) in vec3 normal;
+
+//Atributos por instância (glVertexAttribDivisor = 1): ocupam as localizações 4 a 8
+layout (location = 4) in mat4 instanceModel;
+layout (location = 8) in vec3 instanceColor;
+
+//Dados constantes do quadro (FrameUniforms.h), compartilhados por todos os programas
+layout (std140, binding = 0) uniform FrameData
+{
+	mat4 view;
+	mat4 projection;
+	vec4 lightPos;
+	vec4 lightColor;
+	vec4 cameraPos;
+};
+
+//Vértices no formato compactado: normais octaédricas
+uniform bool octahedralNormals;
+
+//Normal octaédrica do formato compactado (VertexPacking.h): só x e y chegam no atributo
+vec3 octDecode(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+out vec3 finalColor;
+out vec3 scaledNormal;
+out vec3 fragPos;
+
+void main()
+{
+	gl_Position = projection * view * instanceModel * vec4(position, 1.0);
+	finalColor = instanceColor;
+	//Vetor normal escalada
+	vec3 vertexNormal = octahedralNormals ? octDecode(normal.xy) : normal;
+	scaledNormal = vertexNormal; // mat3(transpose(inverse(instanceModel))) * vertexNormal;
+	//Posição do vértice com a transformação do objeto
+	fragPos = vec3(instanceModel * vec4(position, 1.0));
+}
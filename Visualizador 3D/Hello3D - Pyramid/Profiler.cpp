@@ -0,0 +1,153 @@
+#include "Profiler.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+
+using namespace std;
+
+namespace
+{
+	struct Event
+	{
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+	};
+
+	// Anel de uma thread: só ela escreve; written é lido pela gravação do trace
+	struct ThreadRing
+	{
+		vector<Event> events;
+		atomic<uint64_t> written{ 0 };
+		int id = 0;
+		string name;
+		bool inUse = false;
+	};
+
+	const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+
+	//Os anéis nunca são liberados, para que o trace inclua threads que já terminaram.
+	//O anel de uma thread que terminou é reaproveitado pela próxima thread criada
+	//(as pools do loader são recriadas a cada arquivo), mantendo os eventos antigos
+	mutex registryMutex;
+	vector<unique_ptr<ThreadRing> > rings;
+
+	struct RingOwner
+	{
+		ThreadRing* ring = nullptr;
+		~RingOwner()
+		{
+			if (ring == nullptr)
+				return;
+			lock_guard<mutex> lock(registryMutex);
+			ring->inUse = false;
+		}
+	};
+	thread_local RingOwner owner;
+
+	ThreadRing& threadRing()
+	{
+		if (owner.ring == nullptr)
+		{
+			lock_guard<mutex> lock(registryMutex);
+			for (unique_ptr<ThreadRing>& ring : rings)
+				if (!ring->inUse)
+				{
+					owner.ring = ring.get();
+					break;
+				}
+			if (owner.ring == nullptr)
+			{
+				rings.push_back(unique_ptr<ThreadRing>(new ThreadRing()));
+				owner.ring = rings.back().get();
+				owner.ring->events.resize(Profiler::RING_EVENTS);
+				owner.ring->id = (int)rings.size();
+				owner.ring->name = "thread " + to_string(owner.ring->id);
+			}
+			owner.ring->inUse = true;
+		}
+		return *owner.ring;
+	}
+
+	void writeEscaped(FILE* f, const char* text)
+	{
+		for (; *text != '\0'; text++)
+		{
+			if (*text == '"' || *text == '\\')
+				fputc('\\', f);
+			fputc(*text, f);
+		}
+	}
+}
+
+namespace Profiler
+{
+	atomic<bool> enabled{ false };
+
+	void setEnabled(bool on)
+	{
+		enabled.store(on, memory_order_relaxed);
+	}
+
+	uint64_t now()
+	{
+		//+1 para que 0 continue significando "zona não medida"
+		return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count() + 1;
+	}
+
+	void record(const char* name, uint64_t start, uint64_t end)
+	{
+		ThreadRing& ring = threadRing();
+		uint64_t n = ring.written.load(memory_order_relaxed);
+		Event& event = ring.events[n % RING_EVENTS];
+		event.name = name;
+		event.start = start;
+		event.end = end;
+		ring.written.store(n + 1, memory_order_release);
+	}
+
+	void setThreadName(const char* name)
+	{
+		//Desligado não cria anel para a thread
+		if (!isEnabled())
+			return;
+		ThreadRing& ring = threadRing();
+		lock_guard<mutex> lock(registryMutex);
+		ring.name = name;
+	}
+
+	bool writeChromeTrace(const string& filepath)
+	{
+		FILE* f = fopen(filepath.c_str(), "w");
+		if (f == nullptr)
+			return false;
+
+		lock_guard<mutex> lock(registryMutex);
+		fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+		bool first = true;
+		for (const unique_ptr<ThreadRing>& ring : rings)
+		{
+			fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"", first ? "" : ",\n", ring->id);
+			writeEscaped(f, ring->name.c_str());
+			fprintf(f, "\"}}");
+			first = false;
+
+			uint64_t written = ring->written.load(memory_order_acquire);
+			uint64_t oldest = written > RING_EVENTS ? written - RING_EVENTS : 0;
+			for (uint64_t i = oldest; i < written; i++)
+			{
+				const Event& event = ring->events[i % RING_EVENTS];
+				fprintf(f, ",\n{\"name\":\"");
+				writeEscaped(f, event.name);
+				//Tempos do formato em microssegundos; 3 casas mantêm os nanossegundos
+				fprintf(f, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+					ring->id, event.start / 1000.0, (event.end - event.start) / 1000.0);
+			}
+		}
+		fprintf(f, "\n]}\n");
+		return fclose(f) == 0;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+// Profiler de zonas com escopo: PROFILE_ZONE("nome") mede do ponto da macro até
+// o fim do bloco. Cada thread grava os eventos no seu próprio anel (sem travas);
+// quando o anel enche os eventos mais antigos são sobrescritos.
+// Desligado (o padrão), uma zona custa a leitura de um bool; com PROFILER_DISABLED
+// definido no build as macros não geram código algum.
+// O resultado é um JSON no formato Chrome trace (chrome://tracing ou ui.perfetto.dev)
+namespace Profiler
+{
+	// Eventos guardados por thread antes de começar a sobrescrever
+	const size_t RING_EVENTS = 1 << 16;
+
+	extern std::atomic<bool> enabled;
+
+	inline bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+	void setEnabled(bool on);
+
+	// Nanossegundos desde o início do programa
+	uint64_t now();
+
+	// Registra uma zona já medida na thread atual. name precisa ser um literal
+	// (ou outra string que viva até a gravação do trace)
+	void record(const char* name, uint64_t start, uint64_t end);
+
+	// Nome da thread atual no trace
+	void setThreadName(const char* name);
+
+	// Grava todos os eventos ainda nos anéis. Eventos gravados por outras threads
+	// durante a escrita podem faltar ou aparecer pela metade
+	bool writeChromeTrace(const std::string& filepath);
+}
+
+// Mede o tempo de vida do objeto; usada pela macro PROFILE_ZONE
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const char* name) : name(name), start(Profiler::isEnabled() ? Profiler::now() : 0) {}
+	~ProfileZone()
+	{
+		if (start != 0)
+			Profiler::record(name, start, Profiler::now());
+	}
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	const char* name;
+	uint64_t start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef PROFILER_DISABLED
+#define PROFILE_ZONE(name) ((void)0)
+#else
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#endif
@@ -0,0 +1,87 @@
+#include "Scene.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+using namespace std;
+
+bool SceneDescription::load(const string& filepath)
+{
+	ifstream file(filepath);
+	if (!file.is_open())
+	{
+		cout << "Nao foi possivel abrir a cena " << filepath << endl;
+		return false;
+	}
+
+	string line;
+	int lineNumber = 0;
+	while (getline(file, line))
+	{
+		lineNumber++;
+		size_t comment = line.find('#');
+		if (comment != string::npos)
+			line.erase(comment);
+
+		istringstream ssline(line);
+		string word;
+		if (!(ssline >> word))
+			continue;
+
+		bool valid;
+		if (word == "model")
+		{
+			string name;
+			valid = (bool)(ssline >> name);
+			if (valid)
+				models.push_back(name);
+		}
+		else if (word == "camera")
+		{
+			CameraKey key;
+			valid = (bool)(ssline >> key.time >> key.position.x >> key.position.y >> key.position.z
+				>> key.target.x >> key.target.y >> key.target.z);
+			if (valid)
+				addCameraKey(key);
+		}
+		else
+			valid = false;
+
+		if (!valid)
+		{
+			cout << filepath << ":" << lineNumber << ": linha invalida: " << line << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+void SceneDescription::addCameraKey(const CameraKey& key)
+{
+	vector<CameraKey>::iterator position = upper_bound(camera.begin(), camera.end(), key,
+		[](const CameraKey& a, const CameraKey& b) { return a.time < b.time; });
+	camera.insert(position, key);
+}
+
+void SceneDescription::sampleCamera(float s, glm::vec3& position, glm::vec3& front) const
+{
+	if (camera.empty())
+		return;
+
+	float time = camera.front().time + glm::clamp(s, 0.0f, 1.0f) * (camera.back().time - camera.front().time);
+	size_t next = 1;
+	while (next < camera.size() && camera[next].time < time)
+		next++;
+
+	CameraKey a = camera[next - 1], b = camera[min(next, camera.size() - 1)];
+	float span = b.time - a.time;
+	float f = span > 0.0f ? (time - a.time) / span : 0.0f;
+	glm::vec3 target = glm::mix(a.target, b.target, f);
+	position = glm::mix(a.position, b.position, f);
+
+	//Câmera sobre o alvo: mantém a direção anterior
+	if (glm::length(target - position) > 0.0f)
+		front = glm::normalize(target - position);
+}
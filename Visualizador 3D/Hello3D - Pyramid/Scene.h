@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+// Posição da câmera e ponto para onde ela olha num instante do caminho
+struct CameraKey
+{
+	float time;
+	glm::vec3 position;
+	glm::vec3 target;
+};
+
+// Cena para execuções sem interação: a lista de modelos (nomes como os digitados
+// em readModels, relativos à pasta dos modelos) e um caminho de câmera.
+// Formato do arquivo, uma entrada por linha ('#' inicia um comentário):
+//   model <arquivo.obj>
+//   camera <tempo> <px> <py> <pz> <alvo x> <alvo y> <alvo z>
+class SceneDescription
+{
+public:
+	std::vector<std::string> models;
+	std::vector<CameraKey> camera;
+
+	// Acrescenta as entradas do arquivo; retorna false se ele não puder ser lido
+	// ou tiver uma linha inválida
+	bool load(const std::string& filepath);
+
+	// Acrescenta uma chave ao caminho mantendo-o ordenado pelo tempo
+	void addCameraKey(const CameraKey& key);
+
+	// Câmera no ponto s (0 = primeira chave, 1 = última) do caminho, interpolando
+	// linearmente entre as chaves vizinhas. Sem chaves não altera position e front
+	void sampleCamera(float s, glm::vec3& position, glm::vec3& front) const;
+};
@@ -0,0 +1,34 @@
+#include "SceneTree.h"
+
+AABB SceneTree::meshBox(Mesh& mesh)
+{
+	const Bounds& bounds = mesh.worldBounds();
+	AABB box;
+	box.min = bounds.center - bounds.extents;
+	box.max = bounds.center + bounds.extents;
+	return box;
+}
+
+void SceneTree::update(std::vector<Mesh>& meshes)
+{
+	lastReinsertions = 0;
+	if (meshes.size() == proxies.size() && Mesh::revision == seenRevision)
+		return;
+
+	//Lista de Mesh diferente: refaz a árvore inteira
+	if (meshes.size() != proxies.size())
+	{
+		bvh.clear();
+		proxies.resize(meshes.size());
+		for (size_t i = 0; i < meshes.size(); i++)
+			proxies[i] = bvh.createProxy(meshBox(meshes[i]), (int)i);
+		lastReinsertions = (int)meshes.size();
+		seenRevision = Mesh::revision;
+		return;
+	}
+
+	for (size_t i = 0; i < meshes.size(); i++)
+		if (meshes[i].modified > seenRevision && bvh.moveProxy(proxies[i], meshBox(meshes[i])))
+			lastReinsertions++;
+	seenRevision = Mesh::revision;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+
+#include "DynamicBVH.h"
+#include "Mesh.h"
+
+// BVH dinâmica com uma folha por Mesh da cena (userData = índice em models).
+// update() só mexe nas Mesh modificadas desde a última chamada, e a maioria dos
+// movimentos pequenos nem altera a árvore, graças às caixas gordas
+class SceneTree
+{
+public:
+	SceneTree(float margin = 0.5f) : bvh(margin) {}
+	void update(std::vector<Mesh>& meshes);
+	const DynamicBVH& tree() const { return bvh; }
+	int reinsertions() const { return lastReinsertions; } //proxies reinseridos no último update
+
+	static AABB meshBox(Mesh& mesh);
+
+private:
+	DynamicBVH bvh;
+	std::vector<int> proxies; //proxy de cada Mesh
+	unsigned long long seenRevision = 0;
+	int lastReinsertions = 0;
+};
@@ -8,6 +8,16 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+
+#include "Profiler.h"
+
+// Typed handles to uniform locations. Resolve them once (e.g. in Mesh::initialize)
+// and set values in hot paths with no string hashing or driver lookup
+struct UniformInt { GLint location = -1; };
+struct UniformFloat { GLint location = -1; };
+struct UniformVec3 { GLint location = -1; };
+struct UniformMat4 { GLint location = -1; };
 
 class Shader
 {
@@ -17,6 +27,7 @@ public:
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath)
     {
+        PROFILE_ZONE("Shader compile");
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -65,6 +76,7 @@ public:
         glAttachShader(ID, fragment);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        cacheUniformLocations();
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -75,34 +87,95 @@ public:
     {
         glUseProgram(ID);
     }
+    // uniform locations, from the cache filled after linking (-1 if not active).
+    // Names the reflection doesn't list (e.g. "lights[1]") are asked to the driver once
+    // ------------------------------------------------------------------------
+    GLint getUniformLocation(const std::string& name) const
+    {
+        std::unordered_map<std::string, GLint>::const_iterator it = uniformLocations.find(name);
+        if (it != uniformLocations.end())
+            return it->second;
+        GLint location = glGetUniformLocation(ID, name.c_str());
+        uniformLocations[name] = location;
+        return location;
+    }
+    UniformInt uniformInt(const std::string& name) const { UniformInt u; u.location = getUniformLocation(name); return u; }
+    UniformFloat uniformFloat(const std::string& name) const { UniformFloat u; u.location = getUniformLocation(name); return u; }
+    UniformVec3 uniformVec3(const std::string& name) const { UniformVec3 u; u.location = getUniformLocation(name); return u; }
+    UniformMat4 uniformMat4(const std::string& name) const { UniformMat4 u; u.location = getUniformLocation(name); return u; }
+    // typed handle setters (the program must be in use)
+    // ------------------------------------------------------------------------
+    void set(UniformInt u, int value) const
+    {
+        glUniform1i(u.location, value);
+    }
+    void set(UniformFloat u, float value) const
+    {
+        glUniform1f(u.location, value);
+    }
+    void set(UniformVec3 u, float v1, float v2, float v3) const
+    {
+        glUniform3f(u.location, v1, v2, v3);
+    }
+    void set(UniformMat4 u, const float* m) const
+    {
+        glUniformMatrix4fv(u.location, 1, FALSE, m);
+    }
     // utility uniform functions
     // ------------------------------------------------------------------------
     void setBool(const std::string& name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        glUniform1i(getUniformLocation(name), (int)value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string& name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(getUniformLocation(name), value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string& name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1f(getUniformLocation(name), value);
     }
 
     void setVec3(const std::string& name, float v1, float v2, float v3) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), v1, v2, v3);
+        glUniform3f(getUniformLocation(name), v1, v2, v3);
     }
 
     void setMat4(const std::string& name, float* m) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, FALSE, m);
+        glUniformMatrix4fv(getUniformLocation(name), 1, FALSE, m);
     }
 
 private:
+    mutable std::unordered_map<std::string, GLint> uniformLocations;
+
+    // reflect every active uniform after linking and remember its location.
+    // Arrays are stored both as "name" and "name[0]"
+    // ------------------------------------------------------------------------
+    void cacheUniformLocations()
+    {
+        uniformLocations.clear();
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::string name(maxLength > 0 ? maxLength : 1, '\0');
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, &name[0]);
+            std::string uniformName = name.substr(0, length);
+            GLint location = glGetUniformLocation(ID, uniformName.c_str());
+            if (location < 0)
+                continue; // uniforms inside uniform blocks have no location
+            uniformLocations[uniformName] = location;
+            if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+                uniformLocations[uniformName.substr(0, uniformName.size() - 3)] = location;
+        }
+    }
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(unsigned int shader, std::string type)
@@ -0,0 +1,600 @@
+#include "SoftwareRenderer.h"
+#include "ObjLoader.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SOFTWARE_RENDERER_SSE 1
+#endif
+
+using namespace std;
+
+namespace
+{
+	// Posições em ponto fixo com 4 bits de fração (1/16 de pixel)
+	const int SUBPIXEL_BITS = 4;
+	const int SUBPIXEL = 1 << SUBPIXEL_BITS;
+
+	// Coordenadas são recortadas a essa distância (em pixels) do centro da imagem,
+	// o que limita o passo das arestas num bloco de 4 pixels a menos de 2^24
+	const float GUARD_PIXELS = 8192.0f;
+
+	// Valores de aresta além disso estão longe demais da aresta para mudar de sinal
+	// dentro de um bloco; são saturados para caberem em 32 bits
+	const int64_t EDGE_CLAMP = (int64_t)1 << 30;
+
+	const size_t VERTEX_JOB = 16384;
+	const size_t TRIANGLE_JOB = 8192;
+
+	// Índices dos valores interpolados
+	enum { DEPTH, INV_W, WORLD_X, WORLD_Y, WORLD_Z, NORMAL_X, NORMAL_Y, NORMAL_Z };
+
+	uint32_t packColor(float r, float g, float b)
+	{
+		auto channel = [](float v) { return (uint32_t)(min(max(v, 0.0f), 1.0f) * 255.0f + 0.5f); };
+		return channel(r) | (channel(g) << 8) | (channel(b) << 16) | 0xFF000000u;
+	}
+
+	int32_t clampEdge(int64_t e)
+	{
+		return (int32_t)max(-EDGE_CLAMP, min(EDGE_CLAMP, e));
+	}
+
+	// Distância com sinal ao plano de recorte (>= 0 dentro): 0 = near, 1 a 4 = banda de guarda
+	float planeDistance(int plane, const glm::vec4& p, float guardX, float guardY)
+	{
+		switch (plane)
+		{
+		case 0: return p.z + p.w;
+		case 1: return guardX * p.w - p.x;
+		case 2: return guardX * p.w + p.x;
+		case 3: return guardY * p.w - p.y;
+		default: return guardY * p.w + p.y;
+		}
+	}
+
+#ifdef SOFTWARE_RENDERER_SSE
+	inline __m128 dot3(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+	}
+
+	inline void normalize3(__m128& x, __m128& y, __m128& z)
+	{
+		__m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(dot3(x, y, z, x, y, z)));
+		x = _mm_mul_ps(x, invLength);
+		y = _mm_mul_ps(y, invLength);
+		z = _mm_mul_ps(z, invLength);
+	}
+
+	// log2 de x > 0: expoente do float mais a série de atanh na mantissa (erro < 2e-5)
+	inline __m128 log2Approx(__m128 x)
+	{
+		__m128i bits = _mm_castps_si128(x);
+		__m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 mantissa = _mm_or_ps(_mm_castsi128_ps(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF))), one);
+		__m128 t = _mm_div_ps(_mm_sub_ps(mantissa, one), _mm_add_ps(mantissa, one));
+		__m128 t2 = _mm_mul_ps(t, t);
+		__m128 series = _mm_add_ps(_mm_set1_ps(1.0f / 5.0f), _mm_mul_ps(t2, _mm_set1_ps(1.0f / 7.0f)));
+		series = _mm_add_ps(_mm_set1_ps(1.0f / 3.0f), _mm_mul_ps(t2, series));
+		series = _mm_add_ps(one, _mm_mul_ps(t2, series));
+		return _mm_add_ps(exponent, _mm_mul_ps(_mm_mul_ps(t, series), _mm_set1_ps(2.0f / 0.69314718f)));
+	}
+
+	// 2^y para y <= 0: parte inteira no expoente e Taylor de e^(f ln 2) na fração
+	inline __m128 exp2Approx(__m128 y)
+	{
+		y = _mm_max_ps(y, _mm_set1_ps(-126.0f));
+		__m128i whole = _mm_cvttps_epi32(y);
+		__m128 wholeF = _mm_cvtepi32_ps(whole);
+		__m128 adjust = _mm_cmpgt_ps(wholeF, y);
+		whole = _mm_add_epi32(whole, _mm_castps_si128(adjust)); //-1 onde truncou para cima
+		wholeF = _mm_sub_ps(wholeF, _mm_and_ps(adjust, _mm_set1_ps(1.0f)));
+		__m128 f = _mm_mul_ps(_mm_sub_ps(y, wholeF), _mm_set1_ps(0.69314718f));
+		__m128 p = _mm_set1_ps(1.0f / 720.0f);
+		p = _mm_add_ps(_mm_set1_ps(1.0f / 120.0f), _mm_mul_ps(f, p));
+		p = _mm_add_ps(_mm_set1_ps(1.0f / 24.0f), _mm_mul_ps(f, p));
+		p = _mm_add_ps(_mm_set1_ps(1.0f / 6.0f), _mm_mul_ps(f, p));
+		p = _mm_add_ps(_mm_set1_ps(0.5f), _mm_mul_ps(f, p));
+		p = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(f, p));
+		p = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(f, p));
+		__m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(whole, _mm_set1_epi32(127)), 23));
+		return _mm_mul_ps(p, scale);
+	}
+
+	inline __m128i toChannel(__m128 v)
+	{
+		v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+	}
+#endif
+}
+
+SoftwareRenderer::SoftwareRenderer(int nThreads)
+{
+	pool.reset(new ThreadPool(nThreads));
+}
+
+void SoftwareRenderer::resize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+	//Linhas com múltiplo de 4 pixels: os blocos da borda direita leem e escrevem sem sair da linha
+	pitch = (width + 3) & ~3;
+	tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	guardX = GUARD_PIXELS / (width * 0.5f);
+	guardY = GUARD_PIXELS / (height * 0.5f);
+	color.assign((size_t)pitch * height, 0);
+	depth.assign((size_t)pitch * height, 1.0f);
+}
+
+void SoftwareRenderer::render(vector<Mesh>& meshes, const FrameData& frame, const PhongMaterial& material, glm::vec3 background, const FrustumCuller* culler)
+{
+	PROFILE_ZONE("software render");
+	glm::mat4 viewProjection = frame.projection * frame.view;
+	clearColor = packColor(background.r, background.g, background.b);
+
+	//Mesh visíveis e a posição dos seus vértices e triângulos nas listas do quadro
+	draws.clear();
+	culledIndices.clear();
+	lastMeshletStats = MeshletStats();
+	vector<size_t> culledFirst;
+	size_t nVertices = 0, nTriangles = 0;
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		const Geometry* geometry = meshes[i].geometry.get();
+		if ((culler != nullptr && !culler->isVisible((int)i)) || geometry->indices.empty())
+			continue;
+		Draw draw;
+		draw.geometry = geometry;
+		draw.model = meshes[i].modelMatrix();
+		draw.mvp = viewProjection * draw.model;
+		draw.color = meshes[i].getColor();
+		draw.indices = geometry->indices.data();
+		draw.firstVertex = nVertices;
+		draw.firstTriangle = nTriangles;
+		nVertices += geometry->vertices.size() / OBJ_FLOATS_PER_VERTEX;
+		size_t triangles = geometry->indices.size() / 3;
+
+		//Só os índices dos meshlets que sobram, copiados para culledIndices
+		if (meshletCulling && !geometry->meshlets.empty())
+		{
+			MeshletView view = meshletView(viewProjection, draw.model, glm::vec3(frame.cameraPos));
+			size_t first = culledIndices.size();
+			for (const Meshlet& meshlet : geometry->meshlets)
+			{
+				int visibility = classifyMeshlet(meshlet, view);
+				lastMeshletStats.add(meshlet, visibility);
+				if (visibility == MESHLET_VISIBLE)
+					culledIndices.insert(culledIndices.end(), geometry->indices.begin() + meshlet.firstIndex,
+						geometry->indices.begin() + meshlet.firstIndex + meshlet.triangleCount * 3);
+			}
+			culledFirst.resize(draws.size() + 1, SIZE_MAX);
+			culledFirst[draws.size()] = first;
+			triangles = (culledIndices.size() - first) / 3;
+		}
+		nTriangles += triangles;
+		draws.push_back(draw);
+	}
+	//culledIndices só para de crescer no fim: os ponteiros são acertados depois
+	for (size_t d = 0; d < culledFirst.size(); d++)
+		if (culledFirst[d] != SIZE_MAX)
+			draws[d].indices = culledIndices.data() + culledFirst[d];
+
+	{
+		PROFILE_ZONE("software vertices");
+		transformed.resize(nVertices);
+		struct Job { size_t draw, first, count; };
+		vector<Job> jobs;
+		for (size_t d = 0; d < draws.size(); d++)
+		{
+			size_t count = draws[d].geometry->vertices.size() / OBJ_FLOATS_PER_VERTEX;
+			for (size_t first = 0; first < count; first += VERTEX_JOB)
+				jobs.push_back({ d, first, min(VERTEX_JOB, count - first) });
+		}
+		if (!jobs.empty())
+			pool->parallelFor((int)jobs.size(), [&](int j) { transformVertices(draws[jobs[j].draw], jobs[j].first, jobs[j].count); });
+	}
+
+	{
+		PROFILE_ZONE("software setup");
+		batchCount = (nTriangles + TRIANGLE_JOB - 1) / TRIANGLE_JOB;
+		if (batches.size() < batchCount)
+			batches.resize(batchCount);
+		if (batchCount > 0)
+			pool->parallelFor((int)batchCount, [&](int b) {
+				setupTriangles(b * TRIANGLE_JOB, min(TRIANGLE_JOB, nTriangles - b * TRIANGLE_JOB), batches[b]);
+			});
+		lastTriangles = 0;
+		for (size_t b = 0; b < batchCount; b++)
+			lastTriangles += batches[b].triangles.size();
+	}
+
+	{
+		PROFILE_ZONE("software raster");
+		Shading shading;
+		shading.material = material;
+		shading.lightPos = glm::vec3(frame.lightPos);
+		shading.lightColor = glm::vec3(frame.lightColor);
+		shading.cameraPos = glm::vec3(frame.cameraPos);
+
+		//Tiles distribuídos dinamicamente: quem termina antes pega o próximo
+		int nTiles = tilesX * tilesY;
+		atomic<int> nextTile(0);
+		pool->parallelFor(min(pool->size(), nTiles), [&](int) {
+			for (int tile = nextTile++; tile < nTiles; tile = nextTile++)
+				rasterizeTile(tile, shading);
+		});
+	}
+}
+
+void SoftwareRenderer::transformVertices(const Draw& draw, size_t first, size_t count)
+{
+	const float* vertices = draw.geometry->vertices.data();
+	for (size_t i = first; i < first + count; i++)
+	{
+		const float* v = vertices + i * OBJ_FLOATS_PER_VERTEX;
+		glm::vec4 position(v[0], v[1], v[2], 1.0f);
+		ClipVertex& out = transformed[draw.firstVertex + i];
+		out.clip = draw.mvp * position;
+		out.world = glm::vec3(draw.model * position);
+		//Como no Phong.vs, a normal não passa pela matriz de modelo
+		out.normal = glm::vec3(v[8], v[9], v[10]);
+	}
+}
+
+void SoftwareRenderer::setupTriangles(size_t first, size_t count, Batch& batch)
+{
+	batch.triangles.clear();
+	batch.bins.resize((size_t)tilesX * tilesY);
+	for (vector<uint32_t>& bin : batch.bins)
+		bin.clear();
+
+	//Draw que contém o primeiro triângulo da faixa
+	size_t d = upper_bound(draws.begin(), draws.end(), first, [](size_t t, const Draw& draw) { return t < draw.firstTriangle; }) - draws.begin() - 1;
+	for (size_t t = first; t < first + count; t++)
+	{
+		while (d + 1 < draws.size() && draws[d + 1].firstTriangle <= t)
+			d++;
+		const Draw& draw = draws[d];
+		const uint32_t* indices = draw.indices + (t - draw.firstTriangle) * 3;
+		const ClipVertex* corners[3] = {
+			&transformed[draw.firstVertex + indices[0]],
+			&transformed[draw.firstVertex + indices[1]],
+			&transformed[draw.firstVertex + indices[2]]
+		};
+		clipAndAdd(corners, draw.color, batch);
+	}
+}
+
+void SoftwareRenderer::clipAndAdd(const ClipVertex* corners[3], const glm::vec3& color, Batch& batch)
+{
+	//Descarte: os três vértices fora do mesmo plano do frustum
+	int outside = 0x3F;
+	int needsClip = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& p = corners[i]->clip;
+		int code = (p.x < -p.w ? 1 : 0) | (p.x > p.w ? 2 : 0) | (p.y < -p.w ? 4 : 0)
+			| (p.y > p.w ? 8 : 0) | (p.z < -p.w ? 16 : 0) | (p.z > p.w ? 32 : 0);
+		outside &= code;
+		for (int plane = 0; plane < 5; plane++)
+			if (planeDistance(plane, p, guardX, guardY) < 0.0f)
+				needsClip |= 1 << plane;
+	}
+	if (outside != 0)
+		return;
+
+	//Recorte de Sutherland-Hodgman só nos planos que o triângulo cruza
+	ClipVertex polygon[2][12];
+	int n = 3;
+	for (int i = 0; i < 3; i++)
+		polygon[0][i] = *corners[i];
+	int current = 0;
+	for (int plane = 0; plane < 5 && n > 0; plane++)
+	{
+		if ((needsClip & (1 << plane)) == 0)
+			continue;
+		const ClipVertex* in = polygon[current];
+		ClipVertex* out = polygon[current ^ 1];
+		int m = 0;
+		for (int i = 0; i < n; i++)
+		{
+			const ClipVertex& a = in[i];
+			const ClipVertex& b = in[(i + 1) % n];
+			float da = planeDistance(plane, a.clip, guardX, guardY);
+			float db = planeDistance(plane, b.clip, guardX, guardY);
+			if (da >= 0.0f)
+				out[m++] = a;
+			if ((da >= 0.0f) != (db >= 0.0f))
+			{
+				float f = da / (da - db);
+				ClipVertex& v = out[m++];
+				v.clip = glm::mix(a.clip, b.clip, f);
+				v.world = glm::mix(a.world, b.world, f);
+				v.normal = glm::mix(a.normal, b.normal, f);
+			}
+		}
+		n = m;
+		current ^= 1;
+	}
+	if (n < 3)
+		return;
+
+	//Projeção: a imagem tem a linha de cima primeiro, então y é invertido
+	ScreenVertex screen[12];
+	for (int i = 0; i < n; i++)
+	{
+		const ClipVertex& v = polygon[current][i];
+		float invW = 1.0f / v.clip.w;
+		float x = (v.clip.x * invW * 0.5f + 0.5f) * width;
+		float y = (0.5f - v.clip.y * invW * 0.5f) * height;
+		ScreenVertex& s = screen[i];
+		s.x = (int32_t)lrintf(x * SUBPIXEL);
+		s.y = (int32_t)lrintf(y * SUBPIXEL);
+		s.value[DEPTH] = v.clip.z * invW;
+		s.value[INV_W] = invW;
+		s.value[WORLD_X] = v.world.x * invW;
+		s.value[WORLD_Y] = v.world.y * invW;
+		s.value[WORLD_Z] = v.world.z * invW;
+		s.value[NORMAL_X] = v.normal.x * invW;
+		s.value[NORMAL_Y] = v.normal.y * invW;
+		s.value[NORMAL_Z] = v.normal.z * invW;
+	}
+	for (int i = 1; i + 1 < n; i++)
+		addTriangle(screen[0], screen[i], screen[i + 1], color, batch);
+}
+
+void SoftwareRenderer::addTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c, const glm::vec3& color, Batch& batch)
+{
+	//Sem descarte de faces de trás (o programa não liga GL_CULL_FACE): as duas
+	//orientações são rasterizadas, trocando dois vértices quando a área é negativa
+	const ScreenVertex* v[3] = { &a, &b, &c };
+	int64_t area = (int64_t)(b.x - a.x) * (c.y - a.y) - (int64_t)(c.x - a.x) * (b.y - a.y);
+	if (area == 0)
+		return;
+	if (area < 0)
+	{
+		swap(v[1], v[2]);
+		area = -area;
+	}
+
+	//Pixels cujos centros (16i + 8) podem estar dentro do triângulo
+	int32_t minX = min(v[0]->x, min(v[1]->x, v[2]->x)), maxX = max(v[0]->x, max(v[1]->x, v[2]->x));
+	int32_t minY = min(v[0]->y, min(v[1]->y, v[2]->y)), maxY = max(v[0]->y, max(v[1]->y, v[2]->y));
+	Triangle triangle;
+	triangle.minX = max(0, (minX - SUBPIXEL / 2 + SUBPIXEL - 1) >> SUBPIXEL_BITS);
+	triangle.maxX = min(width - 1, (maxX - SUBPIXEL / 2) >> SUBPIXEL_BITS);
+	triangle.minY = max(0, (minY - SUBPIXEL / 2 + SUBPIXEL - 1) >> SUBPIXEL_BITS);
+	triangle.maxY = min(height - 1, (maxY - SUBPIXEL / 2) >> SUBPIXEL_BITS);
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+		return;
+
+	//Aresta k vai de v[k] a v[k + 1] e é positiva do lado do vértice oposto.
+	//Regra top-left: pixels exatamente sobre a aresta só contam nas arestas de cima
+	//e da esquerda, para que dois triângulos vizinhos nunca desenhem o mesmo pixel
+	for (int k = 0; k < 3; k++)
+	{
+		const ScreenVertex* from = v[k];
+		const ScreenVertex* to = v[(k + 1) % 3];
+		int32_t dx = to->x - from->x, dy = to->y - from->y;
+		triangle.edgeDx[k] = dx;
+		triangle.edgeDy[k] = dy;
+		triangle.edgeAx[k] = from->x;
+		triangle.edgeAy[k] = from->y;
+		triangle.edgeBias[k] = (dy < 0 || (dy == 0 && dx > 0)) ? 0 : -1;
+	}
+
+	//Planos dos valores interpolados, em pixels a partir do vértice 0
+	float x1 = (v[1]->x - v[0]->x) / (float)SUBPIXEL, y1 = (v[1]->y - v[0]->y) / (float)SUBPIXEL;
+	float x2 = (v[2]->x - v[0]->x) / (float)SUBPIXEL, y2 = (v[2]->y - v[0]->y) / (float)SUBPIXEL;
+	float invArea = (float)(SUBPIXEL * SUBPIXEL) / (float)area;
+	triangle.originX = v[0]->x / (float)SUBPIXEL;
+	triangle.originY = v[0]->y / (float)SUBPIXEL;
+	for (int s = 0; s < INTERPOLANTS; s++)
+	{
+		float d1 = v[1]->value[s] - v[0]->value[s], d2 = v[2]->value[s] - v[0]->value[s];
+		triangle.value[s] = v[0]->value[s];
+		triangle.dx[s] = (d1 * y2 - d2 * y1) * invArea;
+		triangle.dy[s] = (d2 * x1 - d1 * x2) * invArea;
+	}
+	triangle.color = color;
+
+	uint32_t index = (uint32_t)batch.triangles.size();
+	batch.triangles.push_back(triangle);
+	for (int ty = triangle.minY / TILE_SIZE; ty <= triangle.maxY / TILE_SIZE; ty++)
+		for (int tx = triangle.minX / TILE_SIZE; tx <= triangle.maxX / TILE_SIZE; tx++)
+			batch.bins[ty * tilesX + tx].push_back(index);
+}
+
+void SoftwareRenderer::rasterizeTile(int tile, const Shading& shading)
+{
+	int x0 = (tile % tilesX) * TILE_SIZE, y0 = (tile / tilesX) * TILE_SIZE;
+	int x1 = min(width, x0 + TILE_SIZE), y1 = min(height, y0 + TILE_SIZE);
+
+	//Limpa só o tile, enquanto ele está no cache
+	for (int y = y0; y < y1; y++)
+	{
+		fill(color.begin() + (size_t)y * pitch + x0, color.begin() + (size_t)y * pitch + x1, clearColor);
+		fill(depth.begin() + (size_t)y * pitch + x0, depth.begin() + (size_t)y * pitch + x1, 1.0f);
+	}
+
+	//Lotes em ordem de envio, como na GPU
+	for (size_t b = 0; b < batchCount; b++)
+	{
+		const Batch& batch = batches[b];
+		for (uint32_t index : batch.bins[tile])
+			rasterizeTriangle(batch.triangles[index], x0, y0, x1, y1, shading);
+	}
+}
+
+void SoftwareRenderer::rasterizeTriangle(const Triangle& t, int tileX0, int tileY0, int tileX1, int tileY1, const Shading& shading)
+{
+	//Blocos de 4 pixels alinhados; como TILE_SIZE é múltiplo de 4 eles não saem do tile
+	int bx0 = max(t.minX, tileX0) & ~3;
+	int bx1 = min(t.maxX, tileX1 - 1);
+	int by0 = max(t.minY, tileY0);
+	int by1 = min(t.maxY, tileY1 - 1);
+	const PhongMaterial& m = shading.material;
+	glm::vec3 ambient = shading.lightColor * m.ka;
+
+#ifdef SOFTWARE_RENDERER_SSE
+	__m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+	__m128 lanesF = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	__m128i laneStep[3], bias[3];
+	for (int k = 0; k < 3; k++)
+	{
+		//E(x + 1) = E(x) - dy * 16: o passo de um pixel, multiplicado pela posição na faixa
+		int32_t step = -t.edgeDy[k] * SUBPIXEL;
+		laneStep[k] = _mm_setr_epi32(0, step, 2 * step, 3 * step);
+		bias[k] = _mm_set1_epi32(t.edgeBias[k] - 1); //e + bias > -1  <=>  e + edgeBias >= 0
+	}
+	__m128i minusOne = _mm_set1_epi32(-1);
+	__m128 one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+	__m128 lightX = _mm_set1_ps(shading.lightPos.x), lightY = _mm_set1_ps(shading.lightPos.y), lightZ = _mm_set1_ps(shading.lightPos.z);
+	__m128 cameraX = _mm_set1_ps(shading.cameraPos.x), cameraY = _mm_set1_ps(shading.cameraPos.y), cameraZ = _mm_set1_ps(shading.cameraPos.z);
+	__m128 q = _mm_set1_ps(m.q);
+	//(ambient + diff * lightColor * kd) * cor + spec * ks * lightColor, por canal
+	__m128 baseR = _mm_set1_ps(ambient.r * t.color.r), baseG = _mm_set1_ps(ambient.g * t.color.g), baseB = _mm_set1_ps(ambient.b * t.color.b);
+	__m128 diffR = _mm_set1_ps(shading.lightColor.r * m.kd * t.color.r), diffG = _mm_set1_ps(shading.lightColor.g * m.kd * t.color.g), diffB = _mm_set1_ps(shading.lightColor.b * m.kd * t.color.b);
+	__m128 specR = _mm_set1_ps(shading.lightColor.r * m.ks), specG = _mm_set1_ps(shading.lightColor.g * m.ks), specB = _mm_set1_ps(shading.lightColor.b * m.ks);
+	__m128 valueDx[INTERPOLANTS], laneOffset[INTERPOLANTS];
+	for (int s = 0; s < INTERPOLANTS; s++)
+	{
+		valueDx[s] = _mm_set1_ps(t.dx[s] * 4.0f);
+		laneOffset[s] = _mm_mul_ps(_mm_set1_ps(t.dx[s]), lanesF);
+	}
+#endif
+
+	for (int y = by0; y <= by1; y++)
+	{
+		int32_t py = y * SUBPIXEL + SUBPIXEL / 2;
+		int32_t px = bx0 * SUBPIXEL + SUBPIXEL / 2;
+		int64_t edge[3];
+		for (int k = 0; k < 3; k++)
+			edge[k] = (int64_t)t.edgeDx[k] * (py - t.edgeAy[k]) - (int64_t)t.edgeDy[k] * (px - t.edgeAx[k]);
+		uint32_t* colorRow = color.data() + (size_t)y * pitch;
+		float* depthRow = depth.data() + (size_t)y * pitch;
+
+#ifdef SOFTWARE_RENDERER_SSE
+		//Valores no primeiro pixel da linha; cada bloco soma 4 passos
+		__m128 value[INTERPOLANTS];
+		for (int s = 0; s < INTERPOLANTS; s++)
+			value[s] = _mm_add_ps(_mm_set1_ps(t.value[s] + t.dx[s] * (bx0 + 0.5f - t.originX) + t.dy[s] * (y + 0.5f - t.originY)), laneOffset[s]);
+
+		for (int x = bx0; x <= bx1; x += 4)
+		{
+			__m128i inside = minusOne;
+			for (int k = 0; k < 3; k++)
+			{
+				__m128i e = _mm_add_epi32(_mm_set1_epi32(clampEdge(edge[k])), laneStep[k]);
+				inside = _mm_and_si128(inside, _mm_cmpgt_epi32(_mm_add_epi32(e, bias[k]), minusOne));
+				edge[k] -= (int64_t)t.edgeDy[k] * SUBPIXEL * 4;
+			}
+			if (x + 4 > width)
+				inside = _mm_and_si128(inside, _mm_cmplt_epi32(_mm_add_epi32(_mm_set1_epi32(x), lanes), _mm_set1_epi32(width)));
+
+			if (_mm_movemask_epi8(inside) != 0)
+			{
+				__m128 z = value[DEPTH];
+				__m128 oldDepth = _mm_loadu_ps(depthRow + x);
+				__m128 mask = _mm_and_ps(_mm_castsi128_ps(inside), _mm_cmplt_ps(z, oldDepth));
+				if (_mm_movemask_ps(mask) != 0)
+				{
+					_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, oldDepth)));
+
+					//Correção de perspectiva: valores / w divididos pelo 1/w interpolado
+					__m128 w = _mm_div_ps(one, value[INV_W]);
+					__m128 fragX = _mm_mul_ps(value[WORLD_X], w), fragY = _mm_mul_ps(value[WORLD_Y], w), fragZ = _mm_mul_ps(value[WORLD_Z], w);
+					__m128 nx = _mm_mul_ps(value[NORMAL_X], w), ny = _mm_mul_ps(value[NORMAL_Y], w), nz = _mm_mul_ps(value[NORMAL_Z], w);
+					normalize3(nx, ny, nz);
+					__m128 lx = _mm_sub_ps(lightX, fragX), ly = _mm_sub_ps(lightY, fragY), lz = _mm_sub_ps(lightZ, fragZ);
+					normalize3(lx, ly, lz);
+					__m128 nDotL = dot3(nx, ny, nz, lx, ly, lz);
+					__m128 diff = _mm_max_ps(nDotL, zero);
+
+					//R = reflect(-L, N) = 2 (N.L) N - L
+					__m128 twoNDotL = _mm_add_ps(nDotL, nDotL);
+					__m128 rx = _mm_sub_ps(_mm_mul_ps(twoNDotL, nx), lx), ry = _mm_sub_ps(_mm_mul_ps(twoNDotL, ny), ly), rz = _mm_sub_ps(_mm_mul_ps(twoNDotL, nz), lz);
+					__m128 vx = _mm_sub_ps(cameraX, fragX), vy = _mm_sub_ps(cameraY, fragY), vz = _mm_sub_ps(cameraZ, fragZ);
+					normalize3(vx, vy, vz);
+					__m128 rDotV = dot3(rx, ry, rz, vx, vy, vz);
+					__m128 positive = _mm_cmpgt_ps(rDotV, zero);
+					__m128 spec = _mm_and_ps(positive, exp2Approx(_mm_mul_ps(q, log2Approx(_mm_max_ps(rDotV, _mm_set1_ps(1e-30f))))));
+
+					__m128i r = toChannel(_mm_add_ps(_mm_add_ps(baseR, _mm_mul_ps(diff, diffR)), _mm_mul_ps(spec, specR)));
+					__m128i g = toChannel(_mm_add_ps(_mm_add_ps(baseG, _mm_mul_ps(diff, diffG)), _mm_mul_ps(spec, specG)));
+					__m128i b = toChannel(_mm_add_ps(_mm_add_ps(baseB, _mm_mul_ps(diff, diffB)), _mm_mul_ps(spec, specB)));
+					__m128i rgba = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_set1_epi32((int)0xFF000000u)));
+
+					__m128i maskI = _mm_castps_si128(mask);
+					__m128i oldColor = _mm_loadu_si128((const __m128i*)(colorRow + x));
+					_mm_storeu_si128((__m128i*)(colorRow + x), _mm_or_si128(_mm_and_si128(maskI, rgba), _mm_andnot_si128(maskI, oldColor)));
+				}
+			}
+			for (int s = 0; s < INTERPOLANTS; s++)
+				value[s] = _mm_add_ps(value[s], valueDx[s]);
+		}
+#else
+		for (int x = bx0; x <= bx1 && x < width; x++)
+		{
+			bool inside = true;
+			for (int k = 0; k < 3; k++)
+			{
+				inside = inside && edge[k] + t.edgeBias[k] >= 0;
+				edge[k] -= (int64_t)t.edgeDy[k] * SUBPIXEL;
+			}
+			if (!inside)
+				continue;
+
+			float value[INTERPOLANTS];
+			for (int s = 0; s < INTERPOLANTS; s++)
+				value[s] = t.value[s] + t.dx[s] * (x + 0.5f - t.originX) + t.dy[s] * (y + 0.5f - t.originY);
+			if (value[DEPTH] >= depthRow[x])
+				continue;
+			depthRow[x] = value[DEPTH];
+
+			float w = 1.0f / value[INV_W];
+			glm::vec3 fragPos = glm::vec3(value[WORLD_X], value[WORLD_Y], value[WORLD_Z]) * w;
+			glm::vec3 N = glm::normalize(glm::vec3(value[NORMAL_X], value[NORMAL_Y], value[NORMAL_Z]) * w);
+			glm::vec3 L = glm::normalize(shading.lightPos - fragPos);
+			float diff = max(glm::dot(N, L), 0.0f);
+			glm::vec3 R = glm::reflect(-L, N);
+			glm::vec3 V = glm::normalize(shading.cameraPos - fragPos);
+			float spec = pow(max(glm::dot(R, V), 0.0f), m.q);
+			glm::vec3 result = (ambient + diff * shading.lightColor * m.kd) * t.color + spec * m.ks * shading.lightColor;
+			colorRow[x] = packColor(result.r, result.g, result.b);
+		}
+#endif
+	}
+}
+
+bool SoftwareRenderer::writePPM(const string& filepath) const
+{
+	FILE* f = fopen(filepath.c_str(), "wb");
+	if (f == nullptr)
+		return false;
+
+	bool ok = fprintf(f, "P6\n%d %d\n255\n", width, height) > 0;
+	vector<unsigned char> row((size_t)width * 3);
+	for (int y = 0; y < height && ok; y++)
+	{
+		const uint32_t* pixels = color.data() + (size_t)y * pitch;
+		for (int x = 0; x < width; x++)
+		{
+			row[x * 3] = (unsigned char)(pixels[x] & 0xFF);
+			row[x * 3 + 1] = (unsigned char)((pixels[x] >> 8) & 0xFF);
+			row[x * 3 + 2] = (unsigned char)((pixels[x] >> 16) & 0xFF);
+		}
+		ok = fwrite(row.data(), 1, row.size(), f) == row.size();
+	}
+	ok = fclose(f) == 0 && ok;
+	return ok;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "FrameUniforms.h"
+#include "FrustumCuller.h"
+#include "ThreadPool.h"
+#include "Meshlets.h"
+
+// Propriedades do material do Phong.fs (o expoente especular é q)
+struct PhongMaterial
+{
+	float ka = 0.2f;
+	float kd = 0.5f;
+	float ks = 0.5f;
+	float q = 100.0f;
+};
+
+// Renderizador na CPU, para máquinas sem GPU (miniaturas e prévias). Desenha a mesma
+// lista de Mesh a partir da cópia na CPU da geometria (Geometry::vertices/indices, no
+// layout de 11 floats do loader) e reproduz o Phong.vs/Phong.fs com os dados do quadro.
+// Etapas, todas em paralelo na ThreadPool:
+//   1. vértices transformados (clip, mundo e normal) em lotes
+//   2. montagem dos triângulos: descarte fora do frustum, recorte no plano near e numa
+//      banda de guarda, e distribuição em tiles de TILE_SIZE pixels (listas por lote)
+//   3. rasterização: cada thread pega o próximo tile livre (contador atômico) e percorre
+//      os lotes em ordem, testando as arestas em inteiros em blocos de 4 pixels (SSE)
+//      e calculando a iluminação dos 4 pixels de uma vez
+class SoftwareRenderer
+{
+public:
+	static const int TILE_SIZE = 64;
+
+	// nThreads <= 0 usa todos os núcleos
+	SoftwareRenderer(int nThreads = 0);
+	void resize(int width, int height);
+	// culler (opcional) indica quais Mesh estão visíveis; as Mesh sem cópia na CPU são ignoradas
+	void render(std::vector<Mesh>& meshes, const FrameData& frame, const PhongMaterial& material, glm::vec3 background, const FrustumCuller* culler = nullptr);
+
+	// Grava a última imagem como PPM binário (P6)
+	bool writePPM(const std::string& filepath) const;
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	// Pixels RGBA8 (R no byte menos significativo), linha de cima primeiro, pitch pixels por linha
+	const std::vector<uint32_t>& colorBuffer() const { return color; }
+	int getPitch() const { return pitch; }
+	// Triângulos rasterizados no último quadro, já recortados
+	size_t triangleCount() const { return lastTriangles; }
+	// Com os meshlets ligados, as geometrias com Geometry::meshlets só montam os triângulos
+	// dos meshlets dentro do frustum e não de costas para a câmera (Meshlets.h)
+	void setMeshletCulling(bool enabled) { meshletCulling = enabled; }
+	const MeshletStats& meshletStats() const { return lastMeshletStats; } //do último quadro
+
+private:
+	// Número de valores interpolados: profundidade, 1/w, posição no mundo / w e normal / w
+	static const int INTERPOLANTS = 8;
+
+	struct ClipVertex
+	{
+		glm::vec4 clip;
+		glm::vec3 world;
+		glm::vec3 normal;
+	};
+
+	struct ScreenVertex
+	{
+		int32_t x, y; //posição em 1/16 de pixel
+		float value[INTERPOLANTS];
+	};
+
+	// Triângulo pronto para rasterizar: arestas em ponto fixo e planos dos valores interpolados
+	struct Triangle
+	{
+		int minX, minY, maxX, maxY; //pixels cobertos pela caixa, já limitados à imagem
+		int32_t edgeDx[3], edgeDy[3], edgeAx[3], edgeAy[3], edgeBias[3];
+		float originX, originY; //vértice 0 em pixels
+		float value[INTERPOLANTS], dx[INTERPOLANTS], dy[INTERPOLANTS];
+		glm::vec3 color;
+	};
+
+	struct Draw
+	{
+		const Geometry* geometry;
+		glm::mat4 mvp;
+		glm::mat4 model;
+		glm::vec3 color;
+		const uint32_t* indices; //da geometria, ou dos meshlets visíveis em culledIndices
+		size_t firstVertex;
+		size_t firstTriangle;
+	};
+
+	// Triângulos montados por uma faixa da lista e suas listas por tile
+	struct Batch
+	{
+		std::vector<Triangle> triangles;
+		std::vector<std::vector<uint32_t> > bins;
+	};
+
+	struct Shading
+	{
+		PhongMaterial material;
+		glm::vec3 lightPos, lightColor, cameraPos;
+	};
+
+	void transformVertices(const Draw& draw, size_t first, size_t count);
+	void setupTriangles(size_t first, size_t count, Batch& batch);
+	void clipAndAdd(const ClipVertex* corners[3], const glm::vec3& color, Batch& batch);
+	void addTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c, const glm::vec3& color, Batch& batch);
+	void rasterizeTile(int tile, const Shading& shading);
+	void rasterizeTriangle(const Triangle& triangle, int x0, int y0, int x1, int y1, const Shading& shading);
+
+	int width = 0, height = 0, pitch = 0;
+	int tilesX = 0, tilesY = 0;
+	float guardX = 1.0f, guardY = 1.0f; //banda de guarda em unidades de w
+	uint32_t clearColor = 0;
+	std::vector<uint32_t> color;
+	std::vector<float> depth;
+
+	std::unique_ptr<ThreadPool> pool;
+	std::vector<Draw> draws;
+	bool meshletCulling = false;
+	std::vector<uint32_t> culledIndices;
+	MeshletStats lastMeshletStats;
+	std::vector<ClipVertex> transformed;
+	std::vector<Batch> batches;
+	size_t batchCount = 0;
+	size_t lastTriangles = 0;
+};
@@ -0,0 +1,79 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+ThreadPool::ThreadPool(int nThreads)
+{
+	if (nThreads <= 0)
+		nThreads = hardwareThreads();
+	for (int i = 0; i < nThreads; i++)
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	taskAvailable.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back(std::move(task));
+		pending++;
+	}
+	taskAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	allDone.wait(lock, [this] { return pending == 0; });
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& body)
+{
+	//Com uma só tarefa não vale a pena passar pela fila
+	if (count == 1)
+	{
+		body(0);
+		return;
+	}
+	for (int i = 0; i < count; i++)
+		submit([&body, i] { body(i); });
+	wait();
+}
+
+int ThreadPool::hardwareThreads()
+{
+	int n = (int)std::thread::hardware_concurrency();
+	return n > 0 ? n : 1;
+}
+
+void ThreadPool::workerLoop()
+{
+	Profiler::setThreadName("worker");
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+			if (stopping && tasks.empty())
+				return;
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+
+		task();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--pending == 0)
+			allDone.notify_all();
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Conjunto fixo de threads trabalhadoras que executam tarefas de uma fila.
+// wait() bloqueia até que todas as tarefas enviadas tenham terminado.
+class ThreadPool
+{
+public:
+	// nThreads <= 0 usa o número de núcleos da máquina
+	ThreadPool(int nThreads = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void submit(std::function<void()> task);
+	void wait();
+
+	// Executa body(i) para i em [0, count) e espera todas terminarem
+	void parallelFor(int count, const std::function<void(int)>& body);
+
+	int size() const { return (int)workers.size(); }
+
+	static int hardwareThreads();
+
+private:
+	void workerLoop();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable taskAvailable;
+	std::condition_variable allDone;
+	int pending = 0;
+	bool stopping = false;
+};
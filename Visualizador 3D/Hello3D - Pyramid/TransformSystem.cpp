@@ -0,0 +1,116 @@
+#include "TransformSystem.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define TRANSFORM_SSE 1
+#endif
+
+void TransformSystem::resize(size_t count)
+{
+	px.resize(count);  py.resize(count);  pz.resize(count);
+	sx.resize(count, 1.0f);  sy.resize(count, 1.0f);  sz.resize(count, 1.0f);
+	qx.resize(count);  qy.resize(count);  qz.resize(count);  qw.resize(count, 1.0f);
+}
+
+void TransformSystem::set(size_t index, glm::vec3 position, glm::vec3 scale, float angle, glm::vec3 axis)
+{
+	px[index] = position.x;  py[index] = position.y;  pz[index] = position.z;
+	sx[index] = scale.x;  sy[index] = scale.y;  sz[index] = scale.z;
+
+	//Quaternion do eixo normalizado, como glm::rotate; eixo nulo vira identidade
+	float length = glm::length(axis);
+	float half = glm::radians(angle) * 0.5f;
+	float s = length > 0.0f ? sinf(half) / length : 0.0f;
+	qx[index] = axis.x * s;  qy[index] = axis.y * s;  qz[index] = axis.z * s;
+	qw[index] = length > 0.0f ? cosf(half) : 1.0f;
+}
+
+void TransformSystem::composeScalar(size_t i, float* m) const
+{
+	float x = qx[i], y = qy[i], z = qz[i], w = qw[i];
+	m[0] = (1.0f - 2.0f * (y * y + z * z)) * sx[i];
+	m[1] = 2.0f * (x * y + w * z) * sx[i];
+	m[2] = 2.0f * (x * z - w * y) * sx[i];
+	m[3] = 0.0f;
+	m[4] = 2.0f * (x * y - w * z) * sy[i];
+	m[5] = (1.0f - 2.0f * (x * x + z * z)) * sy[i];
+	m[6] = 2.0f * (y * z + w * x) * sy[i];
+	m[7] = 0.0f;
+	m[8] = 2.0f * (x * z + w * y) * sz[i];
+	m[9] = 2.0f * (y * z - w * x) * sz[i];
+	m[10] = (1.0f - 2.0f * (x * x + y * y)) * sz[i];
+	m[11] = 0.0f;
+	m[12] = px[i];
+	m[13] = py[i];
+	m[14] = pz[i];
+	m[15] = 1.0f;
+}
+
+void TransformSystem::compose(size_t first, size_t count, void* out, size_t stride) const
+{
+	char* dst = (char*)out;
+	size_t i = first, end = first + count;
+
+#ifdef TRANSFORM_SSE
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= end; i += 4, dst += 4 * stride)
+	{
+		__m128 x = _mm_loadu_ps(&qx[i]), y = _mm_loadu_ps(&qy[i]), z = _mm_loadu_ps(&qz[i]), w = _mm_loadu_ps(&qw[i]);
+		__m128 x2 = _mm_mul_ps(x, two), y2 = _mm_mul_ps(y, two), z2 = _mm_mul_ps(z, two);
+		__m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+		__m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+		__m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+		__m128 scaleX = _mm_loadu_ps(&sx[i]), scaleY = _mm_loadu_ps(&sy[i]), scaleZ = _mm_loadu_ps(&sz[i]);
+
+		//Cada registrador guarda o mesmo elemento da matriz dos 4 objetos;
+		//a transposição 4x4 transforma isso em uma coluna por objeto
+		__m128 c0 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), scaleX);
+		__m128 c1 = _mm_mul_ps(_mm_add_ps(xy, wz), scaleX);
+		__m128 c2 = _mm_mul_ps(_mm_sub_ps(xz, wy), scaleX);
+		__m128 c3 = zero;
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		_mm_storeu_ps((float*)(dst), c0);
+		_mm_storeu_ps((float*)(dst + stride), c1);
+		_mm_storeu_ps((float*)(dst + 2 * stride), c2);
+		_mm_storeu_ps((float*)(dst + 3 * stride), c3);
+
+		c0 = _mm_mul_ps(_mm_sub_ps(xy, wz), scaleY);
+		c1 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), scaleY);
+		c2 = _mm_mul_ps(_mm_add_ps(yz, wx), scaleY);
+		c3 = zero;
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		_mm_storeu_ps((float*)(dst + 16), c0);
+		_mm_storeu_ps((float*)(dst + stride + 16), c1);
+		_mm_storeu_ps((float*)(dst + 2 * stride + 16), c2);
+		_mm_storeu_ps((float*)(dst + 3 * stride + 16), c3);
+
+		c0 = _mm_mul_ps(_mm_add_ps(xz, wy), scaleZ);
+		c1 = _mm_mul_ps(_mm_sub_ps(yz, wx), scaleZ);
+		c2 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), scaleZ);
+		c3 = zero;
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		_mm_storeu_ps((float*)(dst + 32), c0);
+		_mm_storeu_ps((float*)(dst + stride + 32), c1);
+		_mm_storeu_ps((float*)(dst + 2 * stride + 32), c2);
+		_mm_storeu_ps((float*)(dst + 3 * stride + 32), c3);
+
+		c0 = _mm_loadu_ps(&px[i]);
+		c1 = _mm_loadu_ps(&py[i]);
+		c2 = _mm_loadu_ps(&pz[i]);
+		c3 = one;
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		_mm_storeu_ps((float*)(dst + 48), c0);
+		_mm_storeu_ps((float*)(dst + stride + 48), c1);
+		_mm_storeu_ps((float*)(dst + 2 * stride + 48), c2);
+		_mm_storeu_ps((float*)(dst + 3 * stride + 48), c3);
+	}
+#endif
+
+	//Restante (ou tudo, sem SSE) um objeto por vez
+	for (; i < end; i++, dst += stride)
+		composeScalar(i, (float*)dst);
+}
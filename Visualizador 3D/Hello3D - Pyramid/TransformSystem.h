@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+//GLM
+#include <glm/glm.hpp>
+
+// Transformações de muitos objetos em estrutura de arrays (SoA): cada componente
+// (posição, escala, rotação) fica num array próprio, de modo que a composição das
+// matrizes percorre memória contígua e processa 4 objetos por vez com SSE.
+// A rotação é guardada como quaternion, calculado uma vez em set(), para que a
+// composição não precise de seno/cosseno
+class TransformSystem
+{
+public:
+	void resize(size_t count);
+	size_t size() const { return px.size(); }
+
+	// Mesmos parâmetros de Mesh: ângulo em graus em torno de axis
+	void set(size_t index, glm::vec3 position, glm::vec3 scale, float angle, glm::vec3 axis);
+
+	// Compõe translate * rotate * scale dos objetos [first, first + count) e grava
+	// cada matriz (16 floats, coluna a coluna) em out, avançando stride bytes por
+	// objeto, o que permite escrever direto num buffer de instâncias mapeado
+	void compose(size_t first, size_t count, void* out, size_t stride) const;
+
+private:
+	void composeScalar(size_t index, float* out) const;
+
+	std::vector<float> px, py, pz;
+	std::vector<float> sx, sy, sz;
+	std::vector<float> qx, qy, qz, qw;
+};
@@ -0,0 +1,334 @@
+#include "TriangleBVH.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+using namespace std;
+
+namespace
+{
+	const int BVH_BINS = 12;
+	const uint32_t BVH_LEAF_SIZE = 4;
+	const size_t BVH_PARALLEL_MIN = 100000; //malhas menores são montadas numa thread só
+
+	struct Bin
+	{
+		glm::vec3 min = glm::vec3(FLT_MAX);
+		glm::vec3 max = glm::vec3(-FLT_MAX);
+		uint32_t count = 0;
+	};
+
+	float area(glm::vec3 min, glm::vec3 max)
+	{
+		glm::vec3 d = max - min;
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+
+	// Teste do raio contra a caixa (slabs); retorna a distância de entrada ou FLT_MAX
+	float intersectBox(glm::vec3 min, glm::vec3 max, glm::vec3 origin, glm::vec3 inverse, float tMax)
+	{
+		glm::vec3 t1 = (min - origin) * inverse;
+		glm::vec3 t2 = (max - origin) * inverse;
+		glm::vec3 tNear = glm::min(t1, t2), tFar = glm::max(t1, t2);
+		float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+		return enter <= exit ? enter : FLT_MAX;
+	}
+}
+
+// Estado compartilhado da montagem: caixas e centroides dos triângulos e a
+// lista order, que cada subárvore reordena só no seu próprio trecho
+struct TriangleBVH::Builder
+{
+	vector<glm::vec3> boxMin, boxMax, centroid;
+	vector<uint32_t> order;
+
+	// Subdivide a partir de nodes[rootIndex]. Nós com até deferLimit triângulos
+	// (acima do tamanho de folha) vão para deferred em vez de serem divididos
+	void subdivide(vector<Node>& nodes, uint32_t rootIndex, uint32_t deferLimit, vector<uint32_t>* deferred);
+};
+
+void TriangleBVH::Builder::subdivide(vector<Node>& nodes, uint32_t rootIndex, uint32_t deferLimit, vector<uint32_t>* deferred)
+{
+	vector<uint32_t> pending(1, rootIndex);
+	while (!pending.empty())
+	{
+		uint32_t index = pending.back();
+		pending.pop_back();
+		uint32_t first = nodes[index].leftFirst, count = nodes[index].count;
+
+		glm::vec3 nodeMin(FLT_MAX), nodeMax(-FLT_MAX), centerMin(FLT_MAX), centerMax(-FLT_MAX);
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			uint32_t t = order[i];
+			nodeMin = glm::min(nodeMin, boxMin[t]);
+			nodeMax = glm::max(nodeMax, boxMax[t]);
+			centerMin = glm::min(centerMin, centroid[t]);
+			centerMax = glm::max(centerMax, centroid[t]);
+		}
+		nodes[index].min = nodeMin;
+		nodes[index].max = nodeMax;
+		if (count <= BVH_LEAF_SIZE)
+			continue;
+		if (deferred != nullptr && count <= deferLimit)
+		{
+			deferred->push_back(index);
+			continue;
+		}
+
+		//Melhor divisão pelo custo de área de superfície, com os centroides em faixas
+		int bestAxis = -1, bestSplit = 0;
+		float bestCost = FLT_MAX;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float extent = centerMax[axis] - centerMin[axis];
+			if (extent <= 0.0f)
+				continue;
+			float scale = BVH_BINS / extent;
+
+			Bin bins[BVH_BINS];
+			for (uint32_t i = first; i < first + count; i++)
+			{
+				uint32_t t = order[i];
+				int b = std::min(BVH_BINS - 1, (int)((centroid[t][axis] - centerMin[axis]) * scale));
+				bins[b].count++;
+				bins[b].min = glm::min(bins[b].min, boxMin[t]);
+				bins[b].max = glm::max(bins[b].max, boxMax[t]);
+			}
+
+			//Varredura da esquerda e da direita acumulando contagem e área
+			float leftArea[BVH_BINS - 1], rightArea[BVH_BINS - 1];
+			uint32_t leftCount[BVH_BINS - 1], rightCount[BVH_BINS - 1];
+			Bin left, right;
+			for (int b = 0; b < BVH_BINS - 1; b++)
+			{
+				left.count += bins[b].count;
+				left.min = glm::min(left.min, bins[b].min);
+				left.max = glm::max(left.max, bins[b].max);
+				leftCount[b] = left.count;
+				leftArea[b] = left.count > 0 ? area(left.min, left.max) : 0.0f;
+
+				int r = BVH_BINS - 1 - b;
+				right.count += bins[r].count;
+				right.min = glm::min(right.min, bins[r].min);
+				right.max = glm::max(right.max, bins[r].max);
+				rightCount[r - 1] = right.count;
+				rightArea[r - 1] = right.count > 0 ? area(right.min, right.max) : 0.0f;
+			}
+			for (int b = 0; b < BVH_BINS - 1; b++)
+			{
+				float cost = leftCount[b] * leftArea[b] + rightCount[b] * rightArea[b];
+				if (leftCount[b] > 0 && rightCount[b] > 0 && cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = b;
+				}
+			}
+		}
+
+		//Todos os centroides no mesmo ponto: divide a lista ao meio
+		uint32_t middle;
+		if (bestAxis < 0)
+			middle = first + count / 2;
+		else
+		{
+			//Dividir não compensa: folha um pouco maior
+			if (bestCost >= count * area(nodeMin, nodeMax) && count <= 4 * BVH_LEAF_SIZE)
+				continue;
+			float scale = BVH_BINS / (centerMax[bestAxis] - centerMin[bestAxis]);
+			uint32_t* split = std::partition(order.data() + first, order.data() + first + count, [&](uint32_t t) {
+				return std::min(BVH_BINS - 1, (int)((centroid[t][bestAxis] - centerMin[bestAxis]) * scale)) <= bestSplit;
+			});
+			middle = (uint32_t)(split - order.data());
+		}
+
+		Node left, right;
+		left.leftFirst = first;
+		left.count = middle - first;
+		right.leftFirst = middle;
+		right.count = first + count - middle;
+		uint32_t leftIndex = (uint32_t)nodes.size();
+		nodes.push_back(left);
+		nodes.push_back(right);
+		nodes[index].leftFirst = leftIndex;
+		nodes[index].count = 0;
+		pending.push_back(leftIndex);
+		pending.push_back(leftIndex + 1);
+	}
+}
+
+void TriangleBVH::build(const void* vertices, size_t vertexCount, size_t stride, const void* indices, size_t indexCount, bool shortIndices, int nThreads)
+{
+	positions.resize(vertexCount);
+	const char* data = (const char*)vertices;
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		const float* p = (const float*)(data + i * stride);
+		positions[i] = glm::vec3(p[0], p[1], p[2]);
+	}
+
+	size_t nTriangles = indexCount / 3;
+	triangles.resize(nTriangles * 3);
+	for (size_t i = 0; i < nTriangles * 3; i++)
+		triangles[i] = shortIndices ? ((const uint16_t*)indices)[i] : ((const uint32_t*)indices)[i];
+
+	nodes.clear();
+	original.clear();
+	if (nTriangles == 0)
+		return;
+
+	//Caixas e centroides de cada triângulo; a árvore reordena só a lista order
+	Builder builder;
+	builder.boxMin.resize(nTriangles);
+	builder.boxMax.resize(nTriangles);
+	builder.centroid.resize(nTriangles);
+	builder.order.resize(nTriangles);
+	for (size_t t = 0; t < nTriangles; t++)
+	{
+		glm::vec3 a = positions[triangles[3 * t]], b = positions[triangles[3 * t + 1]], c = positions[triangles[3 * t + 2]];
+		builder.boxMin[t] = glm::min(a, glm::min(b, c));
+		builder.boxMax[t] = glm::max(a, glm::max(b, c));
+		builder.centroid[t] = (builder.boxMin[t] + builder.boxMax[t]) * 0.5f;
+		builder.order[t] = (uint32_t)t;
+	}
+
+	nodes.reserve(2 * nTriangles / BVH_LEAF_SIZE + 1);
+	Node root;
+	root.leftFirst = 0;
+	root.count = (uint32_t)nTriangles;
+	nodes.push_back(root);
+
+	if (nThreads <= 0)
+		nThreads = ThreadPool::hardwareThreads();
+	if (nThreads == 1 || nTriangles < BVH_PARALLEL_MIN)
+		builder.subdivide(nodes, 0, 0, nullptr);
+	else
+	{
+		//Os níveis de cima são divididos aqui; as subárvores abaixo de deferLimit
+		//triângulos são montadas em paralelo, cada uma no seu vetor de nós, e depois
+		//anexadas ao vetor principal com os índices dos filhos deslocados
+		uint32_t deferLimit = (uint32_t)std::max<size_t>(BVH_PARALLEL_MIN / 4, nTriangles / (8 * nThreads));
+		vector<uint32_t> deferred;
+		builder.subdivide(nodes, 0, deferLimit, &deferred);
+
+		vector<vector<Node> > subtrees(deferred.size());
+		ThreadPool pool(std::min((int)deferred.size(), nThreads));
+		pool.parallelFor((int)deferred.size(), [&](int s) {
+			PROFILE_ZONE("TriangleBVH subtree");
+			subtrees[s].push_back(nodes[deferred[s]]);
+			builder.subdivide(subtrees[s], 0, 0, nullptr);
+		});
+
+		for (size_t s = 0; s < deferred.size(); s++)
+		{
+			//O nó local i > 0 vai para offset + i - 1; a raiz local substitui o nó adiado
+			uint32_t offset = (uint32_t)nodes.size();
+			for (Node& node : subtrees[s])
+				if (node.count == 0)
+					node.leftFirst += offset - 1;
+			nodes[deferred[s]] = subtrees[s][0];
+			nodes.insert(nodes.end(), subtrees[s].begin() + 1, subtrees[s].end());
+		}
+	}
+
+	//Triângulos na ordem das folhas, para que cada folha leia memória contígua
+	const vector<uint32_t>& order = builder.order;
+	vector<uint32_t> sorted(nTriangles * 3);
+	for (size_t i = 0; i < nTriangles; i++)
+		for (int k = 0; k < 3; k++)
+			sorted[3 * i + k] = triangles[3 * order[i] + k];
+	triangles.swap(sorted);
+	original.swap(builder.order);
+}
+
+bool TriangleBVH::intersect(uint32_t slot, glm::vec3 origin, glm::vec3 direction, float& t) const
+{
+	//Möller-Trumbore, aceitando os dois lados do triângulo
+	glm::vec3 a = positions[triangles[3 * slot]];
+	glm::vec3 e1 = positions[triangles[3 * slot + 1]] - a;
+	glm::vec3 e2 = positions[triangles[3 * slot + 2]] - a;
+	glm::vec3 p = glm::cross(direction, e2);
+	float det = glm::dot(e1, p);
+	if (det == 0.0f)
+		return false;
+	float inverse = 1.0f / det;
+	glm::vec3 s = origin - a;
+	float u = glm::dot(s, p) * inverse;
+	if (u < 0.0f || u > 1.0f)
+		return false;
+	glm::vec3 q = glm::cross(s, e1);
+	float v = glm::dot(direction, q) * inverse;
+	if (v < 0.0f || u + v > 1.0f)
+		return false;
+	t = glm::dot(e2, q) * inverse;
+	return t >= 0.0f;
+}
+
+bool TriangleBVH::raycast(glm::vec3 origin, glm::vec3 direction, float& tMax, uint32_t& triangle) const
+{
+	if (nodes.empty())
+		return false;
+
+	glm::vec3 inverse = 1.0f / direction;
+	bool hit = false;
+	if (intersectBox(nodes[0].min, nodes[0].max, origin, inverse, tMax) == FLT_MAX)
+		return false;
+	vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+
+	while (!stack.empty())
+	{
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+		if (node.count > 0)
+		{
+			for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+			{
+				float t;
+				if (intersect(i, origin, direction, t) && t < tMax)
+				{
+					tMax = t;
+					triangle = original[i];
+					hit = true;
+				}
+			}
+			continue;
+		}
+
+		//Visita primeiro o filho mais próximo (empilhado por último)
+		uint32_t near = node.leftFirst, far = node.leftFirst + 1;
+		float dNear = intersectBox(nodes[near].min, nodes[near].max, origin, inverse, tMax);
+		float dFar = intersectBox(nodes[far].min, nodes[far].max, origin, inverse, tMax);
+		if (dFar < dNear)
+		{
+			std::swap(near, far);
+			std::swap(dNear, dFar);
+		}
+		if (dFar != FLT_MAX)
+			stack.push_back(far);
+		if (dNear != FLT_MAX)
+			stack.push_back(near);
+	}
+	return hit;
+}
+
+bool TriangleBVH::raycastBruteForce(glm::vec3 origin, glm::vec3 direction, float& tMax, uint32_t& triangle) const
+{
+	bool hit = false;
+	for (uint32_t i = 0; i < triangles.size() / 3; i++)
+	{
+		float t;
+		if (intersect(i, origin, direction, t) && t < tMax)
+		{
+			tMax = t;
+			triangle = original[i];
+			hit = true;
+		}
+	}
+	return hit;
+}
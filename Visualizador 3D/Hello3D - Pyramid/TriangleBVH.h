@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//GLM
+#include <glm/glm.hpp>
+
+// BVH estática sobre os triângulos de uma malha, montada uma vez na carga
+// (SAH com divisão em faixas). Serve para achar o triângulo exato atingido por
+// um raio, em coordenadas do modelo, sem testar a malha inteira
+class TriangleBVH
+{
+public:
+	// Copia as posições (3 primeiros floats de cada vértice, stride em bytes) e os
+	// índices (16 ou 32 bits) e monta a árvore. Em malhas grandes as subárvores são
+	// montadas em paralelo com nThreads (<= 0 usa todos os núcleos); a árvore não
+	// depende do número de threads
+	void build(const void* vertices, size_t vertexCount, size_t stride, const void* indices, size_t indexCount, bool shortIndices, int nThreads = 1);
+	bool empty() const { return nodes.empty(); }
+	size_t triangleCount() const { return triangles.size() / 3; }
+	size_t nodeCount() const { return nodes.size(); }
+
+	// Raio origin + t * direction (direction não precisa ser unitária). Se achar um
+	// triângulo com t em [0, tMax), atualiza tMax e triangle (na ordem do arquivo)
+	bool raycast(glm::vec3 origin, glm::vec3 direction, float& tMax, uint32_t& triangle) const;
+	// Mesma consulta testando todos os triângulos, para conferência
+	bool raycastBruteForce(glm::vec3 origin, glm::vec3 direction, float& tMax, uint32_t& triangle) const;
+
+private:
+	struct Node
+	{
+		glm::vec3 min;
+		uint32_t leftFirst; //filho esquerdo (o direito é o seguinte) ou primeiro triângulo
+		glm::vec3 max;
+		uint32_t count;     //triângulos da folha; 0 para nós internos
+	};
+
+	struct Builder;
+
+	bool intersect(uint32_t slot, glm::vec3 origin, glm::vec3 direction, float& t) const;
+
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> triangles; //3 índices por triângulo, na ordem das folhas
+	std::vector<uint32_t> original;  //índice original de cada triângulo reordenado
+	std::vector<Node> nodes;
+};
@@ -0,0 +1,132 @@
+#include "UploadRing.h"
+#include "Profiler.h"
+
+#include <chrono>
+
+using namespace std;
+
+UploadRing::~UploadRing()
+{
+	for (int i = 0; i < REGIONS; i++)
+		if (fences[i] != 0)
+			glDeleteSync(fences[i]);
+	if (buffer != 0)
+	{
+		//glDeleteBuffers também desfaz o mapeamento persistente
+		glDeleteBuffers(1, &buffer);
+	}
+}
+
+void UploadRing::initialize(size_t regionBytes)
+{
+	this->regionBytes = regionBytes;
+	size_t size = regionBytes * REGIONS;
+	glGenBuffers(1, &buffer);
+	//GL_COPY_READ_BUFFER: o anel é sempre a origem das cópias e não mexe no estado dos VAOs
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	persistent = glExtensions.bufferStorage;
+	if (persistent)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_READ_BUFFER, size, nullptr, flags);
+		mapped = (char*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, size, flags);
+		persistent = mapped != nullptr;
+		if (!persistent)
+		{
+			//O armazenamento de glBufferStorage é imutável: o buffer comum precisa ser outro
+			glDeleteBuffers(1, &buffer);
+			glGenBuffers(1, &buffer);
+			glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		}
+	}
+	if (!persistent)
+		glBufferData(GL_COPY_READ_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+void UploadRing::beginFrame()
+{
+	if (buffer == 0)
+		return;
+
+	//Comandos do quadro que termina (inclusive as cópias a partir da região) ficam antes da fence
+	if (fences[region] == 0)
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	total.bytes += current.bytes;
+	total.stallMs += current.stallMs;
+	total.stalls += current.stalls;
+	total.rejected += current.rejected;
+	last = current;
+	current = UploadStats();
+
+	region = (region + 1) % REGIONS;
+	used = 0;
+	if (fences[region] == 0)
+		return;
+
+	//Normalmente a GPU já passou da fence e a consulta volta na hora
+	GLenum status = glClientWaitSync(fences[region], 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		PROFILE_ZONE("upload ring stall");
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		current.stalls++;
+		//O flush garante que a fence chega à GPU; esperas de 1 ms até ela ser sinalizada
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		do
+		{
+			status = glClientWaitSync(fences[region], flags, 1000000);
+			flags = 0;
+		} while (status == GL_TIMEOUT_EXPIRED);
+		current.stallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	}
+	glDeleteSync(fences[region]);
+	fences[region] = 0;
+}
+
+size_t UploadRing::available(size_t alignment) const
+{
+	size_t start = (used + alignment - 1) / alignment * alignment;
+	return buffer != 0 && start < regionBytes ? regionBytes - start : 0;
+}
+
+bool UploadRing::reserve(size_t size, size_t alignment, Allocation& allocation)
+{
+	if (size == 0 || size > available(alignment))
+		return false;
+	used = (used + alignment - 1) / alignment * alignment;
+	allocation.buffer = buffer;
+	allocation.offset = (GLintptr)(region * regionBytes + used);
+	allocation.size = size;
+	used += size;
+	current.bytes += size;
+
+	if (persistent)
+	{
+		allocation.data = mapped + allocation.offset;
+		return true;
+	}
+	//A fence da região já garante que a GPU não está lendo este trecho
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	allocation.data = glMapBufferRange(GL_COPY_READ_BUFFER, allocation.offset, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	return allocation.data != nullptr;
+}
+
+void UploadRing::commit(const Allocation& allocation)
+{
+	if (persistent)
+		return;
+	glBindBuffer(GL_COPY_READ_BUFFER, allocation.buffer);
+	glUnmapBuffer(GL_COPY_READ_BUFFER);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+void UploadRing::copy(const Allocation& allocation, GLuint destination, GLintptr destinationOffset)
+{
+	glBindBuffer(GL_COPY_READ_BUFFER, allocation.buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, destination);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, allocation.offset, destinationOffset, allocation.size);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "GLExtensions.h"
+
+// Envios de um quadro (ou acumulados)
+struct UploadStats
+{
+	size_t bytes = 0;     //bytes escritos no anel
+	double stallMs = 0.0; //tempo esperando a GPU liberar a região do quadro
+	int stalls = 0;       //esperas que não terminaram de imediato
+	size_t rejected = 0;  //bytes que não couberam na região e foram pelo caminho sem anel
+};
+
+// Anel de envio para a GPU: um buffer mapeado uma única vez (glBufferStorage com
+// GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT) e dividido em REGIONS regiões, uma por
+// quadro, usadas em rodízio. A CPU escreve na região do quadro e os dados seguem para o
+// destino final com glCopyBufferSubData, na própria GPU. Cada região é protegida por uma
+// fence colocada quando o quadro termina; ela só é reescrita depois que a GPU passou da
+// fence, o que normalmente já aconteceu (REGIONS - 1 quadros depois) e não custa espera.
+// Assim nem a escrita nem a cópia passam pelas sincronizações implícitas de
+// glBufferSubData/glMapBufferRange em buffers que a GPU ainda está lendo.
+// Sem glBufferStorage (contextos abaixo da 4.4) o anel é um buffer comum mapeado a cada
+// reserva com GL_MAP_UNSYNCHRONIZED_BIT; as fences continuam garantindo a ordem
+class UploadRing
+{
+public:
+	static const int REGIONS = 3;
+
+	// Trecho reservado na região do quadro: a CPU escreve em data; na GPU ele está em buffer/offset
+	struct Allocation
+	{
+		void* data = nullptr;
+		GLuint buffer = 0;
+		GLintptr offset = 0;
+		size_t size = 0;
+	};
+
+	UploadRing() {}
+	~UploadRing();
+	UploadRing(const UploadRing&) = delete;
+	UploadRing& operator=(const UploadRing&) = delete;
+
+	// regionBytes é o máximo enviado por quadro; o buffer tem REGIONS vezes esse tamanho
+	void initialize(size_t regionBytes);
+	bool isInitialized() const { return buffer != 0; }
+	bool isPersistent() const { return persistent; }
+
+	// Começa um quadro: fecha a região anterior com uma fence e espera (se preciso) a GPU
+	// liberar a próxima. Chamado uma vez por quadro, antes de qualquer reserva
+	void beginFrame();
+
+	// Bytes que ainda cabem na região do quadro com o alinhamento pedido
+	size_t available(size_t alignment) const;
+
+	// Reserva size bytes alinhados na região do quadro; false se não couberem
+	bool reserve(size_t size, size_t alignment, Allocation& allocation);
+	// Encerra a escrita de uma reserva (no anel sem armazenamento persistente, desmapeia o trecho)
+	void commit(const Allocation& allocation);
+	// Agenda a cópia, na GPU, de uma reserva já escrita para destination a partir de destinationOffset
+	void copy(const Allocation& allocation, GLuint destination, GLintptr destinationOffset);
+
+	const UploadStats& frameStats() const { return current; } //quadro em andamento
+	const UploadStats& lastFrameStats() const { return last; }
+	const UploadStats& totalStats() const { return total; }
+	// Conta bytes enviados fora do anel por falta de espaço
+	void reject(size_t size) { current.rejected += size; }
+
+private:
+	GLuint buffer = 0;
+	char* mapped = nullptr; //início do buffer inteiro (só com armazenamento persistente)
+	bool persistent = false;
+	size_t regionBytes = 0;
+	int region = 0;
+	size_t used = 0; //bytes já reservados na região do quadro
+	GLsync fences[REGIONS] = {};
+	UploadStats current, last, total;
+};
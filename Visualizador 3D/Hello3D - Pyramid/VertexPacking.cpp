@@ -0,0 +1,104 @@
+#include "VertexPacking.h"
+#include "Profiler.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include <glm/gtc/packing.hpp>
+
+using namespace std;
+
+namespace
+{
+	uint16_t quantizeUnorm16(float value)
+	{
+		return (uint16_t)floor(glm::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+	}
+
+	int16_t quantizeSnorm16(float value)
+	{
+		return (int16_t)floor(glm::clamp(value, -1.0f, 1.0f) * 32767.0f + 0.5f);
+	}
+}
+
+glm::vec2 encodeOctahedral(glm::vec3 normal)
+{
+	float sum = fabs(normal.x) + fabs(normal.y) + fabs(normal.z);
+	if (sum == 0.0f)
+		return glm::vec2(0.0f);
+	normal /= sum;
+	if (normal.z >= 0.0f)
+		return glm::vec2(normal.x, normal.y);
+	//Hemisfério de baixo: cada ponto vai para o canto do quadrado do seu quadrante
+	return glm::vec2((1.0f - fabs(normal.y)) * (normal.x >= 0.0f ? 1.0f : -1.0f),
+		(1.0f - fabs(normal.x)) * (normal.y >= 0.0f ? 1.0f : -1.0f));
+}
+
+glm::vec3 decodeOctahedral(glm::vec2 encoded)
+{
+	glm::vec3 normal(encoded.x, encoded.y, 1.0f - fabs(encoded.x) - fabs(encoded.y));
+	float fold = max(-normal.z, 0.0f);
+	normal.x += normal.x >= 0.0f ? -fold : fold;
+	normal.y += normal.y >= 0.0f ? -fold : fold;
+	return glm::normalize(normal);
+}
+
+void packVertices(const MeshData& mesh, vector<PackedVertex>& packed, glm::vec3& offset, glm::vec3& scale)
+{
+	PROFILE_ZONE("packVertices");
+	size_t count = mesh.vertexCount();
+	glm::vec3 low(0.0f), high(0.0f);
+	for (size_t v = 0; v < count; v++)
+	{
+		const float* p = &mesh.vertices[v * OBJ_FLOATS_PER_VERTEX];
+		low = v == 0 ? glm::vec3(p[0], p[1], p[2]) : glm::min(low, glm::vec3(p[0], p[1], p[2]));
+		high = v == 0 ? glm::vec3(p[0], p[1], p[2]) : glm::max(high, glm::vec3(p[0], p[1], p[2]));
+	}
+	//Eixo sem espessura (malha plana) ainda precisa de uma escala válida
+	offset = low;
+	scale = glm::max(high - low, glm::vec3(1e-20f));
+
+	packed.resize(count);
+	for (size_t v = 0; v < count; v++)
+	{
+		const float* p = &mesh.vertices[v * OBJ_FLOATS_PER_VERTEX];
+		PackedVertex& out = packed[v];
+		glm::vec3 position = (glm::vec3(p[0], p[1], p[2]) - offset) / scale;
+		out.position[0] = quantizeUnorm16(position.x);
+		out.position[1] = quantizeUnorm16(position.y);
+		out.position[2] = quantizeUnorm16(position.z);
+		out.position[3] = 0;
+		glm::vec2 normal = encodeOctahedral(glm::vec3(p[8], p[9], p[10]));
+		out.normal[0] = quantizeSnorm16(normal.x);
+		out.normal[1] = quantizeSnorm16(normal.y);
+		out.texc[0] = glm::packHalf1x16(p[6]);
+		out.texc[1] = glm::packHalf1x16(p[7]);
+	}
+}
+
+void unpackPositions(const MeshBuffers& buffers, vector<glm::vec3>& positions)
+{
+	const PackedVertex* packed = (const PackedVertex*)buffers.vertices;
+	positions.resize(buffers.vertexCount);
+	for (uint32_t v = 0; v < buffers.vertexCount; v++)
+	{
+		glm::vec3 q(packed[v].position[0], packed[v].position[1], packed[v].position[2]);
+		positions[v] = buffers.positionOffset + buffers.positionScale * (q / 65535.0f);
+	}
+}
+
+void buildPackedMeshBuffers(const MeshData& mesh, vector<uint16_t>& shortIndices, vector<PackedVertex>& packed, MeshBuffers& buffers)
+{
+	//Índices como no layout em floats; só os vértices e os atributos mudam
+	buildMeshBuffers(mesh, shortIndices, buffers);
+	packVertices(mesh, packed, buffers.positionOffset, buffers.positionScale);
+	buffers.vertices = packed.data();
+	buffers.vertexBytes = packed.size() * sizeof(PackedVertex);
+	buffers.stride = sizeof(PackedVertex);
+	buffers.packed = true;
+	buffers.attributes = {
+		{ 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0 },
+		{ 2, 2, GL_HALF_FLOAT, GL_FALSE, 12 },
+		{ 3, 2, GL_SHORT, GL_TRUE, 8 }
+	};
+}
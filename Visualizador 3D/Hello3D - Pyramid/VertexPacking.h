@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "ObjLoader.h"
+#include "MeshCache.h"
+
+// Vértice compactado: 16 bytes no lugar dos 44 do layout de 11 floats do loader.
+//   position: 3 x 16 bits sem sinal normalizados, relativos à caixa envolvente da malha
+//             (o quarto valor só alinha o atributo)
+//   normal:   octaédrica, 2 x 16 bits com sinal normalizados
+//   texc:     2 meias-precisões (GL_HALF_FLOAT)
+// A cor por vértice fica de fora: os shaders usam a cor da Mesh. Os atributos ocupam as
+// mesmas localizações do layout em floats; com o uniform octahedralNormals os shaders
+// decodificam a normal, e a caixa da quantização entra na matriz de modelo (Geometry)
+struct PackedVertex
+{
+	uint16_t position[4];
+	int16_t normal[2];
+	uint16_t texc[2];
+};
+
+// Normal unitária para o octaedro |x| + |y| + |z| = 1, com o hemisfério de baixo dobrado
+// sobre os cantos; o resultado fica em [-1, 1]^2
+glm::vec2 encodeOctahedral(glm::vec3 normal);
+// Inverso de encodeOctahedral; mesmo cálculo do shader
+glm::vec3 decodeOctahedral(glm::vec2 encoded);
+
+// Compacta os vértices da malha. offset e scale recebem a caixa usada na quantização:
+// a posição decodificada é offset + scale * (position / 65535)
+void packVertices(const MeshData& mesh, std::vector<PackedVertex>& packed, glm::vec3& offset, glm::vec3& scale);
+
+// Posições decodificadas, como o shader as vê, para a caixa envolvente e a BVH de triângulos
+void unpackPositions(const MeshBuffers& buffers, std::vector<glm::vec3>& positions);
+
+// Como buildMeshBuffers, mas com os vértices compactados em packed
+void buildPackedMeshBuffers(const MeshData& mesh, std::vector<uint16_t>& shortIndices, std::vector<PackedVertex>& packed, MeshBuffers& buffers);